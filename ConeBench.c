@@ -0,0 +1,131 @@
+/*
+  ConeBench.c
+  --------
+  Compare the single-ray and cone beam models for map updates. Scans are
+  recorded once along a fixed route, then replayed into a fresh map with
+  each model, so both see exactly the same data.
+
+  On the ActivityBot the figures are map cell counts and CNT cycles per
+  beam. On the host (built against sim/) the map is also scored against
+  the simulated world, and times are nanoseconds.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "odometry.h"                         // Fixed-point dead reckoning
+
+#define REPLAYS   10                          // Replays per model, for timing
+
+// --- Route: turn (degrees), then move (mm), then scan
+int route[][2] = {
+  {0, 0}, {0, 500}, {90, 0}, {0, 600}, {-90, 0}, {0, 500}, {-90, 300},
+  {-90, 0}, {0, 800}, {-90, 0}, {0, 500}, {-135, 0}, {0, 400}, {90, 0}
+};
+#define STOPS  ((int)(sizeof(route) / sizeof(*route)))
+
+// --- Recorded scans
+typedef struct {
+  int x, y;                                   // odomX, odomY
+  unsigned int theta;                         // odomTheta
+  short cm[SCAN_MAX];
+} scanRecord;
+
+scanRecord rec[STOPS];
+
+void replay()
+{
+  // Build a fresh map from the recorded scans
+  mapClear();
+  for (int s = 0; s < STOPS; s++) {
+    odomX = rec[s].x;
+    odomY = rec[s].y;
+    odomTheta = rec[s].theta;
+    for (int i = 0; i < numAngles; i++)
+      scan_cm[i] = rec[s].cm[i];
+    mapScan();
+  }
+}
+
+void score(char *name, unsigned int t)
+{
+  int occupied = 0, free = 0;
+  int beams = STOPS * numAngles;
+
+  for (int cy = 0; cy < MAP_SIZE; cy++) {
+    for (int cx = 0; cx < MAP_SIZE; cx++) {
+      int l = mapCell(cx, cy);
+      if (l >= 2) occupied++;
+      if (l <= -2) free++;
+    }
+  }
+  print("%-6s %5d %s/beam  %4d occupied  %5d free", name, t / beams, BENCH_UNITS, occupied, free);
+
+#ifdef SIM_CLKFREQ
+  // Score against the simulated world. A wall cell has a wall through it;
+  // an occupied cell more than a cell from any wall is a ghost.
+  int walls = 0, found = 0, ghosts = 0, erased = 0;
+  for (int cy = 0; cy < MAP_SIZE; cy++) {
+    for (int cx = 0; cx < MAP_SIZE; cx++) {
+      double x = (cx - MAP_SIZE/2) * MAP_CELL + MAP_CELL/2;
+      double y = (cy - MAP_SIZE/2) * MAP_CELL + MAP_CELL/2;
+      double d = sim_clearance(x, y);
+      int l = mapCell(cx, cy);
+      if (d < MAP_CELL * 0.71) {
+        walls++;
+        if (l >= 2) found++;
+        if (l <= -2) erased++;
+      } else if (d > MAP_CELL * 1.5 && l >= 2) {
+        ghosts++;
+      }
+    }
+  }
+  print("  walls found %d%%  ghosts %d  walls erased %d", 100 * found / walls, ghosts, erased);
+#endif
+  print("%c\n", CLREOL);
+}
+
+int main()
+{
+  unsigned int t;
+
+  // Record the scans
+  botSetMaxSpeed(200);
+  for (int s = 0; s < STOPS; s++) {
+    if (route[s][0]) botTurn(route[s][0] * M_PI / 180.0);
+    updatePose();
+    if (route[s][1]) botMove(route[s][1]);
+    updatePose();
+    pingScan();
+    rec[s].x = odomX;
+    rec[s].y = odomY;
+    rec[s].theta = odomTheta;
+    for (int i = 0; i < numAngles; i++)
+      rec[s].cm[i] = scan_cm[i];
+  }
+  print("ConeBench: %d scans of %d beams%c\n", STOPS, numAngles, CLREOL);
+
+  // Replay them through each model
+  mapSetModel(MAP_MODEL_RAY);
+  t = benchNow();
+  for (int k = 0; k < REPLAYS; k++)
+    replay();
+  score("ray", (benchNow() - t) / REPLAYS);
+
+  mapSetModel(MAP_MODEL_CONE);
+  t = benchNow();
+  for (int k = 0; k < REPLAYS; k++)
+    replay();
+  score("cone", (benchNow() - t) / REPLAYS);
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+  DstarBench.c
+  --------
+  Drive to a few goals along D* Lite paths (dstar.c) through a map that
+  starts out empty and fills in from the PING))) as the bot goes. Every
+  control tick each beam that lands goes into the map, dsReplan() repairs
+  the plan around whatever changed, and goTowardPose() drives at the
+  waypoint dsNext() gives. Reports, for each goal, how long it took, how
+  many repairs there were and what they cost, against planning from
+  scratch over the map as it ended up.
+
+  On the host (built against sim/) each goal starts from the same spot,
+  west of the two boxes, and also reports the closest the bot came to a
+  wall and any collisions. On the ActivityBot the goals are relative to
+  wherever it starts; give it room.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "field.h"                            // Likelihood field
+#include "dstar.h"                            // D* Lite path planning
+
+#define TICK_MS     50                        // Control tick
+#define GIVE_UP_MS  60000                     // Per goal
+#define CLOSE_MM    50                        // Goal reached
+
+// --- Goals (mm, world frame), each from (0, -150) facing +x
+float goals[][2] = {
+  {1500, -150}, {1700, 900}, {1800, 200}, {600, 900}
+};
+#define GOALS  ((int)(sizeof(goals) / sizeof(*goals)))
+
+scanPattern sweep;
+
+int main()
+{
+  scanPatternRange(&sweep, -90, 90, 15);
+  pingScanPattern(&sweep);
+  print("DstarBench: %d goals, %d x %d cells of %d mm, %d beams per sweep, %d ms ticks%c\n",
+        GOALS, DS_SIZE, DS_SIZE, LF_CELL, numAngles, TICK_MS, CLREOL);
+
+  for (int g = 0; g < GOALS; g++) {
+    int ms = 0, hit = 0, repairs = 0, expanded = 0, changed = 0, none = 0;
+    unsigned int t, tRepair = 0, tMax = 0, tFirst, tFull;
+    float d, nearest = 10000, way[2], pose[3];
+#ifdef SIM_CLKFREQ
+    int bumps = sim_collisions();
+    sim_setPose(0, -150, 0);
+#endif
+    setPose(0, -150, 0);
+    for (int i = 0; i < numAngles; i++)
+      scan_cm[i] = 0;
+    mapClear();
+    t = benchNow();
+    dsSetGoal(goals[g]);
+    tFirst = benchNow() - t;
+    pingScanStart();
+    do {
+      int i;
+      updatePose();
+      i = pingScanPoll();
+      if (i >= 0) mapBeam(i);
+      if (pingScanComplete()) pingScanStart();
+
+      t = benchNow();
+      if (dsReplan()) {
+        t = benchNow() - t;
+        repairs++;
+        tRepair += t;
+        if (t > tMax) tMax = t;
+        expanded += dsExpanded;
+        changed += dsChanged;
+      }
+      if (dsNext(way)) {
+        pose[0] = way[0];
+        pose[1] = way[1];
+        pose[2] = botP[2];
+        goTowardPose(pose);
+      } else {
+        botSetVW(0, 0);
+        none++;
+      }
+#ifdef SIM_CLKFREQ
+      double truth[3];
+      sim_getPose(truth);
+      double c = sim_clearance(truth[0], truth[1]);
+      if (c < nearest) nearest = c;
+#endif
+      pause(TICK_MS);
+      ms += TICK_MS;
+      d = sqrt(pow(goals[g][0] - botP[0], 2.0) + pow(goals[g][1] - botP[1], 2.0));
+      hit = d < CLOSE_MM;
+    } while (!hit && ms < GIVE_UP_MS);
+    botSetVW(0, 0);
+    while (!pingScanComplete())
+      pingScanPoll();
+
+    // The same plan from scratch, over the map as it ended up, from the start
+    setPose(0, -150, 0);
+    t = benchNow();
+    dsSetGoal(goals[g]);
+    tFull = benchNow() - t;
+
+    print("goal (%5d,%5d)  %s in %5d ms  %4d mm off  %d ticks without a path",
+          (int)goals[g][0], (int)goals[g][1], hit ? "reached" : "missed ", ms, (int)d, none);
+#ifdef SIM_CLKFREQ
+    print("  nearest wall %4d mm  %d collisions", (int)nearest, sim_collisions() - bumps);
+#endif
+    print("%c\n", CLREOL);
+    print("  first plan %d %s;  %d repairs, %d cells changed and %d expanded each, %d %s each, %d most;"
+          "  from scratch %d expanded, %d %s%c\n",
+          tFirst, BENCH_UNITS, repairs, repairs ? changed / repairs : 0,
+          repairs ? expanded / repairs : 0, repairs ? tRepair / repairs : 0, BENCH_UNITS, tMax,
+          dsExpanded, tFull, BENCH_UNITS, CLREOL);
+  }
+  dsBudget();
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+  EkfBench.c
+  --------
+  Dead reckoning against the extended Kalman filter in ekf.c. The bot
+  drives twice round a square in a 10 Hz loop like GoToGoal.c's, with the
+  sensor cog taking readings. Each pass through the loop runs ekfUpdate()
+  on the encoder ticks and ekfSense() on the latest PING))) ranges, which
+  are matched against the walls of the default simulated room.
+
+  On the ActivityBot the figures are CNT cycles per step, against the
+  8,000,000 in a 10 Hz period. On the host (built against sim/) times are
+  nanoseconds, and both poses are scored against the truth. Run with some
+  wheel error to see drift:
+    SIM_SLIP=0.03 SIM_SECONDS=600 ./EkfBench
+  The route takes about 70 simulated seconds, so SIM_SECONDS has to be
+  raised from the sim's default 60 even with no slip, or the bench stops
+  before it reports anything. With no slip odometry is exact and the
+  filter can only add the ranges' centimetre steps; ekf.c has how it
+  does over 36 slipping seeds, and where it fails.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "ekf.h"                              // Extended Kalman filter
+
+// --- Walls (mm): the room and the two boxes of the default sim world
+int wallList[][4] = {
+  {-400, -600, 2000, -600}, {2000, -600, 2000, 1200}, {2000, 1200, -400, 1200}, {-400, 1200, -400, -600},
+  {900, -250, 1100, -250}, {1100, -250, 1100, -50}, {1100, -50, 900, -50}, {900, -50, 900, -250},
+  {1300, 500, 1500, 650}, {1500, 650, 1350, 850}, {1350, 850, 1200, 700}, {1200, 700, 1300, 500}
+};
+#define WALLS  ((int)(sizeof(wallList) / sizeof(*wallList)))
+
+// --- Route: wheel speeds (ticks/s) for a number of 10 Hz cycles. A
+// --- 700 mm side at 104 mm/s, then a quarter turn in place.
+int route[][3] = {
+  {32, 32, 67}, {-16, 16, 16}, {32, 32, 67}, {-16, 16, 16},
+  {32, 32, 67}, {-16, 16, 16}, {32, 32, 67}, {-16, 16, 16}
+};
+#define LEGS   ((int)(sizeof(route) / sizeof(*route)))
+
+float error(float *p, double *q)
+{
+  return sqrt((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]));
+}
+
+int main()
+{
+  unsigned int tPredict = 0, tSense = 0, t;
+  int cycles = 0, used = 0;
+  float odomSum = 0, ekfSum = 0, odomLast = 0, ekfLast = 0;
+  float pose[3];
+  double truth[3] = {0, 0, 0};
+
+  for (int i = 0; i < WALLS; i++)
+    ekfAddWall(wallList[i][0], wallList[i][1], wallList[i][2], wallList[i][3]);
+  setPose(0, 0, 0);
+  ekfInit(0, 0, 0, 20, 0.02);
+  sensorSetRate(10);
+  startSensor();
+
+  for (int lap = 0; lap < 2; lap++) {
+    for (int leg = 0; leg < LEGS; leg++) {
+      drive_speed(route[leg][0], route[leg][1]);
+      for (int k = 0; k < route[leg][2]; k++) {
+        pause(100);
+        t = benchNow();
+        ekfUpdate();
+        tPredict += benchNow() - t;
+        t = benchNow();
+        used += ekfSense();
+        tSense += benchNow() - t;
+        cycles++;
+
+#ifdef SIM_CLKFREQ
+        sim_getPose(truth);
+#endif
+        ekfPose(pose);
+        odomLast = error(botP, truth);
+        ekfLast = error(pose, truth);
+        odomSum += odomLast;
+        ekfSum += ekfLast;
+      }
+    }
+  }
+  drive_speed(0, 0);
+  stopSensor();
+
+  print("EkfBench: %d cycles, %d ranges used%c\n", cycles, used, CLREOL);
+#ifdef SIM_CLKFREQ
+  print("odometry  mean error %4d mm  final %4d mm%c\n", (int)(odomSum / cycles), (int)odomLast, CLREOL);
+  print("ekf       mean error %4d mm  final %4d mm%c\n", (int)(ekfSum / cycles), (int)ekfLast, CLREOL);
+#endif
+  print("wheel scales (estimated): right - left %f%%, mean %f%%%c\n",
+        fx_toFloat(ekfSlip) * 100 / 64, fx_toFloat(ekfScale) * 100 / 64, CLREOL);
+  print("per cycle: update %d %s, sense %d %s%c\n",
+        tPredict / cycles, BENCH_UNITS, tSense / cycles, BENCH_UNITS, CLREOL);
+  ekfBudget();
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+  FieldBench.c
+  --------
+  Cost of scoring a scan against the map by ray casting and by likelihood
+  field lookup, and of keeping the field up to date. The bot drives a
+  square, mapping at each stop and updating the field incrementally. At
+  each stop the scan is then scored at every pose of a grid around the
+  bot's own with both methods.
+
+  On the ActivityBot the figures are CNT cycles. On the host (built
+  against sim/) times are nanoseconds, the map is built from the true
+  poses, and the best pose each method finds is scored against the truth.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "field.h"                            // Likelihood field
+#include "mcl.h"                              // Monte Carlo localization
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+// --- Route: turn (degrees), then move (mm), then scan
+int route[][2] = {
+  {0, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}
+};
+#define STOPS  ((int)(sizeof(route) / sizeof(*route)))
+
+// --- Search grid around each pose: +-GRID_XY steps of 32 mm, +-GRID_TH
+// --- steps of 2 degrees
+#define GRID_XY  6
+#define GRID_TH  3
+#define POSES    ((2*GRID_XY + 1) * (2*GRID_XY + 1) * (2*GRID_TH + 1))
+
+typedef struct {
+  unsigned int time;                          // Total, all stops
+  float error;                                // Sum of best pose errors (mm)
+} result;
+
+result search(int model, int x, int y, unsigned int theta, double *truth)
+{
+  // Score the scan at every pose of the grid and return the time taken
+  // and how far the best one is from the truth
+  result r = {0, 0};
+  int best = 0x7FFFFFFF, bx = 0, by = 0;
+  unsigned int t;
+
+  mclSetModel(model);
+  t = benchNow();
+  for (int i = -GRID_XY; i <= GRID_XY; i++) {
+    for (int j = -GRID_XY; j <= GRID_XY; j++) {
+      for (int k = -GRID_TH; k <= GRID_TH; k++) {
+        int px = x + fx_fromInt(32 * i);
+        int py = y + fx_fromInt(32 * j);
+        int pen = mclScore(px, py, theta + 2 * k * BAM_PER_DEG);
+        if (pen < best) {
+          best = pen;
+          bx = px;
+          by = py;
+        }
+      }
+    }
+  }
+  r.time = benchNow() - t;
+#ifdef SIM_CLKFREQ
+  r.error = sqrt((fx_toFloat(bx) - truth[0]) * (fx_toFloat(bx) - truth[0]) +
+                 (fx_toFloat(by) - truth[1]) * (fx_toFloat(by) - truth[1]));
+#endif
+  return r;
+}
+
+int main()
+{
+  unsigned int t, incr = 0, cells = 0, full;
+  result ray = {0, 0}, field = {0, 0};
+  double truth[3] = {0, 0, 0};
+
+  botSetMaxSpeed(200);
+  mapClear();
+  lfBuild();
+  for (int s = 0; s < STOPS; s++) {
+    if (route[s][0]) botTurn(route[s][0] * M_PI / 180.0);
+    updatePose();
+    if (route[s][1]) botMove(route[s][1]);
+    updatePose();
+    pingScan();
+
+    // Score the scan against the map so far from around the pose
+    int x = odomX, y = odomY;
+    unsigned int theta = odomTheta;
+#ifdef SIM_CLKFREQ
+    sim_getPose(truth);
+    x = truth[0] * 65536.0;
+    y = truth[1] * 65536.0;
+    theta = bam_fromRadians(truth[2]);
+#endif
+    if (s > 0) {
+      result r = search(MCL_MODEL_RAY, x, y, theta, truth);
+      ray.time += r.time;
+      ray.error += r.error;
+      r = search(MCL_MODEL_FIELD, x, y, theta, truth);
+      field.time += r.time;
+      field.error += r.error;
+    }
+
+    // Then add it to the map and bring the field up to date
+    odomX = x;
+    odomY = y;
+    odomTheta = theta;
+    mapScan();
+    t = benchNow();
+    lfUpdate();
+    incr += benchNow() - t;
+    cells += lfUpdated;
+  }
+
+  t = benchNow();
+  lfBuild();
+  full = benchNow() - t;
+
+  print("FieldBench: %d stops, %d beams per scan, %d poses per search%c\n",
+        STOPS, numAngles, POSES, CLREOL);
+  print("full rebuild     %8d %s, %d cells%c\n", full, BENCH_UNITS, LF_SIZE * LF_SIZE, CLREOL);
+  print("update per stop  %8d %s, %d cells%c\n", incr / STOPS, BENCH_UNITS, cells / STOPS, CLREOL);
+  print("ray cast         %8d %s per scan", ray.time / (POSES * (STOPS - 1)), BENCH_UNITS);
+#ifdef SIM_CLKFREQ
+  print("  best pose off by %d mm", (int)(ray.error / (STOPS - 1)));
+#endif
+  print("%c\n", CLREOL);
+  print("field lookup     %8d %s per scan", field.time / (POSES * (STOPS - 1)), BENCH_UNITS);
+#ifdef SIM_CLKFREQ
+  print("  best pose off by %d mm", (int)(field.error / (STOPS - 1)));
+#endif
+  print("%c\n", CLREOL);
+  lfBudget();
+  return 0;
+}
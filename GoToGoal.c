@@ -2,7 +2,7 @@
   GoToGoal.c
 
   Starting at (0,0,0) go to a specified (gx,gy,gtheta) using the pid_theta and
-  gotoVW functions in movement.c
+  gotoVW functions in movement.c, stepped by sched.c
 
   ------------------------------------------------------------------------------
   Copyright 2015 Robert B. Hawkins
@@ -17,24 +17,69 @@
 #include "sensors.h"                          // Manage sensors in use on the ActivityBot
 #include "movement.h"                         // Move the ActivityBot around
 #include "transforms.h"                       // Coordinate frame transforms
+#include "sched.h"                            // Fixed-rate task scheduler
 
 #define round(x) ((x)>=0?(int)((x)+0.5):(int)((x)-0.5))
 
+float goalW[] = {500.0, 400.0};     // Goal in world coordinate frame (gx,gy)
+float goalB[2];                     // Goal in Bot coordinate frame
+float goalD = 1e9;                  // Distance to goal, mm
+
+float velocity;                     // Bot velocity in mm/s
+float omega;                        // Bot angular rotation in 1/s
+
+int cycle = 0;
+
+// --- The loop's steps, each run at its own rate by sched.c
+void estimate()
+{
+  // update current pose in world coordinate frame
+  updatePose();
+  goalD = sqrt(pow(goalW[0]-botP[0],2.0) + pow(goalW[1]-botP[1],2.0));
+
+  // calculate pose of goal in bot coordinate frame
+  float pose[] = {botP[0], botP[1], botTheta};
+  aTb_inv(goalW, goalB, pose);
+}
+
+void act()
+{
+  if (goalD <= 10.0) {
+    schQuit();
+    return;
+  }
+
+  // calculate omega
+  omega = pid_omega(goalB);
+
+  // calculate maximum velocity for this omega
+  velocity = goalD<200.0 ? goalD : 200.0;
+  velocity = velocity<33.0 ? 33.0 : velocity;
+
+  // set velocity and omega
+  botSetVW(velocity, omega);
+  cycle += 1;
+}
+
+void show()
+{
+  print("%c", HOME);
+  print("Cycle: %d%c\n", cycle, CLREOL);
+  print("bot at (%f,%f), theta: %f %c\n", botP[0], botP[1], botTheta, CLREOL);
+  print("goal(W) at (%f,%f), theta: %f %c\n", goalW[0], goalW[1], atan2(goalW[1],goalW[0]), CLREOL);
+  print("goal(B) at (%f,%f), theta: %f %c\n", goalB[0], goalB[1], atan2(goalB[1],goalB[0]), CLREOL);
+  print("omega = %f%c\n", omega, CLREOL);
+  print("velocity = %f%c\n", velocity, CLREOL);
+  print("goalD =%f%c\n", goalD, CLREOL);
+  schReport();
+}
+
 int main()                                    // Main function
 {
   botP[0] = 0.0;     // Bot position and orientation in world coordinate frame (x,y)
   botP[1] = 0.0;
   botTheta = 0.0;
 
-  float goalW[] = {500.0, 400.0};   // Goal in world coordinate frame (gx,gy)
-  float goalB[2];                   // Goal in Bot coordinate frame
-  float goalD = sqrt(pow(goalW[0]-botP[0],2.0) + pow(goalW[1]-botP[1],2.0));
-
-  float velocity;                   // Bot velocity in mm/s
-  float omega;                      // Bot angular rotation in 1/s
-
-  int cycle = 0;
-
   // Send out startup announcement
   freqout(4, 500, 3000);                      // Speaker tone: 0.5 s @ 3 kHz, 0.25 s @ 3.5 kHz
   freqout(4, 250, 3500);
@@ -43,40 +88,12 @@ int main()                                    // Main function
   botSetMaxSpeed(128);
   botSetRampRate(12);
   pingAngle(0);
- 
-  while(goalD > 10.0)
-  {
-    print("%c", HOME);
-    print("Cycle: %d%c\n", cycle, CLREOL);
-
-    // update current pose in world coordinate frame
-    updatePose();
-    goalD = sqrt(pow(goalW[0]-botP[0],2.0) + pow(goalW[1]-botP[1],2.0));
-    print("bot at (%f,%f), theta: %f %c\n", botP[0], botP[1], botTheta, CLREOL);
-
-    // calculate pose of goal in bot coordinate frame
-    aTb_inv(goalW, goalB, botP[0], botP[1], botTheta);
-    print("goal(W) at (%f,%f), theta: %f %c\n", goalW[0], goalW[1], atan2(goalW[1],goalW[0]), CLREOL);
-    print("goal(B) at (%f,%f), theta: %f %c\n", goalB[0], goalB[1], atan2(goalB[1],goalB[0]), CLREOL);
-
-    // calculate omega
-    omega = pid_omega(goalB);
-    print("omega = %f%c\n", omega, CLREOL);
-
-    // calculate maximum velocity for this omega
-    velocity = goalD<200.0 ? goalD : 200.0;
-    velocity = velocity<33.0 ? 33.0 : velocity;
-    print("velocity = %f%c\n", velocity, CLREOL);
-
-    // set velocity and omega
-    botSetVW(velocity, omega);
-
-    print("goalD =%f%c\n", goalD, CLREOL);
-    print("Pausing...%c\n", CLREOL);
-    pause(100);
-    cycle += 1;
-  } // End of while()
 
+  schAdd("estimate", estimate, 50);
+  schAdd("act", act, 100);
+  schAdd("show", show, 500);
+  schRun(0);
+  schReport();
   print("botSpeed =%f (%f, %f)%c\n", botSpeed, leftSpeed, rightSpeed, CLREOL);
 
   print("Stopping...%c\n", CLREOL);
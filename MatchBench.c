@@ -0,0 +1,147 @@
+/*
+  MatchBench.c
+  --------
+  Dead reckoning against dead reckoning corrected by scan-to-scan
+  matching. The bot drives a fixed route, scanning at each stop and
+  recording the encoder ticks. The recording is then replayed twice:
+  once through the odometry alone, and once matching each scan against
+  the one before and applying the correction whenever matchScan()
+  offers one with confidence MATCH_USE or more.
+
+  On the ActivityBot the figures are CNT cycles per match. On the host
+  (built against sim/) times are nanoseconds and both estimates are
+  scored against the truth. The wheels slip 2% (1 sigma) unless
+  SIM_SLIP says otherwise; SIM_SLIP=0 checks that matching leaves an
+  exact pose alone, and both runs should score the same:
+    SIM_SECONDS=600 ./MatchBench
+    SIM_SLIP=0 SIM_SECONDS=600 ./MatchBench
+
+  A correction can make the final error worse, since each match only
+  knows the scan before it; see match.c for how often. Over 1-3% slip
+  and 12 seeds, 5 of 36 routes ended further off than odometry alone.
+  SIM_SLIP=0.03 SIM_SEED=1 is the worst: the bot ends 60 degrees off,
+  odometry's error swings between 0.3 and 0.9 m and happens to end at
+  370 mm, and the last correction takes the matched pose from 459 mm
+  off to 970.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "match.h"                            // Scan-to-scan matching
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+// --- Route: turn (degrees), then move (mm), then scan. Twice round a
+// --- 700 mm square.
+int route[][2] = {
+  {0, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350},
+  {90, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}
+};
+#define STOPS  ((int)(sizeof(route) / sizeof(*route)))
+
+// --- Recorded stops
+typedef struct {
+  int turn[2], ticks[2];                      // Encoder counts after the turn and the move
+  float truth[3];                             // Simulated pose (host only)
+  short cm[SCAN_MAX];
+} stopRecord;
+
+stopRecord rec[STOPS];
+
+float error(float *p, float *q)
+{
+  return sqrt((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]));
+}
+
+int main()
+{
+  int l0, r0;
+
+#ifdef SIM_CLKFREQ
+  sim_defaultSlip(0.02);
+#endif
+
+  // Record the route
+  botSetMaxSpeed(200);
+  setPose(0, 0, 0);
+  drive_getTicks(&l0, &r0);
+  for (int s = 0; s < STOPS; s++) {
+    if (route[s][0]) botTurn(route[s][0] * M_PI / 180.0);
+    updatePose();
+    drive_getTicks(&rec[s].turn[0], &rec[s].turn[1]);
+    if (route[s][1]) botMove(route[s][1]);
+    updatePose();
+    pingScan();
+    drive_getTicks(&rec[s].ticks[0], &rec[s].ticks[1]);
+#ifdef SIM_CLKFREQ
+    double truth[3];
+    sim_getPose(truth);
+    for (int k = 0; k < 3; k++)
+      rec[s].truth[k] = truth[k];
+#endif
+    for (int i = 0; i < numAngles; i++)
+      rec[s].cm[i] = scan_cm[i];
+  }
+  print("MatchBench: %d stops, %d beams per scan%c\n", STOPS, numAngles, CLREOL);
+
+  // Replay, without and then with matching
+  for (int run = 0; run < 2; run++) {
+    unsigned int t, total = 0, worst = 0;
+    int used = 0, confSum = 0, corr[3];
+    float pose[3], sum = 0, last = 0;
+
+    odomReset(l0, r0, 0, 0, 0);
+    matchReset();
+    for (int s = 0; s < STOPS; s++) {
+      odomUpdate(rec[s].turn[0], rec[s].turn[1]);
+      odomUpdate(rec[s].ticks[0], rec[s].ticks[1]);
+      for (int i = 0; i < numAngles; i++)
+        scan_cm[i] = rec[s].cm[i];
+      if (run) {
+        t = benchNow();
+        int conf = matchScan(corr);
+        t = benchNow() - t;
+        total += t;
+        if (t > worst) worst = t;
+        confSum += conf;
+        if (conf >= MATCH_USE) {
+          odomReset(rec[s].ticks[0], rec[s].ticks[1], fx_toFloat(odomX + corr[0]),
+                    fx_toFloat(odomY + corr[1]), bam_toRadians(odomTheta + corr[2]));
+          used++;
+        }
+        matchStore();
+      }
+      pose[0] = odomGetX();
+      pose[1] = odomGetY();
+      last = error(pose, rec[s].truth);
+      sum += last;
+    }
+    print("%-8s", run ? "matched" : "odometry");
+#ifdef SIM_CLKFREQ
+    print("  mean error %4d mm  final %4d mm", (int)(sum / STOPS), (int)last);
+#endif
+    if (run)
+      print("  %d of %d applied, mean confidence %d, %d %s per match, worst %d",
+            used, STOPS - 1, confSum / (STOPS - 1), total / (STOPS - 1), BENCH_UNITS, worst);
+    print("%c\n", CLREOL);
+  }
+  matchBudget();
+  return 0;
+}
@@ -0,0 +1,163 @@
+/*
+  MclBench.c
+  --------
+  Dead reckoning against Monte Carlo localization. The bot drives a fixed
+  route, scanning at each stop and recording the encoder ticks of every
+  turn and move. A map is built from the scans, then the recording is
+  replayed through the particle filter at several pool sizes, scoring the
+  scans by ray casting and by likelihood field lookup.
+
+  On the ActivityBot the map is built from the odometry poses, and the
+  figures are CNT cycles per step. On the host (built against sim/) the map
+  is built from the true poses, times are nanoseconds, and both estimates
+  are scored against the truth. Run with some wheel error to see drift:
+    SIM_SLIP=0.03 SIM_SECONDS=600 ./MclBench
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "field.h"                            // Likelihood field
+#include "mcl.h"                              // Monte Carlo localization
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+// --- Route: turn (degrees), then move (mm), then scan. Twice round a
+// --- 700 mm square.
+int route[][2] = {
+  {0, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350},
+  {90, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}
+};
+#define STOPS  ((int)(sizeof(route) / sizeof(*route)))
+
+int counts[] = {16, 32, 64, 128};
+#define RUNS   ((int)(sizeof(counts) / sizeof(*counts)))
+
+// --- Recorded stops
+typedef struct {
+  short turn[2], move[2];                     // Encoder ticks, left and right
+  int x, y;                                   // odomX, odomY
+  unsigned int theta;                         // odomTheta
+  float truth[3];                             // Simulated pose (host only)
+  short cm[SCAN_MAX];
+} stopRecord;
+
+stopRecord rec[STOPS];
+
+float error(float *p, float *q)
+{
+  return sqrt((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]));
+}
+
+int main()
+{
+  int l0, r0, l1, r1;
+  float start[3];
+
+  // Record the route
+  botSetMaxSpeed(200);
+  setPose(0, 0, 0);
+  start[0] = botP[0];
+  start[1] = botP[1];
+  start[2] = botP[2];
+  drive_getTicks(&l0, &r0);
+  for (int s = 0; s < STOPS; s++) {
+    if (route[s][0]) botTurn(route[s][0] * M_PI / 180.0);
+    updatePose();
+    drive_getTicks(&l1, &r1);
+    rec[s].turn[0] = l1 - l0;
+    rec[s].turn[1] = r1 - r0;
+    if (route[s][1]) botMove(route[s][1]);
+    drive_getTicks(&l0, &r0);
+    rec[s].move[0] = l0 - l1;
+    rec[s].move[1] = r0 - r1;
+    updatePose();
+    pingScan();
+    rec[s].x = odomX;
+    rec[s].y = odomY;
+    rec[s].theta = odomTheta;
+#ifdef SIM_CLKFREQ
+    double truth[3];
+    sim_getPose(truth);
+    for (int k = 0; k < 3; k++)
+      rec[s].truth[k] = truth[k];
+#endif
+    for (int i = 0; i < numAngles; i++)
+      rec[s].cm[i] = scan_cm[i];
+  }
+  print("MclBench: %d stops, %d beams per scan%c\n", STOPS, numAngles, CLREOL);
+
+  // Map from the first time round
+  mapClear();
+  for (int s = 0; s < STOPS / 2; s++) {
+    odomX = rec[s].x;
+    odomY = rec[s].y;
+    odomTheta = rec[s].theta;
+#ifdef SIM_CLKFREQ
+    odomX = rec[s].truth[0] * 65536.0;
+    odomY = rec[s].truth[1] * 65536.0;
+    odomTheta = bam_fromRadians(rec[s].truth[2]);
+#endif
+    for (int i = 0; i < numAngles; i++)
+      scan_cm[i] = rec[s].cm[i];
+    mapScan();
+  }
+
+#ifdef SIM_CLKFREQ
+  float sum = 0, last = 0;
+  for (int s = 0; s < STOPS; s++) {
+    float p[2] = {fx_toFloat(rec[s].x), fx_toFloat(rec[s].y)};
+    last = error(p, rec[s].truth);
+    sum += last;
+  }
+  print("odometry              mean error %4d mm  final %4d mm%c\n", (int)(sum / STOPS), (int)last, CLREOL);
+#endif
+
+  // Replay through the filter, scoring by ray casting and by the field
+  for (int n = 0; n < 2 * RUNS; n++) {
+    unsigned int tMotion = 0, tMeasure = 0, t;
+    float pose[3], sum = 0, last = 0;
+
+    mclSetModel(n < RUNS ? MCL_MODEL_RAY : MCL_MODEL_FIELD);
+    mclSetCount(counts[n % RUNS]);
+    mclInit(start[0], start[1], start[2], 50, 5);
+    for (int s = 0; s < STOPS; s++) {
+      t = benchNow();
+      mclMotion(rec[s].turn[0], rec[s].turn[1]);
+      mclMotion(rec[s].move[0], rec[s].move[1]);
+      tMotion += benchNow() - t;
+      for (int i = 0; i < numAngles; i++)
+        scan_cm[i] = rec[s].cm[i];
+      t = benchNow();
+      mclScan();
+      tMeasure += benchNow() - t;
+      mclPose(pose);
+      last = error(pose, rec[s].truth);
+      sum += last;
+    }
+    print("%-5s %4d particles", n < RUNS ? "ray" : "field", counts[n % RUNS]);
+#ifdef SIM_CLKFREQ
+    print(" mean error %4d mm  final %4d mm", (int)(sum / STOPS), (int)last);
+#endif
+    print("  motion %6d %s  scan %8d %s per stop%c\n",
+          tMotion / STOPS, BENCH_UNITS, tMeasure / STOPS, BENCH_UNITS, CLREOL);
+  }
+  mclBudget();
+  return 0;
+}
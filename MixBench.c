@@ -0,0 +1,98 @@
+/*
+  MixBench.c
+  --------
+  Ask botSetVW() for more than the wheels can do, and for less than a
+  tick, and see what the bot actually does.
+
+  Each mixer mode drives an arc at a velocity and omega the wheels can't
+  both manage under maxSpeed, and reports the velocity, omega and radius
+  it settled to against those asked for: BOT_MIX_ARC should keep the
+  radius, BOT_MIX_TURN the omega and BOT_MIX_SPEED the velocity. Then
+  the bot creeps at a speed below a tick for a while, and reports how
+  far it got against how far it should have.
+
+  Give it about half a metre of room.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+
+#define TICK_MS     50                        // Control tick
+#define SETTLE_MS   1000                      // Let the ramp catch up first
+#define ARC_MS      2000                      // Then measure for this long
+#define VEL         250.0                     // mm/s asked for on the arc...
+#define OMEGA       2.5                       // ... and rad/s
+#define CREEP       2.0                       // mm/s; under a tick
+#define CREEP_MS    10000
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+float runFor(float vel, float omega, int ms)
+{
+  // Drive vel and omega for ms, and return how far the bot turned (rad)
+  float turned = 0, last = botP[2], d;
+  for (int t = 0; t < ms; t += TICK_MS) {
+    botSetVW(vel, omega);
+    pause(TICK_MS);
+    updatePose();
+    d = botP[2] - last;
+    if (d > M_PI) d -= 2 * M_PI;
+    if (d < -M_PI) d += 2 * M_PI;
+    turned += d;
+    last = botP[2];
+  }
+  return turned;
+}
+
+int main()
+{
+  char *names[] = {"BOT_MIX_ARC", "BOT_MIX_TURN", "BOT_MIX_SPEED"};
+  float p[2], v, w, d;
+
+  botSetMaxSpeed(200);
+  print("MixBench: %d mm/s max, asking %d mm/s at %d mrad/s (radius %d mm)%c\n",
+        maxSpeed * 13 / 4, (int)VEL, (int)(OMEGA * 1000), (int)(VEL / OMEGA), CLREOL);
+
+  for (int mode = BOT_MIX_ARC; mode <= BOT_MIX_SPEED; mode++) {
+    botSetMix(mode);
+    runFor(VEL, OMEGA, SETTLE_MS);
+    p[0] = botP[0];
+    p[1] = botP[1];
+    w = runFor(VEL, OMEGA, ARC_MS) / (ARC_MS / 1000.0);
+    // Chord to arc: the bot turned w * t on a circle through p and botP
+    d = sqrt(pow(botP[0] - p[0], 2.0) + pow(botP[1] - p[1], 2.0));
+    if (fabs(w) > 0.01) d *= (w * ARC_MS / 2000.0) / sin(w * ARC_MS / 2000.0);
+    v = d / (ARC_MS / 1000.0);
+    print("%-14s %4d mm/s  %5d mrad/s  radius %5d mm  wheels %3d %3d%c\n", names[mode],
+          (int)v, (int)(w * 1000), fabs(w) > 0.01 ? (int)(v / w) : 0, leftSpeed, rightSpeed, CLREOL);
+    botStop();
+    pause(500);
+  }
+  botSetMix(BOT_MIX_ARC);
+
+  // Under a tick
+  updatePose();
+  p[0] = botP[0];
+  p[1] = botP[1];
+  runFor(CREEP, 0.0, CREEP_MS);
+  botStop();
+  pause(500);
+  updatePose();
+  d = sqrt(pow(botP[0] - p[0], 2.0) + pow(botP[1] - p[1], 2.0));
+  print("creep at %d.%d mm/s for %d s: %d mm, asked %d mm%c\n", (int)CREEP, (int)(CREEP * 10) % 10,
+        CREEP_MS / 1000, (int)d, (int)(CREEP * CREEP_MS / 1000), CLREOL);
+  return 0;
+}
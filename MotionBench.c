@@ -0,0 +1,140 @@
+/*
+  MotionBench.c
+  --------
+  Drive the same maneuver, a move, a turn and a move, twice: once with
+  botMove() and botTurn(), which hold up the main cog until each is done,
+  and once queued for the drive cog in motion.c while the main cog keeps
+  updating the pose and pinging ahead. Reports the time each took, how
+  many times the main loop got round meanwhile and where the bot ended up.
+
+  Then queue a long move at a wall and a turn after it, and cancel both
+  from the main loop as soon as the PING))) sees the wall closer than
+  STOP_CM. Reports how far short of the wall the bot stopped.
+
+  On the host (built against sim/) the maneuver is in open floor and the
+  wall is box1, and the bot's true pose is reported too. On the
+  ActivityBot give it a metre or so of room, then face a wall.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "motion.h"                           // Motion command queue
+
+#define TICK_MS     50                        // Main loop
+#define FIRST_MM    500
+#define SECOND_MM   300
+#define STOP_CM     30                        // Cancel once the wall is this close
+#define RUN_AT_MM   1500                      // Move queued at the wall
+
+void place(float x, float y, float theta)
+{
+#ifdef SIM_CLKFREQ
+  sim_setPose(x, y, theta);
+#endif
+  setPose(x, y, theta);
+}
+
+void report(char *name, unsigned int t, int loops)
+{
+  print("%-10s %5d ms  %3d main loops  pose (%4d, %4d, %3d deg)", name, (t / (CLKFREQ / 1000)),
+        loops, (int)botP[0], (int)botP[1], (int)(botP[2] * 180 / M_PI));
+#ifdef SIM_CLKFREQ
+  double truth[3];
+  sim_getPose(truth);
+  print("  true (%4d, %4d, %3d deg)", (int)truth[0], (int)truth[1], (int)(truth[2] * 180 / M_PI));
+#endif
+  print("%c\n", CLREOL);
+}
+
+int main()
+{
+  unsigned int t;
+  int loops, run, turn, cm = 0;
+  char *names[] = {"queued", "running", "done", "cancelled", "failed"};
+
+  print("MotionBench: move %d mm, turn 90 deg, move %d mm%c\n", FIRST_MM, SECOND_MM, CLREOL);
+  pingAngle(0);
+
+  // Blocking: the main cog waits out each one
+  place(0, 300, 0);
+  t = CNT;
+  botMove(FIRST_MM);
+  updatePose();
+  botTurn(M_PI / 2);
+  updatePose();
+  botMove(SECOND_MM);
+  updatePose();
+  report("blocking", CNT - t, 0);
+
+  // Queued: the main cog keeps going
+  place(0, 300, 0);
+  mqStart();
+  t = CNT;
+  loops = 0;
+  mqMove(FIRST_MM);
+  mqTurn(M_PI / 2);
+  mqMove(SECOND_MM);
+  while (mqPending()) {
+    updatePose();
+    cm = pingHere();
+    loops++;
+    pause(TICK_MS);
+  }
+  updatePose();
+  report("queued", CNT - t, loops);
+
+  // Cancelled at the wall
+  place(0, -150, 0);
+  t = CNT;
+  loops = 0;
+  run = mqMove(RUN_AT_MM);
+  turn = mqTurn(M_PI);
+  while (mqPending()) {
+    updatePose();
+    cm = pingHere();
+    loops++;
+    if (cm < STOP_CM) mqCancel();
+    pause(TICK_MS);
+  }
+  updatePose();
+  report("cancelled", CNT - t, loops);
+  print("move %s at %d%%, turn %s; wall seen at %d cm, %d cm when stopped", 
+        mqStatus(run) == MQ_CANCELLED ? "cancelled" : "finished", (int)(mqProgress * 100),
+        mqStatus(turn) == MQ_CANCELLED ? "cancelled" : "finished", cm, pingHere());
+#ifdef SIM_CLKFREQ
+  double truth[3];
+  sim_getPose(truth);
+  print(", %d mm clear, %d collisions", (int)(sim_clearance(truth[0], truth[1]) - SIM_BOT_RADIUS),
+        sim_collisions());
+#endif
+  print("%c\n", CLREOL);
+
+  // Stopped partway: nothing should be left queued or running
+  place(0, 0, 0);
+  run = mqMove(RUN_AT_MM);
+  turn = mqTurn(M_PI);
+  pause(1000);
+  mqStop();
+  print("mqStop() partway: %d pending, move %s, turn %s%c\n", mqPending(),
+        names[mqStatus(run)], names[mqStatus(turn)], CLREOL);
+
+  // With no drive cog the queue fills: the command that doesn't fit
+  // gets id 0, which must read as failed, not as running
+  for (loops = 0; (run = mqMove(10)); loops++)
+    ;
+  print("full queue: %d queued, then id %d %s%c\n", loops, run, names[mqStatus(run)], CLREOL);
+  mqStop();
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*
+  OdomBench.c
+  --------
+  Compare the fixed-point odometry in odometry.c with the float ICC update
+  that updatePose() used before it: time per update, and drift against an
+  exact double precision integration over a long sequence of encoder ticks.
+
+  On the ActivityBot times are in clock cycles from CNT. On the host (built
+  against sim/) they are nanoseconds, and since doubles there are really
+  64 bits the drift figures are only meaningful on the host.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sin(), cos()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+#define UPDATES   100000                      // ~2.8 hours of driving at 10 Hz
+
+static unsigned int seed;
+
+void nextTicks(int *dL, int *dR)
+{
+  // Repeatable mix of straights, arcs and spins, up to 13 ticks per wheel
+  // per update (128 ticks/s at 10 Hz)
+  int mode, a, b;
+  seed = seed * 1664525 + 1013904223;
+  mode = (seed >> 28) & 3;
+  a = (seed >> 8) % 14;
+  b = (seed >> 16) % 14;
+  if (mode == 0) {
+    *dL = a; *dR = a;               // Straight
+  } else if (mode == 1) {
+    *dL = -a; *dR = a;              // Spin in place
+  } else {
+    *dL = a; *dR = b;               // Arc
+  }
+}
+
+void floatStep(float P[3], int deltaL, int deltaR)
+{
+  // updatePose() as it was, minus the encoder read
+  float R, omega_dt;
+  float ICC[2];
+  float L = 105.8;
+  float step = 3.25;
+  float X, Y;
+
+  if (deltaL == deltaR) {
+    X = P[0] + deltaL * step * cos(P[2]);
+    Y = P[1] + deltaL * step * sin(P[2]);
+    omega_dt = 0.0;
+  } else {
+    R = (L/2.0) * (deltaR + deltaL) / (deltaR - deltaL);
+    omega_dt = (deltaR - deltaL) * step / L;
+    ICC[0] = P[0] - R * sin(P[2]);
+    ICC[1] = P[1] + R * cos(P[2]);
+    X = ICC[0] + (P[0]-ICC[0])*cos(omega_dt) - (P[1]-ICC[1])*sin(omega_dt);
+    Y = ICC[1] + (P[0]-ICC[0])*sin(omega_dt) + (P[1]-ICC[1])*cos(omega_dt);
+  }
+  P[0] = X;
+  P[1] = Y;
+  P[2] += omega_dt;
+}
+
+void exactStep(double P[3], int totalDiff, int deltaL, int deltaR)
+{
+  // Exact arc in double precision, heading from the total tick difference
+  double th = totalDiff * 3.25 / 105.8;
+  double dth = th - P[2];
+  double ds = (deltaL + deltaR) * 3.25 / 2.0;
+  if (deltaL == deltaR) {
+    P[0] += ds * cos(P[2]);
+    P[1] += ds * sin(P[2]);
+  } else {
+    P[0] += ds / dth * (sin(th) - sin(P[2]));
+    P[1] -= ds / dth * (cos(th) - cos(P[2]));
+  }
+  P[2] = th;
+}
+
+float headingError(float a, double b)
+{
+  // |a - b| in degrees, wrapped to 0..180
+  double e = fmod(fabs(a - b), 2.0*M_PI);
+  if (e > M_PI) e = 2.0*M_PI - e;
+  return e * 180.0 / M_PI;
+}
+
+int main()
+{
+  float fP[3] = {0.0, 0.0, 0.0};
+  double xP[3] = {0.0, 0.0, 0.0};
+  int totalL = 0, totalR = 0;
+  int dL, dR;
+  float fErr, xErr, fMax = 0.0, xMax = 0.0;
+  unsigned int t0, tGen, tFloat, tFixed;
+
+  print("OdomBench: %d updates%c\n", UPDATES, CLREOL);
+
+  // --- Time per update, net of generating the ticks
+  seed = 1;
+  t0 = benchNow();
+  for (int i = 0; i < UPDATES; i++) {
+    nextTicks(&dL, &dR);
+    totalL += dL;
+    totalR += dR;
+  }
+  tGen = benchNow() - t0;
+
+  seed = 1;
+  t0 = benchNow();
+  for (int i = 0; i < UPDATES; i++) {
+    nextTicks(&dL, &dR);
+    floatStep(fP, dL, dR);
+  }
+  tFloat = benchNow() - t0 - tGen;
+
+  seed = 1;
+  totalL = totalR = 0;
+  odomReset(0, 0, 0.0, 0.0, 0.0);
+  t0 = benchNow();
+  for (int i = 0; i < UPDATES; i++) {
+    nextTicks(&dL, &dR);
+    totalL += dL;
+    totalR += dR;
+    odomUpdate(totalL, totalR);
+  }
+  tFixed = benchNow() - t0 - tGen;
+
+  print("float update: %d %s%c\n", tFloat / UPDATES, BENCH_UNITS, CLREOL);
+  print("fixed update: %d %s%c\n", tFixed / UPDATES, BENCH_UNITS, CLREOL);
+
+  // --- Drift against the exact integration
+  seed = 1;
+  totalL = totalR = 0;
+  fP[0] = fP[1] = fP[2] = 0.0;
+  odomReset(0, 0, 0.0, 0.0, 0.0);
+  for (int i = 0; i < UPDATES; i++) {
+    nextTicks(&dL, &dR);
+    totalL += dL;
+    totalR += dR;
+    floatStep(fP, dL, dR);
+    odomUpdate(totalL, totalR);
+    exactStep(xP, totalR - totalL, dL, dR);
+
+    fErr = hypot(fP[0] - xP[0], fP[1] - xP[1]);
+    xErr = hypot(odomGetX() - xP[0], odomGetY() - xP[1]);
+    if (fErr > fMax) fMax = fErr;
+    if (xErr > xMax) xMax = xErr;
+  }
+
+  print("distance driven: %d m%c\n", (int)((abs(totalL) + abs(totalR)) * 3.25 / 2000.0), CLREOL);
+  print("float drift: %f mm final, %f mm max, heading %f deg%c\n",
+        fErr, fMax, headingError(fP[2], xP[2]), CLREOL);
+  print("fixed drift: %f mm final, %f mm max, heading %f deg%c\n",
+        xErr, xMax, headingError(odomGetTheta(), xP[2]), CLREOL);
+  return 0;
+}
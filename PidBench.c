@@ -0,0 +1,110 @@
+/*
+  PidBench.c
+  --------
+  Step a PI controller on a simulated heading, with a loop period that
+  wanders, and see what measuring dt and anti-windup are worth.
+
+  The plant turns at the controller's output, held to +/-RATE_MAX rad/s
+  as the wheels would, less a steady DRIFT (slip) only the integral can
+  take out. Each loop waits somewhere between LOOP_MIN and LOOP_MAX ms,
+  as a loop that also prints and pings does. The step is run with dt
+  taken as a fixed 0.1 s, as pid_omega() used to, with dt from CNT, and
+  with dt from CNT and back-calculation, and each reports its overshoot,
+  the time to settle within SETTLE and the mean error. Then the float
+  and Q16.16 updates are timed.
+
+  No bot needed.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for fabs()
+#include <stdlib.h>                           // Needed for rand()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "pid.h"                              // PID controllers
+
+#define KP          3.0
+#define KI          2.0
+#define RATE_MAX    1.0                       // rad/s the output is held to
+#define DRIFT       0.2                       // rad/s
+#define STEP        1.5                       // rad
+#define SETTLE      0.05                      // rad
+#define LOOP_MIN    40                        // ms
+#define LOOP_MAX    260                       // ms
+#define RUN_MS      12000
+#define UPDATES     10000                     // For timing
+
+void run(char *name, int measured, float kb)
+{
+  // Step the heading from 0 to STEP and report how it went
+  pidState pid;
+  float x = 0, u = 0, peak = 0, sum = 0, dt;
+  int settled = -1, t = 0, n = 0;
+  unsigned int at;
+
+  srand(1);                                   // The same loop periods for each
+  pidInit(&pid, KP, KI, 0.0);
+  pidLimits(&pid, -RATE_MAX, RATE_MAX);
+  if (kb > 0) pidAntiWindup(&pid, kb);
+  at = CNT;
+  while (t < RUN_MS) {
+    u = measured ? pidUpdate(&pid, STEP, x) : pidUpdateDt(&pid, STEP, x, 0.1);
+    pause(LOOP_MIN + rand() % (LOOP_MAX - LOOP_MIN + 1));
+    dt = (float)(CNT - at) / CLKFREQ;
+    at = CNT;
+    t += (int)(dt * 1000 + 0.5);
+    if (u > RATE_MAX) u = RATE_MAX;
+    if (u < -RATE_MAX) u = -RATE_MAX;
+    x += (u - DRIFT) * dt;
+    if (x - STEP > peak) peak = x - STEP;
+    if (fabs(x - STEP) > SETTLE) settled = -1;
+    else if (settled < 0) settled = t;
+    sum += fabs(x - STEP);
+    n++;
+  }
+  print("%-22s overshoot %4d mrad  settled %5d ms  mean error %4d mrad%c\n", name,
+        (int)(peak * 1000), settled, (int)(sum / n * 1000), CLREOL);
+}
+
+int main()
+{
+  pidState pf;
+  pidFx px;
+  float f = 0;
+  int x = 0;
+  unsigned int t;
+
+  print("PidBench: PI %d.%d/%d.%d, output held to %d mrad/s, drift %d mrad/s, loop %d-%d ms%c\n",
+        (int)KP, (int)(KP * 10) % 10, (int)KI, (int)(KI * 10) % 10,
+        (int)(RATE_MAX * 1000), (int)(DRIFT * 1000), LOOP_MIN, LOOP_MAX, CLREOL);
+  run("dt taken as 0.1 s", 0, 0);
+  run("dt from CNT", 1, 0);
+  run("dt from CNT, kb", 1, KI / KP);
+
+  pidInit(&pf, KP, KI, 0.5);
+  pidLimits(&pf, -RATE_MAX, RATE_MAX);
+  pidAntiWindup(&pf, KI / KP);
+  pidFilter(&pf, 0.05);
+  t = benchNow();
+  for (int i = 0; i < UPDATES; i++) f += pidUpdateDt(&pf, STEP, (i & 63) / 32.0, 0.1);
+  t = benchNow() - t;
+  print("float   %6d %s/update%c\n", t / UPDATES, BENCH_UNITS, CLREOL);
+
+  pidFxInit(&px, fx_fromFloat(KP), fx_fromFloat(KI), fx_fromFloat(0.5));
+  pidFxLimits(&px, fx_fromFloat(-RATE_MAX), fx_fromFloat(RATE_MAX));
+  pidFxAntiWindup(&px, fx_fromFloat(KI / KP));
+  pidFxFilter(&px, fx_fromFloat(0.05));
+  t = benchNow();
+  for (int i = 0; i < UPDATES; i++) x += pidFxUpdateDt(&px, fx_fromFloat(STEP), (i & 63) << 11, fx_fromFloat(0.1));
+  t = benchNow() - t;
+  print("Q16.16  %6d %s/update  (outputs agree to %d ppm)%c\n", t / UPDATES, BENCH_UNITS,
+        (int)(fabs(f - fx_toFloat(x)) / (fabs(f) + 1e-6) * 1e6), CLREOL);
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+  PlanBench.c
+  --------
+  Drive to a few goals with the blended planner in plan.c: every control
+  tick the bot reads what it can of the PING))) sweep, makes a plan from
+  the goal and the latest ranges, and hands it to executePlan(). Reports
+  how long each goal took, and what a plan costs with the planner's
+  tables and with exp(), sin() and cos() in floating point.
+
+  On the host (built against sim/) each goal starts from the same spot,
+  west of the two boxes, and also reports the closest the bot came to a
+  wall and any collisions. On the ActivityBot the goals are relative to
+  wherever it starts; give it room.
+
+  On the host the four goals take about 70 simulated seconds, and up to
+  200 with wheel slip, more than the sim's default 60:
+    SIM_SECONDS=300 ./PlanBench
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt(), exp()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "plan.h"                             // Planning
+
+#define TICK_MS     50                        // Control tick
+#define GIVE_UP_MS  60000                     // Per goal
+#define CLOSE_MM    50                        // Goal reached
+
+// --- Goals (mm, world frame), each from (0, -150) facing +x
+float goals[][2] = {
+  {1500, -150}, {1700, 900}, {1800, 200}, {600, 900}
+};
+#define GOALS  ((int)(sizeof(goals) / sizeof(*goals)))
+
+scanPattern front;
+
+void floatPlan(float *goal, float *out)
+{
+  // makePlan() the obvious way, for comparison
+  float dx = goal[0] - botP[0], dy = goal[1] - botP[1];
+  float d = sqrt(dx*dx + dy*dy), k = PLAN_K_GOAL;
+  float sx = 0, sy = 0, sw = 0, nearest = 0, s;
+  if (d * k > PLAN_SPEED) k = PLAN_SPEED / d;
+  for (int i = 0; i < numAngles; i++) {
+    float r = scan_cm[i] * 10.0, a = botP[2] + scanAngle[i] * M_PI / 180.0, w;
+    if (r <= 0 || r >= MAP_RANGE) continue;
+    if (nearest == 0 || r < nearest) nearest = r;
+    w = exp(-PLAN_BETA * r);
+    sx += w * cos(a);
+    sy += w * sin(a);
+    sw += w;
+  }
+  s = nearest > 0 ? 1.0 - exp(-PLAN_BETA * nearest) : 1.0;
+  out[0] = s * k * dx - (sw > 0 ? (1.0 - s) * PLAN_SPEED * sx / sw : 0);
+  out[1] = s * k * dy - (sw > 0 ? (1.0 - s) * PLAN_SPEED * sy / sw : 0);
+}
+
+int main()
+{
+  unsigned int tTable = 0, tFloat = 0, calls = 0;
+
+  scanPatternRange(&front, -60, 60, 15);
+  pingScanPattern(&front);
+  print("PlanBench: %d goals, %d beams per sweep, %d ms ticks%c\n",
+        GOALS, numAngles, TICK_MS, CLREOL);
+
+  for (int g = 0; g < GOALS; g++) {
+    int ms = 0, hit = 0;
+    float d, nearest = 10000;
+#ifdef SIM_CLKFREQ
+    int bumps = sim_collisions();
+    sim_setPose(0, -150, 0);
+#endif
+    setPose(0, -150, 0);
+    for (int i = 0; i < numAngles; i++)
+      scan_cm[i] = 0;
+    pingScanStart();
+    do {
+      float check[2];
+      unsigned int t;
+      updatePose();
+      pingScanPoll();
+      if (pingScanComplete()) pingScanStart();
+
+      t = benchNow();
+      makePlan(goals[g]);
+      tTable += benchNow() - t;
+      t = benchNow();
+      floatPlan(goals[g], check);
+      tFloat += benchNow() - t;
+      calls++;
+
+      executePlan(plan);
+#ifdef SIM_CLKFREQ
+      double truth[3];
+      sim_getPose(truth);
+      double c = sim_clearance(truth[0], truth[1]);
+      if (c < nearest) nearest = c;
+#endif
+      pause(TICK_MS);
+      ms += TICK_MS;
+      d = sqrt(pow(goals[g][0] - botP[0], 2.0) + pow(goals[g][1] - botP[1], 2.0));
+      hit = d < CLOSE_MM;
+    } while (!hit && ms < GIVE_UP_MS);
+    botSetVW(0, 0);
+    while (!pingScanComplete())
+      pingScanPoll();
+
+    print("goal (%5d,%5d)  %s in %5d ms  %4d mm off", (int)goals[g][0], (int)goals[g][1],
+          hit ? "reached" : "missed ", ms, (int)d);
+#ifdef SIM_CLKFREQ
+    print("  nearest wall %4d mm  %d collisions", (int)nearest, sim_collisions() - bumps);
+#endif
+    print("%c\n", CLREOL);
+  }
+  print("plan: tables %d %s, float %d %s per tick%c\n",
+        tTable / calls, BENCH_UNITS, tFloat / calls, BENCH_UNITS, CLREOL);
+  return 0;
+}
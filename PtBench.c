@@ -0,0 +1,161 @@
+/*
+  PtBench.c
+  --------
+  Wander the room with sensing, odometry, a behavior and telemetry on
+  one cog as protothreads, and again with the sensors on a cog of their
+  own as startSensor() runs them, and compare.
+
+  The behavior drives ahead at SPEED and, when the PING))) sees
+  something within NEAR cm, turns away from it with heading.c's hdPoll()
+  before going on. It is meant to run every STEP_MS; each run reports
+  the worst gap between its steps, how often the sensors published,
+  the turns made, and what it cost: cogs, and
+  bytes of stack or thread state.
+
+  Give it a room to wander in.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include "simpletools.h"                      // Include simple tools
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "pt.h"                               // Protothreads
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "heading.h"                          // Closed-loop turns
+
+#define RUN_MS      20000                     // Under 26 s: CNT differences are signed
+#define STEP_MS     20                        // Behavior period
+#define SENSE_HZ    20
+#define SPEED       150.0                     // mm/s
+#define NEAR        25                        // cm
+#define SHOW_MS     1000
+#define SENSOR_STACK 100                      // longs, as startSensor()
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+unsigned int lastStep, worstGap, started;
+int steps, turns, shown;
+
+void behave()
+{
+  // A step of the behavior: keep turning, or go on, or start a turn
+  unsigned int now = CNT;
+  if (steps > 0 && now - lastStep > worstGap) worstGap = now - lastStep;
+  lastStep = now;
+  steps++;
+
+  if (hdState == HD_TURNING || hdState == HD_SETTLING) {
+    hdPoll();
+  } else if (pingFront < NEAR) {
+    hdStart(detectLeft ? -M_PI / 2 : M_PI / 2);
+    turns++;
+  } else {
+    botSetVW(SPEED, 0);
+  }
+}
+
+void show()
+{
+  // Telemetry
+  shown++;
+  print("%c%5d ms  (%4d, %4d) mm  front %3d cm  turns %d%c\n", HOME,
+        (CNT - started) / (CLKFREQ / 1000), (int)botP[0], (int)botP[1], pingFront, turns, CLREOL);
+}
+
+// --- As protothreads
+pt sensePt, posePt, behavePt, showPt, stopPt;
+
+int behaveThread(pt *p)
+{
+  PT_BEGIN(p);
+  while (1) {
+    behave();
+    PT_WAIT_NEXT(p, STEP_MS);
+  }
+  PT_END(p);
+}
+
+int showThread(pt *p)
+{
+  PT_BEGIN(p);
+  while (1) {
+    PT_WAIT_MS(p, SHOW_MS);
+    show();
+  }
+  PT_END(p);
+}
+
+int stopThread(pt *p)
+{
+  // End the run after RUN_MS
+  PT_BEGIN(p);
+  PT_WAIT_MS(p, RUN_MS);
+  ptQuit();
+  PT_END(p);
+}
+
+void start()
+{
+#ifdef SIM_CLKFREQ
+  sim_setPose(0, 0, 0);
+#endif
+  setPose(0, 0, 0);
+  steps = turns = shown = 0;
+  worstGap = 0;
+  started = CNT;
+}
+
+void report(char *name, unsigned int events, int cogs, int bytes)
+{
+  int s = RUN_MS / 1000;
+  print("%-14s behavior %4d steps, worst gap %3d ms  sensors %4.1f/s  turns %2d",
+        name, steps, worstGap / (CLKFREQ / 1000), (float)events / s, turns);
+#ifdef SIM_CLKFREQ
+  print("  collisions %d", sim_collisions());
+#endif
+  print("  %d cog(s), %d bytes%c\n", cogs, bytes, CLREOL);
+}
+
+int main()
+{
+  unsigned int events;
+
+  sensorSetRate(SENSE_HZ);
+
+  // --- The sensors on a cog of their own, the rest in a loop
+  start();
+  events = sensorEvent;
+  startSensor();
+  while ((int)(CNT - started) < RUN_MS * (CLKFREQ / 1000)) {
+    updatePose();
+    behave();
+    if ((steps * STEP_MS) % SHOW_MS == 0) show();
+    pause(STEP_MS);
+  }
+  stopSensor();
+  botStop();
+  report("sensor cog", sensorEvent - events, 2, SENSOR_STACK * 4);
+  pause(1000);
+
+  // --- All of it on one cog
+  start();
+  events = sensorEvent;
+  ptAdd(&sensePt, sensorThread);
+  ptAdd(&posePt, poseThread);
+  ptAdd(&behavePt, behaveThread);
+  ptAdd(&showPt, showThread);
+  ptAdd(&stopPt, stopThread);
+  ptRun();
+  botStop();
+  report("protothreads", sensorEvent - events, 1, 5 * sizeof(pt));
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*
+  PursuitBench.c
+  --------
+  Drive a route of waypoints twice: once a waypoint at a time with
+  goTowardPose(), which stops and turns on the spot to face the next
+  one, and once with the pure pursuit follower in pursuit.c, which
+  rounds the corners without stopping at the speeds of the route's
+  velocity profile (profile.c). Reports the time each took, the distance
+  driven, and how far the bot strayed from the route, and the time the
+  profile itself works out.
+
+  On the host (built against sim/) the route weaves between the two
+  boxes, and the nearest the bot came to a wall and any collisions are
+  reported too. On the ActivityBot the route is relative to wherever it
+  starts; give it room.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "profile.h"                          // Velocity profiles
+#include "pursuit.h"                          // Pure pursuit path following
+
+#define TICK_MS     50                        // Control tick
+#define GIVE_UP_MS  120000                    // Per run
+#define CLOSE_MM    10                        // goTowardPose() turns within this
+
+// --- Route (mm, world frame), from (0, -150) facing +x
+float route[][2] = {
+  {0, -150}, {700, -400}, {1300, -400}, {1700, 100}, {1700, 350},
+  {1000, 350}, {600, 900}, {0, 600}
+};
+#define POINTS  ((int)(sizeof(route) / sizeof(*route)))
+
+typedef struct {
+  int ms;                                     // Time taken
+  float travel;                               // mm driven
+  float stray;                                // Farthest from the route (mm)
+  float nearest;                              // Nearest a wall came (mm)
+  int bumps;                                  // Collisions
+} result;
+
+float offRoute()
+{
+  // Distance from the bot to the nearest segment of the route
+  float best = 1e9;
+  for (int i = 0; i < POINTS - 1; i++) {
+    float dx = route[i + 1][0] - route[i][0], dy = route[i + 1][1] - route[i][1];
+    float t = ((botP[0] - route[i][0]) * dx + (botP[1] - route[i][1]) * dy) / (dx*dx + dy*dy);
+    float ex, ey, d;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    ex = route[i][0] + t * dx - botP[0];
+    ey = route[i][1] + t * dy - botP[1];
+    d = sqrt(ex*ex + ey*ey);
+    if (d < best) best = d;
+  }
+  return best;
+}
+
+void start(result *r)
+{
+  r->ms = 0;
+  r->travel = 0;
+  r->stray = 0;
+  r->nearest = 10000;
+  r->bumps = 0;
+#ifdef SIM_CLKFREQ
+  r->bumps = -sim_collisions();
+  sim_setPose(route[0][0], route[0][1], 0);
+#endif
+  setPose(route[0][0], route[0][1], 0);
+}
+
+void track(result *r, unsigned int *t, float *last)
+{
+  // Account for the time since *t and the move since last[]
+  float d;
+  updatePose();
+  r->ms += (CNT - *t) / (CLKFREQ / 1000);
+  *t = CNT;
+  r->travel += sqrt((botP[0] - last[0]) * (botP[0] - last[0]) + (botP[1] - last[1]) * (botP[1] - last[1]));
+  last[0] = botP[0];
+  last[1] = botP[1];
+  d = offRoute();
+  if (d > r->stray) r->stray = d;
+#ifdef SIM_CLKFREQ
+  double truth[3];
+  sim_getPose(truth);
+  double c = sim_clearance(truth[0], truth[1]);
+  if (c < r->nearest) r->nearest = c;
+#endif
+}
+
+void report(char *name, result *r)
+{
+  print("%-14s %6d ms  %5d mm driven  %3d mm off the route", name, r->ms, (int)r->travel, (int)r->stray);
+#ifdef SIM_CLKFREQ
+  print("  nearest wall %4d mm  %d collisions", (int)r->nearest, r->bumps + sim_collisions());
+#endif
+  print("%c\n", CLREOL);
+}
+
+int main()
+{
+  result stop, pursue;
+  unsigned int t;
+  float last[2];
+
+  botSetMaxSpeed(300);
+  print("PursuitBench: %d waypoints, %d ms ticks, %d mm/s max, ramp %d ticks/s per 20 ms%c\n",
+        POINTS, TICK_MS, maxSpeed * 13 / 4, rampStep, CLREOL);
+
+  // A waypoint at a time: drive to it, then turn to face the next one
+  start(&stop);
+  last[0] = botP[0];
+  last[1] = botP[1];
+  t = CNT;
+  for (int i = 1; i < POINTS && stop.ms < GIVE_UP_MS; i++) {
+    float goal[3] = {route[i][0], route[i][1], 0};
+    if (i < POINTS - 1) goal[2] = atan2(route[i + 1][1] - route[i][1], route[i + 1][0] - route[i][0]);
+    else goal[2] = atan2(route[i][1] - route[i - 1][1], route[i][0] - route[i - 1][0]);
+    do {
+      goTowardPose(goal);
+      pause(TICK_MS);
+      track(&stop, &t, last);
+    } while (sqrt(pow(goal[0] - botP[0], 2.0) + pow(goal[1] - botP[1], 2.0)) > CLOSE_MM
+             && stop.ms < GIVE_UP_MS);
+    goTowardPose(goal);
+    track(&stop, &t, last);
+  }
+  botSetVW(0, 0);
+  report("goTowardPose()", &stop);
+
+  // Pure pursuit, corners and all
+  start(&pursue);
+  last[0] = botP[0];
+  last[1] = botP[1];
+  ppSetPath(route, POINTS);
+  t = CNT;
+  while (ppFollow() && pursue.ms < GIVE_UP_MS) {
+    pause(TICK_MS);
+    track(&pursue, &t, last);
+  }
+  report("pure pursuit", &pursue);
+  vpBudget();
+  return 0;
+}
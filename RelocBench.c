@@ -0,0 +1,168 @@
+/*
+  RelocBench.c
+  --------
+  Global relocalization from a cold start. The bot drives a fixed route
+  twice. At each stop it scans, turns half round and scans again, then
+  turns back. A map is built from the first time round, then at every stop
+  the bot "forgets" where it is and relocalizes from one sweep and from
+  both, with no starting guess.
+
+  On the ActivityBot the map is built from the odometry poses, and times
+  are CNT cycles. On the host (built against sim/) the map is built from
+  the true poses, times are nanoseconds, and each fix is scored against
+  the truth: a hit is within RELOC_HIT_MM and RELOC_HIT_DEG. Run with
+  some wheel error to see how that matters:
+    SIM_SLIP=0.03 SIM_SECONDS=900 ./RelocBench
+  Both laps take about 120 simulated seconds, so SIM_SECONDS has to be
+  raised from the sim's default 60 even with no slip, or the bench stops
+  before it reports anything.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "field.h"                            // Likelihood field
+#include "reloc.h"                            // Global relocalization
+
+#ifndef M_PI
+#define M_PI  3.141592654
+#endif
+
+#define RELOC_HIT_MM   150
+#define RELOC_HIT_DEG  10
+
+// --- Route: turn (degrees), then move (mm), then scan. Twice round a
+// --- 700 mm square.
+int route[][2] = {
+  {0, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350},
+  {90, 0}, {0, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}, {90, 350}, {0, 350}
+};
+#define STOPS  ((int)(sizeof(route) / sizeof(*route)))
+
+// --- Recorded stops: two sweeps, half a turn apart
+typedef struct {
+  int x, y;                                   // odomX, odomY
+  unsigned int theta[2];                      // odomTheta at each sweep
+  float truth[2][3];                          // Simulated pose (host only)
+  short cm[2][SCAN_MAX];
+} stopRecord;
+
+stopRecord rec[STOPS];
+
+float error(float *p, float *q)
+{
+  return sqrt((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]));
+}
+
+float turnError(float a, float b)
+{
+  float d = fmod(fabs(a - b), 2 * M_PI);
+  return (d > M_PI ? 2 * M_PI - d : d) * 180.0 / M_PI;
+}
+
+void record(int s, int k)
+{
+  updatePose();
+  pingScan();
+  rec[s].x = odomX;
+  rec[s].y = odomY;
+  rec[s].theta[k] = odomTheta;
+#ifdef SIM_CLKFREQ
+  double truth[3];
+  sim_getPose(truth);
+  for (int j = 0; j < 3; j++)
+    rec[s].truth[k][j] = truth[j];
+#endif
+  for (int i = 0; i < numAngles; i++)
+    rec[s].cm[k][i] = scan_cm[i];
+}
+
+void restore(int s, int k)
+{
+  for (int i = 0; i < numAngles; i++)
+    scan_cm[i] = rec[s].cm[k][i];
+}
+
+int main()
+{
+  // Record the route
+  botSetMaxSpeed(200);
+  setPose(0, 0, 0);
+  for (int s = 0; s < STOPS; s++) {
+    if (route[s][0]) botTurn(route[s][0] * M_PI / 180.0);
+    if (route[s][1]) botMove(route[s][1]);
+    record(s, 0);
+    botTurn(M_PI);
+    record(s, 1);
+    botTurn(-M_PI);
+  }
+  print("RelocBench: %d stops, %d beams per scan%c\n", STOPS, numAngles, CLREOL);
+
+  // Map from the first time round
+  mapClear();
+  for (int s = 0; s < STOPS / 2; s++) {
+    for (int k = 0; k < 2; k++) {
+      odomX = rec[s].x;
+      odomY = rec[s].y;
+      odomTheta = rec[s].theta[k];
+#ifdef SIM_CLKFREQ
+      odomX = rec[s].truth[k][0] * 65536.0;
+      odomY = rec[s].truth[k][1] * 65536.0;
+      odomTheta = bam_fromRadians(rec[s].truth[k][2]);
+#endif
+      restore(s, k);
+      mapScan();
+    }
+  }
+
+  // Relocalize at every stop from nothing, with one sweep and with two.
+  // Only the turn between the sweeps comes from odometry.
+  for (int sweeps = 1; sweeps <= 2; sweeps++) {
+    unsigned int tMax = 0, tSum = 0, t;
+    int hits = 0, nodes = 0;
+    float sum = 0;
+    for (int s = 0; s < STOPS; s++) {
+      float pose[3];
+      relocClear();
+      for (int k = 0; k < sweeps; k++) {
+        odomTheta = rec[s].theta[k] - rec[s].theta[0];
+        restore(s, k);
+        relocAddScan();
+      }
+      t = benchNow();
+      relocSearch(pose);
+      t = benchNow() - t;
+      tSum += t;
+      if (t > tMax) tMax = t;
+      nodes += relocNodes;
+#ifdef SIM_CLKFREQ
+      float *truth = rec[s].truth[sweeps - 1];
+      float e = error(pose, truth), a = turnError(pose[2], truth[2]);
+      if (e < RELOC_HIT_MM && a < RELOC_HIT_DEG) hits++;
+      sum += e;
+#endif
+    }
+    print("%d sweep%s  %6d nodes (1/%d of exhaustive)", sweeps, sweeps > 1 ? "s" : " ",
+          nodes / STOPS, (360 / RELOC_STEP) * LF_SIZE * LF_SIZE / (nodes / STOPS));
+#ifdef SIM_CLKFREQ
+    print("  %2d/%d found  mean error %4d mm", hits, STOPS, (int)(sum / STOPS));
+#endif
+    print("  mean %8d  max %8d %s%c\n", tSum / STOPS, tMax, BENCH_UNITS, CLREOL);
+  }
+  relocBudget();
+  return 0;
+}
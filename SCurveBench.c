@@ -0,0 +1,138 @@
+/*
+  SCurveBench.c
+  --------
+  Drive a Tester.c style sequence, moves each followed by a turn, three
+  ways:
+
+  - botMove() and botTurn(), which stop dead and drive_goto() each step;
+  - botMove() and botTurn() again with the drive cog (motion.c) running,
+    so each step goes through its queue and follows an S-curve profile
+    (scurve.c), but still waits for the last to be done;
+  - queued for the drive cog, which overlaps each step with the next
+    instead of stopping between them.
+
+  Reports the time each took and where the bot ended up against where
+  it should have. For the queue it also checks mqPredictMs: from when
+  the last step is queued, each tick's prediction of when the queue will
+  be done has to be within SCB_SLACK ms of when it was, or the bench
+  says so and fails.
+
+  On the host (built against sim/) the true pose is reported too. On
+  the ActivityBot give it a metre or so of room.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "scurve.h"                           // Jerk-limited motion profiles
+#include "motion.h"                           // Motion command queue
+
+#define SCB_SLACK  100                        // ms mqPredictMs may be off by
+
+// --- Steps: mm to move, then degrees to turn
+int steps[][2] = {{400, -90}, {300, 90}, {150, 90}, {60, -90}, {200, 180}};
+#define STEPS  ((int)(sizeof(steps) / sizeof(*steps)))
+
+float expect[3];
+
+void start()
+{
+#ifdef SIM_CLKFREQ
+  sim_setPose(0, 300, 0);
+#endif
+  setPose(0, 300, 0);
+}
+
+void report(char *name, unsigned int t)
+{
+  updatePose();
+  print("%-12s %5d ms", name, t / (CLKFREQ / 1000));
+  print("  pose (%4d, %4d, %4d deg)", (int)botP[0], (int)botP[1], (int)(botP[2] * 180 / M_PI));
+#ifdef SIM_CLKFREQ
+  double truth[3];
+  sim_getPose(truth);
+  print("  off by %2d mm %d deg", (int)sqrt(pow(truth[0] - expect[0], 2.0) + pow(truth[1] - expect[1], 2.0)),
+        (int)(remainder(truth[2] - expect[2], 2 * M_PI) * 180 / M_PI));
+#endif
+  print("%c\n", CLREOL);
+}
+
+void sequence()
+{
+  for (int i = 0; i < STEPS; i++) {
+    botMove(steps[i][0]);
+    updatePose();
+    botTurn(steps[i][1] * M_PI / 180);
+    updatePose();
+  }
+}
+
+int main()
+{
+  unsigned int t, queued = 0;
+  int ms, soon = 0x7fffffff, late = 0, at;
+
+  // Where the sequence should end
+  expect[0] = 0;
+  expect[1] = 300;
+  expect[2] = 0;
+  for (int i = 0; i < STEPS; i++) {
+    expect[0] += steps[i][0] * cos(expect[2]);
+    expect[1] += steps[i][0] * sin(expect[2]);
+    expect[2] += steps[i][1] * M_PI / 180;
+  }
+  print("SCurveBench: %d moves and turns, ramp %d ticks/s per 20 ms, jerk over %d ms%c\n",
+        STEPS, rampStep, SC_JERK_MS, CLREOL);
+
+  // One at a time
+  start();
+  t = CNT;
+  sequence();
+  report("botMove()", CNT - t);
+
+  // One at a time, through the queue
+  start();
+  mqStart();
+  t = CNT;
+  sequence();
+  report("via queue", CNT - t);
+
+  // Queued and overlapped
+  start();
+  t = CNT;
+  for (int i = 0; i < STEPS * 2 || mqPending(); ) {
+    // Queue the steps as there is room
+    if (i < STEPS * 2 && (i % 2 ? mqTurn(steps[i / 2][1] * M_PI / 180) : mqMove(steps[i / 2][0]))) {
+      i++;
+      queued = CNT;
+    }
+    // Once the drive cog has had a tick to see the last of them, note
+    // when it says it will be done
+    if (i == STEPS * 2 && CNT - queued > 2 * MQ_TICK_MS * (CLKFREQ / 1000) && mqPending()) {
+      at = (CNT - t) / (CLKFREQ / 1000) + mqPredictMs;
+      if (at < soon) soon = at;
+      if (at > late) late = at;
+    }
+    updatePose();
+    pause(20);
+  }
+  ms = (CNT - t) / (CLKFREQ / 1000);
+  report("queued", CNT - t);
+  mqStop();
+  print("mqPredictMs: done at %d to %d ms, was %d%c\n", soon, late, ms, CLREOL);
+  if (soon < ms - SCB_SLACK || late > ms + SCB_SLACK) {
+    print("mqPredictMs: off by more than %d ms%c\n", SCB_SLACK, CLREOL);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*
+  ScanBench.c
+  --------
+  Measure full PING))) sweeps per second for a few scan patterns, each
+  swept one way only and in serpentine order.
+
+  On the host (built against sim/) all six patterns take about 90
+  simulated seconds, more than the sim's default 60, so run it with:
+    SIM_SECONDS=120 ./ScanBench
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include "simpletools.h"                      // Include simple tools
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+
+#define SWEEPS  6
+
+scanPattern p;
+
+void measure(char *name)
+{
+  // Sweep pattern p a few times, first one way only and then serpentine
+  float rate[2];
+
+  for (int order = SCAN_FORWARD; order >= SCAN_SERPENTINE; order--) {
+    p.order = order;
+    pingScanPattern(&p);
+    for (int i = 0; i < SWEEPS; i++)
+      pingScan();
+    rate[order] = scanPatternRate(&p);
+  }
+  print("%-24s %2d beams  %5.2f scans/s one way  %5.2f scans/s serpentine%c\n",
+        name, p.count, rate[SCAN_FORWARD], rate[SCAN_SERPENTINE], CLREOL);
+}
+
+int main()
+{
+  int wander[] = {-90, 90, 0};
+  int front[] = {-90, -45, -20, -10, 0, 10, 20, 45, 90};
+
+  scanPatternRange(&p, -90, 90, 10);
+  measure("-90..90 by 10 (default)");
+  scanPatternRange(&p, -90, 90, 5);
+  measure("-90..90 by 5");
+  scanPatternRange(&p, -90, 90, 30);
+  measure("-90..90 by 30");
+  scanPatternRange(&p, -30, 30, 10);
+  measure("-30..30 by 10");
+  scanPatternSet(&p, front, sizeof(front) / sizeof(*front));
+  measure("front-weighted");
+  scanPatternSet(&p, wander, sizeof(wander) / sizeof(*wander));
+  measure("-90, 0, 90 (Wander)");
+  return 0;
+}
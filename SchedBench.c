@@ -0,0 +1,126 @@
+/*
+  SchedBench.c
+  --------
+  How steady is the control loop's period, paced by pause(100) after
+  the work, against sched.c, and how fast can sched.c run it?
+
+  The work is a stand-in for the real loop's: an act step that takes
+  ACT_US, a sense step that takes SENSE_MIN to SENSE_MAX ms (a PING)))
+  echo, or its timeout), and a print step that takes up to SHOW_MAX ms
+  every SHOW_MS. The pause(100) loop does all three, then pauses; the
+  scheduler runs each as a task at its own period. For each, over
+  RUN_MS, it reports how many times act ran against how many it
+  should have and the mean and worst error of act's period.
+
+  Then it runs the scheduler with act and sense at shorter and shorter
+  periods and reports overruns and dropped releases, to show where the
+  loop stops keeping up.
+
+  No bot needed.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <stdlib.h>                           // Needed for rand()
+
+#include "simpletools.h"                      // Include simple tools
+
+#include "sched.h"                            // Fixed-rate task scheduler
+
+#define PERIOD_MS   100                       // Act period asked for
+#define ACT_US      500
+#define SENSE_MIN   2                         // ms
+#define SENSE_MAX   19                        // ms; PING))) timeout
+#define SHOW_MS     500
+#define SHOW_MAX    30                        // ms
+#define RUN_MS      20000
+
+unsigned int lastAct;
+int acts;
+float errSum, errMax;
+int periodMs = PERIOD_MS;
+
+void busy(int us)
+{
+  // Stand in for us of work
+  waitcnt(CNT + us * (CLKFREQ / 1000000));
+}
+
+void act()
+{
+  unsigned int now = CNT;
+  if (acts > 0) {
+    float e = (float)(int)(now - lastAct) / (CLKFREQ / 1000) - periodMs;
+    if (e < 0) e = -e;
+    errSum += e;
+    if (e > errMax) errMax = e;
+  }
+  lastAct = now;
+  acts++;
+  busy(ACT_US);
+}
+
+void sense() { busy(1000 * (SENSE_MIN + rand() % (SENSE_MAX - SENSE_MIN + 1))); }
+void show()  { busy(1000 * (rand() % (SHOW_MAX + 1))); }
+
+void start()
+{
+  srand(1);
+  acts = 0;
+  errSum = errMax = 0;
+}
+
+void result(char *name)
+{
+  print("%-16s act ran %4d of %4d  period error mean %5.1f ms, worst %5.1f ms%c\n", name,
+        acts, RUN_MS / periodMs, acts > 1 ? errSum / (acts - 1) : 0.0, errMax, CLREOL);
+}
+
+int main()
+{
+  unsigned int until, lastShow;
+  int rates[] = {50, 40, 30, 25, 20};
+
+  print("SchedBench: act every %d ms, sense %d-%d ms, print up to %d ms every %d ms%c\n",
+        PERIOD_MS, SENSE_MIN, SENSE_MAX, SHOW_MAX, SHOW_MS, CLREOL);
+
+  // --- The loop as it was
+  start();
+  until = CNT + RUN_MS * (CLKFREQ / 1000);
+  lastShow = CNT;
+  while ((int)(until - CNT) > 0) {
+    sense();
+    act();
+    if ((int)(CNT - lastShow) >= SHOW_MS * (CLKFREQ / 1000)) {
+      show();
+      lastShow = CNT;
+    }
+    pause(PERIOD_MS);
+  }
+  result("pause(100)");
+
+  // --- The same work, scheduled
+  start();
+  schAdd("act", act, PERIOD_MS);
+  schAdd("sense", sense, PERIOD_MS);
+  schAdd("show", show, SHOW_MS);
+  schRun(RUN_MS);
+  result("sched.c");
+  schReport();
+
+  // --- Faster
+  print("%c\n", CLREOL);
+  for (int i = 0; i < (int)(sizeof(rates) / sizeof(*rates)); i++) {
+    periodMs = rates[i];
+    schTasks[0].period = schTasks[1].period = periodMs * (CLKFREQ / 1000);
+    start();
+    schRun(RUN_MS);
+    print("act, sense %2d ms: over %3d/%3d, dropped %3d/%3d, act worst late %5d us%c\n", periodMs,
+          schTasks[0].overruns, schTasks[1].overruns, schTasks[0].dropped, schTasks[1].dropped,
+          schUs(schTasks[0].lateMax), CLREOL);
+  }
+  return 0;
+}
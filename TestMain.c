@@ -17,6 +17,31 @@
 #include "sense.h"                            // Manage sensors in use on the ActivityBot
 #include "move.h"                             // Move the ActivityBot around
 #include "slam.h"                             // Localization, transforms, and Mapping
+#include "plan.h"                             // Planning
+#include "sched.h"                            // Fixed-rate task scheduler
+
+float goal[] = {400.0, 200.0, 0.0};
+sensorData seen;                              // Latest readings from the sensor cog
+
+// --- The loop's steps, each run at its own rate by sched.c. The sensor
+// --- cog does the waiting on the servo and the PING))); sense() only
+// --- takes a copy of what it last published. With the servo the cog's,
+// --- nothing sweeps scan_cm[], so makePlan() steers for the goal alone.
+void sense()    { sensorRead(&seen); }
+void estimate() { updatePose(); }
+void think()    { makePlan(goal); }
+void act()      { executePlan(plan); }
+
+void show()
+{
+  print("%c", HOME);
+  print("detectLeft  = %d %c\n", seen.detectLeft, CLREOL);
+  print("pingLeft  = %d %c\n", seen.pingLeft, CLREOL);
+  print("detectRight = %d %c\n", seen.detectRight, CLREOL);
+  print("pingRight = %d %c\n", seen.pingRight, CLREOL);
+  print("pingFront = %d %c\n", seen.pingFront, CLREOL);
+  schReport();
+}
 
 int main()                                    // Main function
 {
@@ -24,31 +49,13 @@ int main()                                    // Main function
   freqout(4, 500, 3000);                      // Speaker tone: 0.5 s @ 3 kHz, 0.25 s @ 3.5 kHz
   freqout(4, 250, 3500);
 
-  float goal[] = {400.0, 200.0, 0.0};
-  float plan[2];
-   
-  while(1)
-  {
-    // Add main loop code here.
-    print("%c", HOME);
-
-    updateSensor();
-    //pingScan();
-    updatePose();
-    
-    print("detectLeft  = %d %c\n", detectLeft, CLREOL);
-    print("pingLeft  = %d %c\n", pingLeft, CLREOL);
-    print("detectRight = %d %c\n", detectRight, CLREOL);
-    print("pingRight = %d %c\n", pingRight, CLREOL);
-    for (int i=0; i < numAngles; i++) {
-      print("scanAngle = %d, scan_cm = %d %c\n", scanAngle[i], scan_cm[i], CLREOL);
-    }
-
-    makePlan(plan);
-    
-    executePlan(plan);
-
-    pause(100);
-    
-  }  // end of while (1)
-} // End of main()
\ No newline at end of file
+  startSensor();
+  sensorSetRate(10);
+
+  schAdd("estimate", estimate, 50);
+  schAdd("sense", sense, 100);
+  schAdd("act", act, 100);
+  schAdd("plan", think, 200);
+  schAdd("show", show, 500);
+  schRun(0);
+} // End of main()
@@ -0,0 +1,110 @@
+/*
+  VfhBench.c
+  --------
+  Drive to a few goals with VFH+ steering from vfh.c: every control tick
+  the bot reads what it can of the PING))) sweep and vfhSteer() picks a
+  heading and speed from the goal and the latest ranges. Reports how
+  long each goal took, the mean speed, how many ticks the bot spent
+  stopped (turning on the spot), and what a tick of steering costs.
+
+  On the host (built against sim/) each goal starts from the same spot,
+  west of the two boxes, and also reports the closest the bot came to a
+  wall and any collisions. On the ActivityBot the goals are relative to
+  wherever it starts; give it room.
+
+  On the host the four goals take about 80 simulated seconds, and up to
+  140 with wheel slip, more than the sim's default 60:
+    SIM_SECONDS=200 ./VfhBench
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simple tools
+#include "bench.h"                            // Timing for benchmarks
+#include "abdrive.h"                          // Include abdrive header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "vfh.h"                              // Vector Field Histogram steering
+
+#define TICK_MS     50                        // Control tick
+#define GIVE_UP_MS  60000                     // Per goal
+#define CLOSE_MM    50                        // Goal reached
+
+// --- Goals (mm, world frame), each from (0, -150) facing +x
+float goals[][2] = {
+  {1500, -150}, {1700, 900}, {1800, 200}, {600, 900}
+};
+#define GOALS  ((int)(sizeof(goals) / sizeof(*goals)))
+
+scanPattern sweep;
+
+int main()
+{
+  unsigned int tSteer = 0, calls = 0;
+
+  scanPatternRange(&sweep, -90, 90, 15);
+  pingScanPattern(&sweep);
+  print("VfhBench: %d goals, %d beams per sweep, %d ms ticks%c\n",
+        GOALS, numAngles, TICK_MS, CLREOL);
+
+  for (int g = 0; g < GOALS; g++) {
+    int ms = 0, hit = 0, stopped = 0;
+    float d, nearest = 10000, travel = 0, last[2] = {0, -150};
+#ifdef SIM_CLKFREQ
+    int bumps = sim_collisions();
+    sim_setPose(0, -150, 0);
+#endif
+    setPose(0, -150, 0);
+    for (int i = 0; i < numAngles; i++)
+      scan_cm[i] = 0;
+    vfhClear();
+    pingScanStart();
+    do {
+      unsigned int t;
+      updatePose();
+      vfhAddBeam(pingScanPoll());
+      if (pingScanComplete()) pingScanStart();
+
+      t = benchNow();
+      vfhSteer(goals[g]);
+      tSteer += benchNow() - t;
+      calls++;
+      if (botSpeed == 0) stopped++;
+      travel += sqrt(pow(botP[0] - last[0], 2.0) + pow(botP[1] - last[1], 2.0));
+      last[0] = botP[0];
+      last[1] = botP[1];
+#ifdef SIM_CLKFREQ
+      double truth[3];
+      sim_getPose(truth);
+      double c = sim_clearance(truth[0], truth[1]);
+      if (c < nearest) nearest = c;
+#endif
+      pause(TICK_MS);
+      ms += TICK_MS;
+      d = sqrt(pow(goals[g][0] - botP[0], 2.0) + pow(goals[g][1] - botP[1], 2.0));
+      hit = d < CLOSE_MM;
+    } while (!hit && ms < GIVE_UP_MS);
+    botSetVW(0, 0);
+    while (!pingScanComplete())
+      pingScanPoll();
+
+    print("goal (%5d,%5d)  %s in %5d ms  %4d mm off  %3d mm/s  %3d ticks stopped",
+          (int)goals[g][0], (int)goals[g][1], hit ? "reached" : "missed ", ms, (int)d,
+          (int)(travel * 1000 / ms), stopped);
+#ifdef SIM_CLKFREQ
+    print("  nearest wall %4d mm  %d collisions", (int)nearest, sim_collisions() - bumps);
+#endif
+    print("%c\n", CLREOL);
+  }
+  print("vfh: %d %s per tick%c\n", tSteer / calls, BENCH_UNITS, CLREOL);
+  return 0;
+}
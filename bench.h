@@ -0,0 +1,19 @@
+//   Timing for the benchmark programs
+//
+//   benchNow() is a time stamp to time code with, in BENCH_UNITS: CNT
+//   cycles on the Propeller, and on the host (sim/) the CPU time of the
+//   calling thread in ns, so the simulated cogs don't count. Both are
+//   32 bits and wrap; take differences, and keep the spans timed under
+//   4.29 s on the host and 53 s on the Propeller.
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#ifdef SIM_CLKFREQ
+#define BENCH_UNITS   "ns"
+#define benchNow()    sim_ns()
+#else
+#define BENCH_UNITS   "cycles"
+#define benchNow()    CNT
+#endif
+
+#endif
@@ -23,5 +23,6 @@
 #define PINGBIAS    -70
 #define LSERVOBIAS  0
 #define RSERVOBIAS  0
+#define PINGOFFSET  60          // PING))) servo axis ahead of the wheel axle (mm)
 
 // 
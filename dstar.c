@@ -0,0 +1,384 @@
+/*
+  dstar.c
+
+  Grid path planning for the ActivityBot with Koenig and Likhachev's
+  D* Lite. The plan runs backward from the goal, so as the bot moves and
+  the map fills in, only the cells whose path cost a change can reach
+  are searched again, not the whole grid.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  The planner's cells are the likelihood field's (field.c), 128 mm
+  square, in a DS_SIZE x DS_SIZE window at the middle of the field. A
+  cell is a wall if the field says so, tight if it is next to one, and
+  clear otherwise. A step to any of the eight neighbours costs DS_STEP
+  across or DS_DIAG diagonally, DS_TIGHT more into a tight cell, and
+  can't be made into a wall. The octile distance in the same units is
+  the heuristic. Leaving a wall is allowed, so a bot that has strayed
+  next to one (which the field may call a wall) still has a way out.
+
+  Memory is what keeps this small enough for hub RAM next to the map:
+
+  - g and rhs are a byte a cell, DS_INF meaning no path. A path costing
+    more than that is no path either: about 100 cells, which is more
+    than a 32 x 32 window needs.
+  - The kind of each cell is two bits.
+  - The open list is a binary heap of DS_OPEN 32-bit entries: the two
+    keys and the cell packed so that one compare orders them. Entries
+    are never looked up or removed; a cell that changes is pushed again,
+    and an entry that no longer matches its cell is skipped when it comes
+    off the heap. If the heap fills, it is rebuilt from the cells still
+    waiting, each once.
+
+  That is 3.3 KB for DS_BITS of 5, or 10 KB for 6.
+
+  dsReplan() brings the field up to date and looks for changes only in
+  the box of field cells lfUpdate() recomputed, so nothing else should
+  call lfUpdate() while a plan is in use.
+
+*/
+#include <math.h>                             // Needed for floor()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "field.h"                            // Likelihood field
+#include "dstar.h"                            // Function declarations
+
+#define DS_OFF        (LF_SIZE / 2 - DS_SIZE / 2)   // Field cell of planner cell 0
+#define DS_MASK       (DS_CELLS - 1)
+#define DS_K2_SHIFT   (2 * DS_BITS)                 // Open list entry: k1 | k2 | cell
+#define DS_K1_SHIFT   (DS_K2_SHIFT + 8)
+#define DS_KM_MAX     ((1 << (32 - DS_K1_SHIFT)) - 4 * DS_INF)
+
+// --- Kinds of cell
+#define DS_CLEAR      0
+#define DS_NEAR       1
+#define DS_WALL       2
+
+unsigned int dsTicks = 0;
+int dsExpanded = 0;
+int dsChanged = 0;
+int dsOverflows = 0;
+
+static unsigned char dsG[DS_CELLS];
+static unsigned char dsRhs[DS_CELLS];
+static unsigned char dsKinds[DS_CELLS / 4];
+static unsigned int dsOpen[DS_OPEN];
+static int dsOpenN = 0;
+static int dsStart = -1, dsLast = -1, dsGoalCell = -1, dsKm = 0;
+static float dsGoal[2];
+
+// --- The eight neighbours, odd ones diagonal
+static const signed char dsDx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const signed char dsDy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+int _dsKind(int s)
+{
+  return (dsKinds[s >> 2] >> ((s & 3) << 1)) & 3;
+}
+
+void _dsSetKind(int s, int k)
+{
+  int shift = (s & 3) << 1;
+  dsKinds[s >> 2] = (dsKinds[s >> 2] & ~(3 << shift)) | (k << shift);
+}
+
+int _dsClassify(int x, int y)
+{
+  // Kind of planner cell (x,y) as the field has it now
+  int d = lfCells[((y + DS_OFF) << LF_BITS) | (x + DS_OFF)];
+  return d == 0 ? DS_WALL : d <= LF_DIAG ? DS_NEAR : DS_CLEAR;
+}
+
+int _dsCell(float x, float y)
+{
+  // Planner cell at world (x,y) in mm, or -1 outside the window
+  int cx = ((int)floor(x) >> (MAP_CELL_SHIFT + LF_SHIFT)) + LF_SIZE/2 - DS_OFF;
+  int cy = ((int)floor(y) >> (MAP_CELL_SHIFT + LF_SHIFT)) + LF_SIZE/2 - DS_OFF;
+  if ((unsigned int)cx >= DS_SIZE || (unsigned int)cy >= DS_SIZE) return -1;
+  return (cy << DS_BITS) | cx;
+}
+
+int _dsNeighbour(int s, int dir)
+{
+  // Cell next to s in direction dir, or -1 outside the window
+  int x = (s & (DS_SIZE - 1)) + dsDx[dir], y = (s >> DS_BITS) + dsDy[dir];
+  if ((unsigned int)x >= DS_SIZE || (unsigned int)y >= DS_SIZE) return -1;
+  return (y << DS_BITS) | x;
+}
+
+int _dsStepCost(int v, int dir)
+{
+  // Cost of a step in direction dir into cell v
+  int k = _dsKind(v);
+  if (k == DS_WALL) return DS_INF;
+  return ((dir & 1) ? DS_DIAG : DS_STEP) + (k == DS_NEAR ? DS_TIGHT : 0);
+}
+
+int _dsH(int a, int b)
+{
+  // Octile distance between cells a and b
+  int dx = (a & (DS_SIZE - 1)) - (b & (DS_SIZE - 1));
+  int dy = (a >> DS_BITS) - (b >> DS_BITS);
+  if (dx < 0) dx = -dx;
+  if (dy < 0) dy = -dy;
+  return dx < dy ? DS_DIAG * dx + DS_STEP * (dy - dx) : DS_DIAG * dy + DS_STEP * (dx - dy);
+}
+
+unsigned int _dsKey(int s)
+{
+  // Open list entry for cell s: [min(g, rhs) + h + km; min(g, rhs)]
+  unsigned int m = dsG[s] < dsRhs[s] ? dsG[s] : dsRhs[s];
+  return ((m + _dsH(dsStart, s) + dsKm) << DS_K1_SHIFT) | (m << DS_K2_SHIFT) | s;
+}
+
+void _dsSift(int i)
+{
+  // Move entry i down the heap to where it belongs
+  unsigned int e = dsOpen[i];
+  for (;;) {
+    int c = 2 * i + 1;
+    if (c >= dsOpenN) break;
+    if (c + 1 < dsOpenN && dsOpen[c + 1] < dsOpen[c]) c++;
+    if (dsOpen[c] >= e) break;
+    dsOpen[i] = dsOpen[c];
+    i = c;
+  }
+  dsOpen[i] = e;
+}
+
+void _dsCompact()
+{
+  // The heap is full: rebuild it from the cells still inconsistent, each
+  // once, with their keys as they are now
+  unsigned char seen[DS_CELLS / 8];
+  int n = 0;
+  for (int i = 0; i < DS_CELLS / 8; i++)
+    seen[i] = 0;
+  for (int i = 0; i < dsOpenN; i++) {
+    int s = dsOpen[i] & DS_MASK;
+    if (dsG[s] == dsRhs[s] || (seen[s >> 3] & (1 << (s & 7)))) continue;
+    seen[s >> 3] |= 1 << (s & 7);
+    dsOpen[n++] = _dsKey(s);
+  }
+  dsOpenN = n;
+  for (int i = n / 2 - 1; i >= 0; i--)
+    _dsSift(i);
+}
+
+void _dsPush(unsigned int e)
+{
+  int i;
+  if (dsOpenN == DS_OPEN) _dsCompact();
+  if (dsOpenN == DS_OPEN) {
+    dsOverflows++;
+    return;
+  }
+  i = dsOpenN++;
+  while (i > 0 && dsOpen[(i - 1) / 2] > e) {
+    dsOpen[i] = dsOpen[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  dsOpen[i] = e;
+}
+
+void _dsPop()
+{
+  dsOpen[0] = dsOpen[--dsOpenN];
+  if (dsOpenN > 0) _dsSift(0);
+}
+
+void _dsUpdate(int u)
+{
+  // Recompute rhs of cell u from its neighbours, and put it on the open
+  // list if that leaves it inconsistent
+  if (u != dsGoalCell) {
+    int best = DS_INF;
+    for (int dir = 0; dir < 8; dir++) {
+      int v = _dsNeighbour(u, dir), c;
+      if (v < 0 || dsG[v] == DS_INF) continue;
+      c = _dsStepCost(v, dir) + dsG[v];
+      if (c < best) best = c;
+    }
+    dsRhs[u] = best;
+  }
+  if (dsG[u] != dsRhs[u]) _dsPush(_dsKey(u));
+}
+
+void _dsCompute()
+{
+  // Expand cells until the bot's cell is consistent and nothing on the
+  // open list could still lower it
+  while (dsOpenN > 0) {
+    unsigned int top = dsOpen[0], k;
+    int s = top & DS_MASK;
+    if ((top >> DS_K2_SHIFT) >= (_dsKey(dsStart) >> DS_K2_SHIFT) && dsG[dsStart] == dsRhs[dsStart])
+      break;
+    _dsPop();
+    if (dsG[s] == dsRhs[s]) continue;                 // Stale entry
+    k = _dsKey(s);
+    if ((top >> DS_K2_SHIFT) < (k >> DS_K2_SHIFT)) {  // Key out of date
+      _dsPush(k);
+      continue;
+    }
+    dsExpanded++;
+    if (dsG[s] > dsRhs[s]) {
+      dsG[s] = dsRhs[s];
+    } else {
+      dsG[s] = DS_INF;
+      _dsUpdate(s);
+    }
+    for (int dir = 0; dir < 8; dir++) {
+      int u = _dsNeighbour(s, dir);
+      if (u >= 0) _dsUpdate(u);
+    }
+  }
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void dsSetGoal(float goal[2])
+{
+  // Plan from scratch from the bot to goal (x,y) over the map as it is
+  unsigned int t = CNT;
+
+  lfUpdate();
+  for (int y = 0; y < DS_SIZE; y++)
+    for (int x = 0; x < DS_SIZE; x++)
+      _dsSetKind((y << DS_BITS) | x, _dsClassify(x, y));
+  for (int s = 0; s < DS_CELLS; s++)
+    dsG[s] = dsRhs[s] = DS_INF;
+  dsOpenN = 0;
+  dsKm = 0;
+  dsExpanded = 0;
+  dsChanged = 0;
+  dsGoal[0] = goal[0];
+  dsGoal[1] = goal[1];
+  dsGoalCell = _dsCell(goal[0], goal[1]);
+  dsStart = dsLast = _dsCell(botP[0], botP[1]);
+  if (dsGoalCell >= 0 && dsStart >= 0) {
+    dsRhs[dsGoalCell] = 0;
+    _dsPush(_dsKey(dsGoalCell));
+    _dsCompute();
+  }
+  dsTicks = CNT - t;
+}
+
+int dsReplan()
+{
+  // Bring the plan up to date with where the bot is and with the map,
+  // repairing it around any cells whose kind changed. Returns how many
+  // did.
+  unsigned int t = CNT;
+  int s = _dsCell(botP[0], botP[1]);
+
+  dsExpanded = 0;
+  dsChanged = 0;
+  if (dsGoalCell < 0 || dsStart < 0) return 0;
+  if (s >= 0) dsStart = s;
+
+  lfUpdate();
+  if (lfUpdated) {
+    int x0 = lfBox[0] - DS_OFF, y0 = lfBox[1] - DS_OFF;
+    int x1 = lfBox[2] - DS_OFF, y1 = lfBox[3] - DS_OFF;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > DS_SIZE - 1) x1 = DS_SIZE - 1;
+    if (y1 > DS_SIZE - 1) y1 = DS_SIZE - 1;
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        int v = (y << DS_BITS) | x, k = _dsClassify(x, y);
+        if (k == _dsKind(v)) continue;
+
+        // Keys already on the open list were made from dsLast; the
+        // heuristic from here is at most km less than from there
+        if (dsChanged++ == 0) {
+          dsKm += _dsH(dsLast, dsStart);
+          dsLast = dsStart;
+        }
+        _dsSetKind(v, k);
+
+        // Only steps into v cost something different
+        for (int dir = 0; dir < 8; dir++) {
+          int u = _dsNeighbour(v, dir);
+          if (u >= 0) _dsUpdate(u);
+        }
+      }
+    }
+  }
+
+  // km only grows; start over before it outgrows its bits in a key
+  if (dsKm > DS_KM_MAX) {
+    int changed = dsChanged;
+    dsSetGoal(dsGoal);
+    dsChanged = changed;
+    return changed;
+  }
+  _dsCompute();
+  dsTicks = CNT - t;
+  return dsChanged;
+}
+
+int dsNext(float way[2])
+{
+  // Put in way[] the point (mm) DS_AHEAD cells down the path from the
+  // bot, or the goal if that is nearer. Returns 0 if there is no path.
+  int s = dsStart;
+  if (dsGoalCell < 0 || dsStart < 0 || dsRhs[dsStart] == DS_INF) return 0;
+  for (int n = 0; n < DS_AHEAD && s != dsGoalCell; n++) {
+    int best = DS_INF, next = -1;
+    for (int dir = 0; dir < 8; dir++) {
+      int v = _dsNeighbour(s, dir), c;
+      if (v < 0 || dsG[v] == DS_INF) continue;
+      c = _dsStepCost(v, dir) + dsG[v];
+      if (c < best) {
+        best = c;
+        next = v;
+      }
+    }
+    if (next < 0) break;
+    s = next;
+  }
+  if (s == dsGoalCell) {
+    way[0] = dsGoal[0];
+    way[1] = dsGoal[1];
+  } else {
+    way[0] = ((s & (DS_SIZE - 1)) + DS_OFF - LF_SIZE/2) * LF_CELL + LF_CELL/2;
+    way[1] = ((s >> DS_BITS) + DS_OFF - LF_SIZE/2) * LF_CELL + LF_CELL/2;
+  }
+  return 1;
+}
+
+int dsCost()
+{
+  // Cost of the path from the bot (DS_STEP a cell across), or DS_INF if
+  // there is none
+  if (dsGoalCell < 0 || dsStart < 0) return DS_INF;
+  return dsRhs[dsStart];
+}
+
+void dsBudget()
+{
+  // Report what the planner costs in hub RAM and time
+  print("dstar: %d x %d cells, %d open entries, %d bytes%c\n", DS_SIZE, DS_SIZE, DS_OPEN,
+        (int)(sizeof(dsG) + sizeof(dsRhs) + sizeof(dsKinds) + sizeof(dsOpen)), CLREOL);
+  print("dstar: last plan %d cells expanded, %d changed, %d cycles, %d overflows%c\n",
+        dsExpanded, dsChanged, dsTicks, dsOverflows, CLREOL);
+}
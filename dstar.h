@@ -0,0 +1,37 @@
+//   D* Lite grid path planner for the ActivityBot
+//
+//   Plans a path over the likelihood field (field.c) from the bot to a
+//   goal, and as the map changes repairs only the part of the plan the
+//   changes reach. dsNext() gives a waypoint a few cells down the path
+//   for goTowardPose() to drive straight at. Include slam.h and field.h
+//   first.
+#ifndef _DSTAR_H_
+#define _DSTAR_H_
+
+#define DS_BITS       5             // log2(cells per side); 6 covers the whole map
+#define DS_SIZE       (1 << DS_BITS)
+#define DS_CELLS      (DS_SIZE * DS_SIZE)
+#define DS_OPEN       256           // Open list entries
+#define DS_AHEAD      3             // Cells down the path to the waypoint
+
+// --- Costs of a step, across and diagonally, and extra for a step into
+// --- a cell next to a wall. Path costs are bytes: DS_INF is no path.
+#define DS_STEP       2
+#define DS_DIAG       3
+#define DS_TIGHT      3
+#define DS_INF        255
+
+// --- The last plan or repair: CNT ticks, cells expanded, cells whose
+// --- cost changed; and open list entries dropped for want of room
+extern unsigned int dsTicks;
+extern int dsExpanded;
+extern int dsChanged;
+extern int dsOverflows;
+
+void dsSetGoal(float goal[2]);
+int  dsReplan();
+int  dsNext(float way[2]);
+int  dsCost();
+void dsBudget();
+
+#endif
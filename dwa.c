@@ -0,0 +1,318 @@
+/*
+  dwa.c
+
+  Dynamic Window Approach steering for the ActivityBot, after Fox,
+  Burgard and Thrun. abdrive ramps each wheel by at most rampStep
+  ticks/s every 20 ms and never past maxSpeed, so from the current
+  leftSpeed and rightSpeed only a small window of wheel speeds can be
+  reached by the next control tick. dwaSteer() tries DWA_SAMPLES speeds
+  per wheel across that window, rules out any that couldn't stop short
+  of an echo, scores the rest and sends the best through botSetVW().
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  Each pair of wheel speeds drives an arc of curvature
+  2 (R - L) / (W (R + L)), W the wheel spacing. The arcs are bent into
+  DWA_BENDS curvatures from straight to pivoting on one wheel, and the
+  points along each, every DWA_DS mm out to DWA_REACH, are tabled once.
+  Anything sharper than a pivot turns on the spot, which a round bot
+  can always do. A candidate is scored on
+
+    heading    how near it will face the goal after DWA_LOOK_MS
+    clearance  how far it can go along its arc before it comes within
+               DWA_RADIUS of an echo (once per curvature per tick), up to
+               the goal's range
+    speed      how fast it goes
+
+  each scaled to 0..1000 and weighted by DWA_W_HEAD, DWA_W_CLEAR and
+  DWA_W_SPEED. Only an echo the bot is closing on counts, so a bot that
+  has ended up too near one can still back off from it.
+
+  A turn on the spot goes nowhere, so its clearance is the most room
+  straight on from any heading it turns through, out to DWA_SPIN_DEG.
+  That is what gets the bot out of a dead end in front of the goal,
+  where every arc is ruled out and the heading term alone would hold it
+  still. Once it starts turning on the spot it keeps turning the same
+  way until an arc is taken; otherwise the heading term flips it back
+  and forth.
+
+  As in vfh.c, a sweep takes a second or more, so each beam is kept as
+  it lands, as a point in the world frame.
+
+*/
+#include <math.h>                             // Needed for sin(), cos(), atan2()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "dwa.h"                              // Function declarations
+
+#define DWA_WIDTH     105.8                   // mm; wheel spacing
+#define DWA_BENDS     13                      // Curvatures tabled, odd so one is straight
+#define DWA_DS        50                      // mm between points along an arc
+#define DWA_STEPS     (DWA_REACH / DWA_DS)
+#define DWA_SPIN      DWA_BENDS               // "Bend" of a turn on the spot
+#define DWA_SPIN_DEG  90                      // Widest turn on the spot looked through...
+#define DWA_SPIN_STEP 15                      // ... in steps of this many degrees
+
+// --- A beam as it landed: echo (mm, world frame), r 0 if none
+typedef struct {
+  short x, y, r;
+} dwaEcho;
+
+int dwaLeft = 0, dwaRight = 0;
+int dwaClear = 0;
+int dwaTried = 0, dwaRuled = 0;
+
+// --- dwaArc[b][j]: the point DWA_DS * (j + 1) mm along bend b, bot frame
+static short dwaArcX[DWA_BENDS][DWA_STEPS];
+static short dwaArcY[DWA_BENDS][DWA_STEPS];
+static int dwaReady = 0;
+static dwaEcho dwaBeams[SCAN_MAX];
+static int dwaHeld = 0;
+
+// --- This tick: echoes in the bot frame, and the clearance of each bend
+static short dwaX[SCAN_MAX], dwaY[SCAN_MAX];
+static int dwaD2[SCAN_MAX];
+static int dwaNear;
+static short dwaBendClear[DWA_BENDS];
+static int dwaSpinClear[2];
+static int dwaTurning = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _dwaInit()
+{
+  // Table the arcs: bend b has curvature (b - DWA_BENDS/2) / (DWA_BENDS/2)
+  // of a pivot on one wheel, 2 / W
+  for (int b = 0; b < DWA_BENDS; b++) {
+    float k = (b - DWA_BENDS / 2) * 2.0 / DWA_WIDTH / (DWA_BENDS / 2);
+    for (int j = 0; j < DWA_STEPS; j++) {
+      float s = DWA_DS * (j + 1);
+      dwaArcX[b][j] = round(k == 0 ? s : sin(k * s) / k);
+      dwaArcY[b][j] = round(k == 0 ? 0 : (1 - cos(k * s)) / k);
+    }
+  }
+  dwaReady = 1;
+}
+
+int _dwaBend(int l, int r)
+{
+  // Bend nearest the arc of wheel speeds l and r, or DWA_SPIN
+  int sum = l + r, d = r - l, h = DWA_BENDS / 2;
+  if (sum <= 0 || d > sum || -d > sum) return DWA_SPIN;
+  return h + (d * h + (d >= 0 ? sum / 2 : -sum / 2)) / sum;
+}
+
+int _dwaRay(int deg)
+{
+  // How far (mm) the bot could go straight on after turning on the spot
+  // by deg degrees before an echo is within DWA_RADIUS of it
+  int r2 = DWA_RADIUS * DWA_RADIUS;
+  int c = fx_cos(deg * BAM_PER_DEG), s = fx_sin(deg * BAM_PER_DEG);
+  for (int j = 0; j < DWA_STEPS; j++) {
+    int x = fx_mul(DWA_DS * (j + 1), c), y = fx_mul(DWA_DS * (j + 1), s);
+    for (int i = 0; i < dwaNear; i++) {
+      int dx = x - dwaX[i], dy = y - dwaY[i];
+      int d2 = dx*dx + dy*dy;
+      if (d2 < r2 && d2 < dwaD2[i]) return j * DWA_DS;
+    }
+  }
+  return DWA_REACH;
+}
+
+int _dwaSpin(int sign)
+{
+  // Clearance of a turn on the spot to the left (sign 1) or right (-1):
+  // the most room straight on from any heading it turns through, out to
+  // DWA_SPIN_DEG, as the turn is worth as much as the way out it finds
+  int *c = &dwaSpinClear[sign > 0];
+  if (*c >= 0) return *c;
+  *c = 0;
+  for (int deg = 0; deg <= DWA_SPIN_DEG; deg += DWA_SPIN_STEP) {
+    int r = _dwaRay(sign * deg);
+    if (r > *c) *c = r;
+  }
+  return *c;
+}
+
+void _dwaEchoes()
+{
+  // Echoes held, in the bot frame, that an arc could come near
+  unsigned int theta = bam_fromRadians(botP[2]);
+  int c = fx_cos(theta), s = fx_sin(theta);
+  int reach = DWA_REACH + DWA_RADIUS;
+  dwaNear = 0;
+  for (int i = 0; i < dwaHeld; i++) {
+    int dx, dy, x, y;
+    if (dwaBeams[i].r <= 0) continue;
+    dx = dwaBeams[i].x - (int)botP[0];
+    dy = dwaBeams[i].y - (int)botP[1];
+    x = fx_mul(dx, c) + fx_mul(dy, s);
+    y = fx_mul(dy, c) - fx_mul(dx, s);
+    if (x < -reach || x > reach || y < -reach || y > reach) continue;
+    dwaX[dwaNear] = x;
+    dwaY[dwaNear] = y;
+    dwaD2[dwaNear] = x*x + y*y;
+    dwaNear++;
+  }
+  for (int b = 0; b < DWA_BENDS; b++)
+    dwaBendClear[b] = -1;
+  dwaSpinClear[0] = dwaSpinClear[1] = -1;
+}
+
+int _dwaClearance(int b)
+{
+  // How far (mm) the bot can go along bend b before an echo is within
+  // DWA_RADIUS of it
+  int r2 = DWA_RADIUS * DWA_RADIUS;
+  if (dwaBendClear[b] >= 0) return dwaBendClear[b];
+  dwaBendClear[b] = DWA_REACH;
+  for (int j = 0; j < DWA_STEPS; j++) {
+    for (int i = 0; i < dwaNear; i++) {
+      int dx = dwaArcX[b][j] - dwaX[i], dy = dwaArcY[b][j] - dwaY[i];
+      int d2 = dx*dx + dy*dy;
+      if (d2 < r2 && d2 < dwaD2[i]) {
+        dwaBendClear[b] = j * DWA_DS;
+        return dwaBendClear[b];
+      }
+    }
+  }
+  return DWA_REACH;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void dwaClearBeams()
+{
+  // Forget the beams held, as after a long stop or a jump in the pose
+  dwaHeld = 0;
+}
+
+void dwaAddBeam(int i)
+{
+  // Keep beam i of scanAngle[]/scan_cm[], just landed (pingScanPoll()'s
+  // return; anything below 0 is ignored)
+  float a, r;
+  if (i < 0 || i >= SCAN_MAX) return;
+  while (dwaHeld <= i)
+    dwaBeams[dwaHeld++].r = 0;
+  a = botP[2] + scanAngle[i] * M_PI / 180.0;
+  r = scan_cm[i] * 10;
+  dwaBeams[i].r = 0;
+  if (r <= 0 || r >= MAP_RANGE) return;
+  r += PINGOFFSET;
+  dwaBeams[i].x = botP[0] + r * cos(a);
+  dwaBeams[i].y = botP[1] + r * sin(a);
+  dwaBeams[i].r = r;
+}
+
+void dwaSteer(float goal[2])
+{
+  // Pick the best wheel speeds in reach for goal (x,y) and drive them
+  int step = rampStep * DWA_TICK_MS / 20;
+  int brake = rampStep * 50 * 13 / 4;                 // mm/s/s
+  int vMax = maxSpeed * 13 / 4, best = -1, turning = 0;
+  float dx = goal[0] - botP[0], dy = goal[1] - botP[1];
+  float gx, gy, range = sqrt(dx*dx + dy*dy);
+  float c = cos(botP[2]), s = sin(botP[2]);
+
+  if (!dwaReady) _dwaInit();
+  _dwaEchoes();
+  gx = dx * c + dy * s;
+  gy = dy * c - dx * s;
+  dwaTried = 0;
+  dwaRuled = 0;
+
+  for (int i = 0; i < DWA_SAMPLES; i++) {
+    for (int j = 0; j < DWA_SAMPLES; j++) {
+      int l = leftSpeed + step * (2 * i - (DWA_SAMPLES - 1)) / (DWA_SAMPLES - 1);
+      int r = rightSpeed + step * (2 * j - (DWA_SAMPLES - 1)) / (DWA_SAMPLES - 1);
+      int v, b, clear, head, score, look;
+      float omega, turn, ex, ey, e;
+
+      if (l > maxSpeed) l = maxSpeed;
+      if (l < -maxSpeed) l = -maxSpeed;
+      if (r > maxSpeed) r = maxSpeed;
+      if (r < -maxSpeed) r = -maxSpeed;
+      v = (l + r) * 13 / 8;                           // mm/s
+      dwaTried++;
+
+      // Admissible: going forward (or turning on the spot, the same way as
+      // last time), able to stop short of the nearest echo on its arc,
+      // and not overshooting
+      omega = (r - l) * 3.25 / DWA_WIDTH;
+      turn = omega * DWA_LOOK_MS / 1000.0;
+      b = _dwaBend(l, r);
+      if (b != DWA_SPIN) clear = _dwaClearance(b);
+      else if (r == l) clear = _dwaRay(0);
+      else if (dwaTurning == (r > l ? -1 : 1)) clear = -1;
+      else clear = _dwaSpin(r > l ? 1 : -1);
+      if (clear < 0 || v < 0 || v * v > 2 * brake * clear || v > range + DWA_RADIUS) {
+        dwaRuled++;
+        continue;
+      }
+
+      // Room past the goal is no use
+      if (clear > range) clear = range;
+
+      // Where it will be and which way it will face after DWA_LOOK_MS
+      look = v * DWA_LOOK_MS / 1000 / DWA_DS;
+      if (b == DWA_SPIN || look == 0) {
+        ex = 0;
+        ey = 0;
+      } else {
+        if (look > DWA_STEPS) look = DWA_STEPS;
+        ex = dwaArcX[b][look - 1];
+        ey = dwaArcY[b][look - 1];
+      }
+      e = atan2(gy - ey, gx - ex) - turn;
+      while (e > M_PI) e -= M_2PI;
+      while (e < -M_PI) e += M_2PI;
+      head = 1000 - (int)(fabs(e) * 1000 / M_PI);
+
+      score = DWA_W_HEAD * head + DWA_W_CLEAR * clear * 1000 / DWA_REACH
+              + DWA_W_SPEED * v * 1000 / vMax;
+      if (best < 0 || score > best) {
+        best = score;
+        dwaLeft = l;
+        dwaRight = r;
+        dwaClear = clear;
+        turning = b != DWA_SPIN || r == l ? 0 : r > l ? 1 : -1;
+      }
+    }
+  }
+
+  // Nothing admissible: slow both wheels as hard as the ramp allows
+  if (best < 0) {
+    dwaLeft = leftSpeed > step ? leftSpeed - step : leftSpeed < -step ? leftSpeed + step : 0;
+    dwaRight = rightSpeed > step ? rightSpeed - step : rightSpeed < -step ? rightSpeed + step : 0;
+    dwaClear = 0;
+  }
+  dwaTurning = turning;
+  botSetVW((dwaLeft + dwaRight) * 3.25 / 2, (dwaRight - dwaLeft) * 3.25 / DWA_WIDTH);
+}
+
+void dwaBudget()
+{
+  // Report the hub RAM the tables take
+  print("dwa: %d bends x %d points, %d bytes%c\n", DWA_BENDS, DWA_STEPS,
+        (int)(sizeof(dwaArcX) + sizeof(dwaArcY) + sizeof(dwaBeams) + sizeof(dwaX)
+              + sizeof(dwaY) + sizeof(dwaD2) + sizeof(dwaBendClear)), CLREOL);
+}
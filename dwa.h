@@ -0,0 +1,32 @@
+//   Dynamic Window Approach steering for the ActivityBot
+//
+//   Each control tick, tries the wheel speeds the drive can reach before
+//   the next tick (given the ramp step and the speed limit) and keeps
+//   the one that best trades heading for the goal against clearance and
+//   speed. Pass each beam to dwaAddBeam() as pingScanPoll() lands it.
+#ifndef _DWA_H_
+#define _DWA_H_
+
+#define DWA_TICK_MS   50            // Control tick the window is sized for
+#define DWA_SAMPLES   5             // Speeds tried per wheel
+#define DWA_RADIUS    140           // mm; bot radius plus clearance
+#define DWA_REACH     600           // mm; clearance looked for along an arc
+#define DWA_LOOK_MS   1000          // Heading is judged this far ahead
+
+// --- Weights of heading, clearance and speed in the score
+#define DWA_W_HEAD    8
+#define DWA_W_CLEAR   5
+#define DWA_W_SPEED   3
+
+// --- The last choice: wheel speeds (ticks/s), its clearance (mm), and
+// --- candidates tried and ruled out
+extern int dwaLeft, dwaRight;
+extern int dwaClear;
+extern int dwaTried, dwaRuled;
+
+void dwaClearBeams();
+void dwaAddBeam(int i);
+void dwaSteer(float goal[2]);
+void dwaBudget();
+
+#endif
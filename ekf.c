@@ -0,0 +1,447 @@
+/*
+  ekf.c
+
+  Extended Kalman filter for the ActivityBot. The prediction step moves
+  the pose by the encoder ticks with the same chord-of-the-arc model as
+  odometry.c and grows the covariance by the wheel noise. The range step
+  corrects it with a PING))) reading of a known wall segment.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  ekfSense(): take each range from where the bot was
+                    when it was read, not where it is now
+  2026-10-17   1.2  Estimate both wheel scales, expect box corners and
+                    edge echoes out to 70 degrees, drop side pings and
+                    readings taken while turning; ekfInit() restarts
+                    the snapshot tracking; walls are measured from
+                    their own start, so nothing overflows
+
+  Covariance entries are Q16.16 with lengths in 16 mm units, so a
+  standard deviation of up to 2.9 m fits, and still resolves well under a
+  millimetre. A range is one scalar measurement: v = P H' is a vector, and
+  the update P -= v v' / S keeps P symmetric by construction. Only the
+  upper triangle is computed.
+
+  Wheel error isn't noise. Each wheel's travel per tick is off by a
+  steady fraction, so a straight run is an arc, and the heading error
+  grows with the distance, not its square root. Modelled as noise alone
+  the filter was soon sure of a heading 4 sigma out, gated out every
+  true reading, and ended further off than odometry. So the state also
+  holds the two wheel scales, as the right-left mismatch and the mean,
+  and a range that shows the pose drifting corrects them too. A
+  mismatch is only seen once the bot has turned, and is taken to be
+  within 4% (1 sigma) to start with.
+
+  PING))) hears the nearest surface anywhere in its cone, not what lies
+  along its axis. So a wall is expected at the perpendicular distance
+  when its normal is inside the 15 degree half cone, and otherwise where
+  the cone edge nearer the normal meets it, out to 70 degrees off the
+  normal; a wall's end inside the cone (a box corner) is expected where
+  it is. That also keeps H cheap: the normal (over the edge's cosine) or
+  the direction of the corner for position, and for heading the sensor
+  swinging on PINGOFFSET and the edge swinging with the bot. Of the
+  surfaces seen the nearest is used, and a reading more than 3 sigma from
+  its prediction is dropped as something else in the cone.
+
+  A sensor snapshot is up to a control period old by the time
+  ekfSense() applies it, and the bot has moved on. The 3 sigma gate
+  doesn't catch that: the error is a steady few centimetres on an
+  oblique wall, well inside it, and it pulled an exact pose off. So
+  the beam is swung back by the turn since the snapshot (in encoder
+  ticks), and the front range is shortened by the distance driven
+  since, to what it would read now. The snapshot's ticks are latched
+  after its pings, so one taken while turning is dropped, as the beam
+  was somewhere in the turn; and the side pings are never used, as they
+  were taken before the servo swung back to the front.
+
+  On the host sim (EkfBench, 12 seeds at each SIM_SLIP of 0.01, 0.02 and
+  0.03) the filter ends within 25 mm of the truth in 34 of the 36 runs,
+  where odometry ends 70 mm to a metre off. One more ends 0.5 m off,
+  against 0.8 m for odometry. The last, a bot whose wheels differ by
+  10%, is 37 degrees off before its first turn shows the mismatch, and
+  ends 1.1 m off against 0.6 m: the filter can make that much worse.
+
+*/
+#include <math.h>                             // Needed for sqrt(), for walls
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "ekf.h"                              // Function declarations
+
+// ActivityBot geometry, as in odometry.c
+#define HALF_TICK     106496        // 3.25/2 mm in Q16.16
+#define TURN_TICK     20997988      // 3.25/105.8 rad as a binary angle
+#define HALF_TURN     1007          // 3.25/105.8/2 rad in Q16.16
+#define INV_BASE      9911          // 16/105.8: 1/wheel spacing in 1/units
+#define INV_BASE2     1499          // ... squared
+#define EKF_SLIP_SHIFT 6            // Wheel mismatch unit: 1/64 of the travel
+
+// --- Noise. Each wheel travels with 1 sigma of 1/16 of the distance plus
+// --- 1/16 tick; a range is good to 30 mm (3.5 units^2).
+#define EKF_TICK_SIGMA 832          // 1/16 of 3.25 mm per tick, in Q16.16 units
+#define EKF_TICK_FLOOR 832          // 1/16 tick, in Q16.16 units
+#define EKF_SLIP_VAR  429497        // Wheel mismatch of 4% 1 sigma: (0.04*64)^2
+#define EKF_RANGE_VAR 230400        // (30/16)^2 in Q16.16
+#define EKF_GATE      9             // Innovations beyond 3 sigma are dropped
+#define EKF_CONE      63303         // cos(15 degrees) in Q16.16
+#define EKF_SIN       16962         // sin(15 degrees) in Q16.16
+#define EKF_TAN_IN    11556         // tan(10 degrees): a corner surely in the cone
+#define EKF_TAN_OUT   23853         // tan(20 degrees): ... surely out of it
+#define EKF_EDGE      22414         // cos(70 degrees): steepest edge echo used
+#define EKF_MAX_RANGE 2500          // mm; beyond this PING))) is unreliable
+#define EKF_SKEW      2             // Ticks of turn (3.5 degrees) a reading may lag
+
+// --- A wall segment from (x1,y1), with unit direction t and normal n
+typedef struct {
+  int x1, y1, x2, y2, len;          // mm
+  int tx, ty, nx, ny;               // Q16.16
+} ekfWall;
+
+int ekfX = 0;
+int ekfY = 0;
+unsigned int ekfTheta = 0;
+int ekfSlip = 0;
+int ekfScale = 0;
+int ekfP[EKF_STATES][EKF_STATES];
+
+unsigned int ekfPredictTicks = 0;
+unsigned int ekfRangeTicks = 0;
+
+static ekfWall walls[EKF_WALLS];
+static int numWalls = 0;
+static unsigned int ekfSeq = 0xFFFFFFFF;
+static int ekfLastTurn = 0;         // Right - left ticks at the last snapshot
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+unsigned int _toBam(int r)
+{
+  // Q16.16 radians to a binary angle
+  return (unsigned int)(((long long)r * 683565276) >> 16);
+}
+
+void _ekfSymmetric()
+{
+  for (int i = 1; i < EKF_STATES; i++)
+    for (int j = 0; j < i; j++)
+      ekfP[i][j] = ekfP[j][i];
+}
+
+int _ekfRange(unsigned int beam, int mm)
+{
+  // ekfRange() with the beam a binary angle off the heading
+  unsigned int t = CNT;
+  unsigned int phi = ekfTheta + beam;
+  int ux = fx_cos(phi), uy = fx_sin(phi);
+  int sx = ekfX + PINGOFFSET * fx_cos(ekfTheta);
+  int sy = ekfY + PINGOFFSET * fx_sin(ekfTheta);
+  int ccw[2] = {fx_mul(ux, EKF_CONE) - fx_mul(uy, EKF_SIN), fx_mul(uy, EKF_CONE) + fx_mul(ux, EKF_SIN)};
+  int cw[2] = {fx_mul(ux, EKF_CONE) + fx_mul(uy, EKF_SIN), fx_mul(uy, EKF_CONE) - fx_mul(ux, EKF_SIN)};
+  int found = 0, r = 0, mx = 0, my = 0, de = FX_ONE, dp = 0, maybe = 0;
+  int h[EKF_STATES], v[EKF_STATES], nu, S, k;
+
+  if (mm <= 0 || mm > EKF_MAX_RANGE) return 0;
+
+  // Nearest point of any wall inside the cone: at the perpendicular if
+  // the wall's normal is inside it, otherwise along the cone edge nearer
+  // the normal. de is how much longer than the perpendicular that is
+  // (1/cos), and dp how fast it changes as the edge swings.
+  for (int i = 0; i < numWalls; i++) {
+    ekfWall *w = &walls[i];
+    int d = fx_mul(w->nx, ux) + fx_mul(w->ny, uy);
+    int sg = d > 0 ? 1 : -1;
+    int px = sx - (w->x1 << 16), py = sy - (w->y1 << 16);
+    int ri, along, ei = FX_ONE, pi = 0;
+    ri = -sg * (fx_mul(w->nx, px) + fx_mul(w->ny, py));
+    if (ri <= 0 || (found && ri >= r)) continue;
+    if (d > -EKF_CONE && d < EKF_CONE) {
+      int nx = sg * w->nx, ny = sg * w->ny;
+      int *e = fx_mul(ux, ny) - fx_mul(uy, nx) > 0 ? ccw : cw;
+      ei = fx_mul(nx, e[0]) + fx_mul(ny, e[1]);
+      if (ei < EKF_EDGE) continue;
+      pi = fx_mul(ny, e[0]) - fx_mul(nx, e[1]);
+      ri = fx_div(ri, ei);
+      if (found && ri >= r) continue;
+      along = (fx_mul(w->tx, px + fx_mul(ri, e[0])) +
+               fx_mul(w->ty, py + fx_mul(ri, e[1]))) >> 16;
+    } else {
+      along = (fx_mul(w->tx, px) + fx_mul(w->ty, py)) >> 16;
+    }
+    if (along < 0 || along > w->len) continue;
+    found = 1;
+    r = ri;
+    mx = sg * w->nx;
+    my = sg * w->ny;
+    de = ei;
+    dp = pi;
+  }
+
+  // A wall end inside the cone (a box corner) is nearer than any point
+  // of the walls that meet there. Its range is a + b^2/2a, a along the
+  // beam and b across it, good to 0.3% inside 20 degrees. One within 5
+  // degrees of the cone's edge may or may not echo, and a small heading
+  // error decides which: if it would be the nearest, the reading is
+  // left alone.
+  for (int i = 0; i < numWalls; i++) {
+    ekfWall *w = &walls[i];
+    for (int j = 0; j < 2; j++) {
+      int dx = ((j ? w->x2 : w->x1) << 16) - sx;
+      int dy = ((j ? w->y2 : w->y1) << 16) - sy;
+      int a = fx_mul(dx, ux) + fx_mul(dy, uy);
+      int b = fx_mul(dy, ux) - fx_mul(dx, uy);
+      int ri;
+      if (b < 0) b = -b;
+      if (a <= 0 || (found && a >= r) || b > fx_mul(a, EKF_TAN_OUT)) continue;
+      ri = a + fx_mul(b, fx_div(b, a)) / 2;
+      if (b > fx_mul(a, EKF_TAN_IN)) {
+        if (!maybe || ri < maybe) maybe = ri;
+        continue;
+      }
+      if (found && ri >= r) continue;
+      found = 1;
+      r = ri;
+      mx = fx_div(dx, ri);
+      my = fx_div(dy, ri);
+      de = FX_ONE;
+      dp = 0;
+    }
+  }
+  if (!found || r > (EKF_MAX_RANGE << 16) || (maybe && maybe < r)) return 0;
+
+  // H = dr/d(x,y,theta): -m for position, m the way the echo comes
+  // back along (a wall's normal, or toward a corner), and for heading
+  // the sensor swinging on PINGOFFSET, plus the edge swinging
+  h[0] = fx_div(-mx, de);
+  h[1] = fx_div(-my, de);
+  k = -fx_mul(mx, fx_sin(ekfTheta)) + fx_mul(my, fx_cos(ekfTheta));
+  h[2] = fx_div(-PINGOFFSET * k - fx_mul(r, dp), de) >> EKF_U_SHIFT;
+  h[3] = h[4] = 0;
+
+  // v = P H', S = H v + R, innovation in units
+  for (int i = 0; i < EKF_STATES; i++)
+    v[i] = fx_mul(ekfP[i][0], h[0]) + fx_mul(ekfP[i][1], h[1]) + fx_mul(ekfP[i][2], h[2]);
+  S = fx_mul(h[0], v[0]) + fx_mul(h[1], v[1]) + fx_mul(h[2], v[2]) + EKF_RANGE_VAR;
+  nu = ((mm << 16) - r) >> EKF_U_SHIFT;
+  if (S <= 0 || fx_mul(nu, nu) > EKF_GATE * S) {
+    ekfRangeTicks = CNT - t;
+    return 0;
+  }
+
+  // x += K nu, P -= v v' / S
+  k = fx_div(nu, S);
+  ekfX += fx_mul(v[0], k) << EKF_U_SHIFT;
+  ekfY += fx_mul(v[1], k) << EKF_U_SHIFT;
+  ekfTheta += _toBam(fx_mul(v[2], k));
+  ekfSlip += fx_mul(v[3], k);
+  ekfScale += fx_mul(v[4], k);
+  for (int i = 0; i < EKF_STATES; i++) {
+    int w = fx_div(v[i], S);
+    for (int j = i; j < EKF_STATES; j++)
+      ekfP[i][j] -= fx_mul(w, v[j]);
+  }
+  _ekfSymmetric();
+  ekfRangeTicks = CNT - t;
+  return 1;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void ekfInit(float x, float y, float theta, float sigmaXY, float sigmaTheta)
+{
+  // Start at (x,y,theta) with independent errors of sigmaXY mm in x and y
+  // and sigmaTheta radians in heading
+  float s = sigmaXY / (1 << EKF_U_SHIFT);
+  ekfX = fx_fromFloat(x);
+  ekfY = fx_fromFloat(y);
+  ekfTheta = bam_fromRadians(theta);
+  ekfSlip = 0;
+  ekfScale = 0;
+  for (int i = 0; i < EKF_STATES; i++)
+    for (int j = 0; j < EKF_STATES; j++)
+      ekfP[i][j] = 0;
+  ekfP[0][0] = fx_fromFloat(s * s);
+  ekfP[1][1] = fx_fromFloat(s * s);
+  ekfP[2][2] = fx_fromFloat(sigmaTheta * sigmaTheta);
+  ekfP[3][3] = EKF_SLIP_VAR;
+  ekfP[4][4] = EKF_SLIP_VAR;
+
+  // Take the next snapshot whatever its number, and measure the turn
+  // it was taken in from the ticks now
+  ekfSeq = 0xFFFFFFFF;
+  ekfLastTurn = ticksR - ticksL;
+}
+
+void ekfClearWalls()
+{
+  numWalls = 0;
+}
+
+int ekfAddWall(int x1, int y1, int x2, int y2)
+{
+  // Add the wall from (x1,y1) to (x2,y2) in mm. Returns its index, or -1
+  // if there is no room, or it is further out than a pose can be.
+  ekfWall *w;
+  float dx = x2 - x1, dy = y2 - y1;
+  float len = sqrt(dx * dx + dy * dy);
+
+  if (numWalls >= EKF_WALLS || len < 1) return -1;
+  if (abs(x1) > 32767 || abs(y1) > 32767 || abs(x2) > 32767 || abs(y2) > 32767) return -1;
+  w = &walls[numWalls];
+  w->x1 = x1;
+  w->y1 = y1;
+  w->x2 = x2;
+  w->y2 = y2;
+  w->len = len;
+  w->tx = fx_fromFloat(dx / len);
+  w->ty = fx_fromFloat(dy / len);
+  w->nx = -w->ty;
+  w->ny = w->tx;
+  return numWalls++;
+}
+
+void ekfPredict(int deltaL, int deltaR)
+{
+  // Move the pose by deltaL/deltaR encoder ticks and grow the covariance:
+  // P = F P F' + Q, where F couples heading into position, and the wheel
+  // mismatch into heading
+  unsigned int t = CNT;
+  int cb = (deltaL + deltaR) * HALF_TURN >> EKF_SLIP_SHIFT;
+  int cm = (deltaR - deltaL) * 2 * HALF_TURN >> EKF_SLIP_SHIFT;
+  int bt = fx_mul(cb, ekfSlip) + fx_mul(cm, ekfScale);
+  unsigned int turn = (unsigned int)(deltaR - deltaL) * TURN_TICK + _toBam(bt);
+  unsigned int mid = ekfTheta + (unsigned int)((int)turn / 2);
+  int ds = (deltaL + deltaR) * HALF_TICK;
+  int c, s, du, sl, sr, ss, sd;
+  int F[EKF_STATES][EKF_STATES], FP[EKF_STATES][EKF_STATES];
+
+  ds += fx_mul(ds, ekfScale) >> EKF_SLIP_SHIFT;
+  if ((deltaL != deltaR || bt != 0) && ds != 0) {
+    // Chord factor sin(h)/h = 1 - h^2/6 + h^4/120, as in odometry.c
+    int h = (deltaR - deltaL) * HALF_TURN + bt / 2;
+    int h2 = fx_mul(h, h);
+    ds = fx_mul(ds, FX_ONE - h2/6 + fx_mul(h2, h2)/120);
+  }
+  c = fx_cos(mid);
+  s = fx_sin(mid);
+  ekfX += fx_mul(ds, c);
+  ekfY += fx_mul(ds, s);
+  ekfTheta += turn;
+
+  // F is the identity but for heading into position (units per radian),
+  // and the mismatch into heading, and through half of that into position
+  du = ds >> EKF_U_SHIFT;
+  for (int i = 0; i < EKF_STATES; i++)
+    for (int j = 0; j < EKF_STATES; j++)
+      F[i][j] = i == j ? FX_ONE : 0;
+  F[0][2] = -fx_mul(du, s);
+  F[1][2] = fx_mul(du, c);
+  F[2][3] = cb;
+  F[2][4] = cm;
+  F[0][3] = fx_mul(F[0][2], cb) / 2;
+  F[1][3] = fx_mul(F[1][2], cb) / 2;
+  F[0][4] = (fx_mul(du, c) >> EKF_SLIP_SHIFT) + fx_mul(F[0][2], cm) / 2;
+  F[1][4] = (fx_mul(du, s) >> EKF_SLIP_SHIFT) + fx_mul(F[1][2], cm) / 2;
+  for (int i = 0; i < EKF_STATES; i++)
+    for (int j = 0; j < EKF_STATES; j++) {
+      FP[i][j] = 0;
+      for (int k = i; k < EKF_STATES; k++)
+        FP[i][j] += fx_mul(F[i][k], ekfP[k][j]);
+    }
+  for (int i = 0; i < EKF_STATES; i++)
+    for (int j = i; j < EKF_STATES; j++) {
+      ekfP[i][j] = 0;
+      for (int k = j; k < EKF_STATES; k++)
+        ekfP[i][j] += fx_mul(FP[i][k], F[j][k]);
+    }
+
+  // Q: wheel variances (units^2) along the track and into the heading
+  sl = (deltaL < 0 ? -deltaL : deltaL) * EKF_TICK_SIGMA + EKF_TICK_FLOOR;
+  sr = (deltaR < 0 ? -deltaR : deltaR) * EKF_TICK_SIGMA + EKF_TICK_FLOOR;
+  sl = fx_mul(sl, sl);
+  sr = fx_mul(sr, sr);
+  ss = (sl + sr) >> 2;                      // Along the track
+  sd = fx_mul(sr - sl, INV_BASE) >> 1;      // Track and heading
+  ekfP[0][0] += fx_mul(ss, fx_mul(c, c));
+  ekfP[0][1] += fx_mul(ss, fx_mul(c, s));
+  ekfP[1][1] += fx_mul(ss, fx_mul(s, s));
+  ekfP[0][2] += fx_mul(sd, c);
+  ekfP[1][2] += fx_mul(sd, s);
+  ekfP[2][2] += fx_mul(sl + sr, INV_BASE2);
+  _ekfSymmetric();
+  ekfPredictTicks = CNT - t;
+}
+
+int ekfRange(int angle, int mm)
+{
+  // Correct the pose with a PING))) range of mm at angle degrees (bot
+  // frame). Returns 1 if it was used, 0 if no wall explains it.
+  return _ekfRange(angle * BAM_PER_DEG, mm);
+}
+
+void ekfUpdate()
+{
+  // Run updatePose() and predict with the same ticks
+  int l = ticksL;
+  int r = ticksR;
+  updatePose();
+  ekfPredict(ticksL - l, ticksR - r);
+}
+
+int ekfSense()
+{
+  // Apply pingFront from the latest sensor snapshot, if it is new, was
+  // not taken while turning, and the bot has not turned much since.
+  // Returns ranges used.
+  sensorData d;
+  unsigned int seq = sensorRead(&d);
+  unsigned int back;
+  int n = 0, k, turning, moved;
+
+  if (seq == ekfSeq) return 0;
+  ekfSeq = seq;
+
+  // Heading is proportional to the right - left tick difference, so this
+  // is how far the bot has turned since the readings were taken, and
+  // whether it was turning as they were
+  k = (ticksR - ticksL) - (d.ticksR - d.ticksL);
+  turning = (d.ticksR - d.ticksL) - ekfLastTurn;
+  ekfLastTurn = d.ticksR - d.ticksL;
+  if (k > EKF_SKEW || k < -EKF_SKEW || turning) return 0;
+
+  // Beams as they were read: swung back by the turn since, and the front
+  // range less the distance driven since (3.25/2 mm a tick)
+  back = -(unsigned int)k * TURN_TICK;
+  moved = ((ticksL - d.ticksL) + (ticksR - d.ticksR)) * 13 / 8;
+  n += _ekfRange(back, d.pingFront * 10 - moved);
+  return n;
+}
+
+void ekfPose(float pose[3])
+{
+  pose[0] = fx_toFloat(ekfX);
+  pose[1] = fx_toFloat(ekfY);
+  pose[2] = bam_toRadians(ekfTheta);
+}
+
+void ekfBudget()
+{
+  // Report what the filter costs in hub RAM and time
+  print("ekf: %d walls, %d bytes%c\n", numWalls, (int)(sizeof(walls) + sizeof(ekfP)), CLREOL);
+  print("ekf: predict %d cycles, range %d cycles, of %d at 10 Hz%c\n",
+        ekfPredictTicks, ekfRangeTicks, CLKFREQ / 10, CLREOL);
+}
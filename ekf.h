@@ -0,0 +1,36 @@
+//   Extended Kalman filter for the ActivityBot's pose
+//
+//   Fuses the encoder ticks with PING))) ranges to known wall segments.
+//   All fixed point, and constant time per step: a 5x5 covariance and a
+//   scan of at most EKF_WALLS walls per range.
+#ifndef _EKF_H_
+#define _EKF_H_
+
+#define EKF_WALLS     16            // Most wall segments
+#define EKF_U_SHIFT   4             // Covariance length unit: 16 mm
+#define EKF_STATES    5             // x, y, theta, and the two wheel scales
+
+// --- State: pose as in odometry.c, and its covariance in Q16.16 with
+// --- x,y in 16 mm units, theta in radians and the scales in 1/64ths
+extern int ekfX;                    // mm, Q16.16
+extern int ekfY;                    // mm, Q16.16
+extern unsigned int ekfTheta;       // Binary angle
+extern int ekfSlip;                 // Right - left wheel scale, 1/64ths in Q16.16
+extern int ekfScale;                // Mean wheel scale - 1, 1/64ths in Q16.16
+extern int ekfP[EKF_STATES][EKF_STATES];
+
+// --- CNT ticks taken by the last predict and the last range update
+extern unsigned int ekfPredictTicks;
+extern unsigned int ekfRangeTicks;
+
+void ekfInit(float x, float y, float theta, float sigmaXY, float sigmaTheta);
+void ekfClearWalls();
+int  ekfAddWall(int x1, int y1, int x2, int y2);
+void ekfPredict(int deltaL, int deltaR);
+int  ekfRange(int angle, int mm);
+void ekfUpdate();
+int  ekfSense();
+void ekfPose(float pose[3]);
+void ekfBudget();
+
+#endif
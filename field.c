@@ -0,0 +1,220 @@
+/*
+  field.c
+
+  Likelihood field for the ActivityBot's occupancy grid. Each field cell
+  holds the distance from its centre to the nearest wall cell, so how
+  well a scan fits the map from some pose is a sum of table lookups at
+  the beam endpoints, with no ray casting.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  Export the penalty of a distance for reloc.c
+  2026-10-17   1.2  Export the box of cells the last update recomputed
+
+  Distances are 3-4 chamfer distances (LF_STEP per cell across, LF_DIAG
+  per cell diagonally), capped at LF_FAR, from the usual two raster
+  passes. A field cell is a wall if any of the map cells under it is. The
+  field is a byte a cell at half the map's resolution, 4 KB, since the map
+  itself already takes 8 KB of hub RAM.
+
+  slam.c notes in mapDirty[] the cells that became or stopped being walls.
+  Only field cells within LF_FAR of those can change, so lfUpdate()
+  recomputes just that box. Everything around it is still right, and the
+  two passes read it as fixed boundary values.
+
+*/
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "field.h"                            // Function declarations
+
+#define LF_REACH      ((LF_FAR + LF_STEP - 1) / LF_STEP)   // Cells a change reaches
+
+unsigned char lfCells[LF_SIZE * LF_SIZE];
+unsigned int lfTicks = 0;
+int lfUpdated = 0;
+int lfBox[4] = {0, 0, -1, -1};
+static unsigned char lfPen[LF_FAR + 1];
+static int lfReady = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+int _lfWall(int fx, int fy)
+{
+  // Is any map cell under field cell (fx,fy) a wall?
+  for (int y = fy << LF_SHIFT; y < (fy + 1) << LF_SHIFT; y++) {
+    for (int x = fx << LF_SHIFT; x < (fx + 1) << LF_SHIFT; x++) {
+      int i = (y << MAP_SHIFT) | x;
+      if (((mapCells[i >> 1] >> ((i & 1) << 2)) & 15) >= MAP_WALL) return 1;
+    }
+  }
+  return 0;
+}
+
+void _lfInit()
+{
+  // Penalty for each distance: e^2 / 2048 eighths of a nat, e in mm
+  for (int d = 0; d <= LF_FAR; d++) {
+    int e = d * LF_CELL / LF_STEP;
+    e = ((e >> 3) * (e >> 3)) >> 5;
+    lfPen[d] = e < LF_PEN_MAX ? e : LF_PEN_MAX;
+  }
+  lfReady = 1;
+}
+
+void _lfRelax(unsigned char *c, int n)
+{
+  // Lower *c to n if that is nearer
+  if (n < *c) *c = n;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void lfBuild()
+{
+  // Recompute the whole field
+  mapDirty[0] = 0;
+  mapDirty[1] = 0;
+  mapDirty[2] = MAP_SIZE - 1;
+  mapDirty[3] = MAP_SIZE - 1;
+  lfUpdate();
+}
+
+void lfUpdate()
+{
+  // Bring the field up to date with the map, recomputing only the box
+  // of field cells the changes since the last update can reach
+  unsigned int t = CNT;
+  int x0, y0, x1, y1, x, y;
+
+  if (!lfReady) {
+    _lfInit();
+    mapDirty[0] = 0;
+    mapDirty[1] = 0;
+    mapDirty[2] = MAP_SIZE - 1;
+    mapDirty[3] = MAP_SIZE - 1;
+  }
+  if (mapDirty[0] > mapDirty[2]) {
+    lfUpdated = 0;
+    lfBox[0] = lfBox[1] = 0;
+    lfBox[2] = lfBox[3] = -1;
+    return;
+  }
+
+  x0 = (mapDirty[0] >> LF_SHIFT) - LF_REACH;
+  y0 = (mapDirty[1] >> LF_SHIFT) - LF_REACH;
+  x1 = (mapDirty[2] >> LF_SHIFT) + LF_REACH;
+  y1 = (mapDirty[3] >> LF_SHIFT) + LF_REACH;
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > LF_SIZE - 1) x1 = LF_SIZE - 1;
+  if (y1 > LF_SIZE - 1) y1 = LF_SIZE - 1;
+  mapDirty[0] = MAP_SIZE;
+  mapDirty[1] = MAP_SIZE;
+  mapDirty[2] = -1;
+  mapDirty[3] = -1;
+
+  for (y = y0; y <= y1; y++)
+    for (x = x0; x <= x1; x++)
+      lfCells[(y << LF_BITS) | x] = _lfWall(x, y) ? 0 : LF_FAR;
+
+  // Forward pass: from the left, below-left, below and below-right
+  for (y = y0; y <= y1; y++) {
+    for (x = x0; x <= x1; x++) {
+      unsigned char *c = &lfCells[(y << LF_BITS) | x];
+      if (*c == 0) continue;
+      if (x > 0) _lfRelax(c, c[-1] + LF_STEP);
+      if (y > 0) {
+        unsigned char *b = c - LF_SIZE;
+        _lfRelax(c, b[0] + LF_STEP);
+        if (x > 0) _lfRelax(c, b[-1] + LF_DIAG);
+        if (x < LF_SIZE - 1) _lfRelax(c, b[1] + LF_DIAG);
+      }
+    }
+  }
+
+  // Backward pass: from the right, above-right, above and above-left
+  for (y = y1; y >= y0; y--) {
+    for (x = x1; x >= x0; x--) {
+      unsigned char *c = &lfCells[(y << LF_BITS) | x];
+      if (*c == 0) continue;
+      if (x < LF_SIZE - 1) _lfRelax(c, c[1] + LF_STEP);
+      if (y < LF_SIZE - 1) {
+        unsigned char *a = c + LF_SIZE;
+        _lfRelax(c, a[0] + LF_STEP);
+        if (x < LF_SIZE - 1) _lfRelax(c, a[1] + LF_DIAG);
+        if (x > 0) _lfRelax(c, a[-1] + LF_DIAG);
+      }
+    }
+  }
+
+  lfUpdated = (x1 - x0 + 1) * (y1 - y0 + 1);
+  lfBox[0] = x0;
+  lfBox[1] = y0;
+  lfBox[2] = x1;
+  lfBox[3] = y1;
+  lfTicks = CNT - t;
+}
+
+int lfDistance(int fx, int fy)
+{
+  // Chamfer distance from field cell (fx,fy) to the nearest wall, LF_FAR
+  // off the field
+  if ((unsigned int)fx >= LF_SIZE || (unsigned int)fy >= LF_SIZE) return LF_FAR;
+  return lfCells[(fy << LF_BITS) | fx];
+}
+
+int lfPenalty(int d)
+{
+  // Penalty of an echo landing d (chamfer units) from the nearest wall
+  if (!lfReady) lfUpdate();
+  return lfPen[d < LF_FAR ? d : LF_FAR];
+}
+
+int lfScore(int x, int y, unsigned int theta)
+{
+  // Penalty of the latest scan (scan_cm[] at scanAngle[]) seen from pose
+  // (x,y,theta): Q16.16 mm and a binary angle. Each echo is placed in the
+  // world as aTb() would, in fixed point, and costs the lookup of the cell
+  // it lands in. Beams with no echo are skipped.
+  int sx = x + PINGOFFSET * fx_cos(theta);
+  int sy = y + PINGOFFSET * fx_sin(theta);
+  int pen = 0;
+
+  if (!lfReady) lfUpdate();
+  for (int i = 0; i < numAngles; i++) {
+    int r = scan_cm[i] * 10;
+    unsigned int a, fx, fy;
+    if (r <= 0 || r >= MAP_RANGE) continue;
+    a = theta + scanAngle[i] * BAM_PER_DEG;
+    fx = ((sx + r * fx_cos(a)) >> (16 + MAP_CELL_SHIFT + LF_SHIFT)) + LF_SIZE/2;
+    fy = ((sy + r * fx_sin(a)) >> (16 + MAP_CELL_SHIFT + LF_SHIFT)) + LF_SIZE/2;
+    if (fx >= LF_SIZE || fy >= LF_SIZE)
+      pen += LF_PEN_MAX;
+    else
+      pen += lfPen[lfCells[(fy << LF_BITS) | fx]];
+  }
+  return pen;
+}
+
+void lfBudget()
+{
+  // Report what the field costs in hub RAM and time
+  print("field: %d x %d cells of %d mm, %d bytes%c\n",
+        LF_SIZE, LF_SIZE, LF_CELL, (int)sizeof(lfCells), CLREOL);
+  print("field: last update %d cells in %d cycles%c\n", lfUpdated, lfTicks, CLREOL);
+}
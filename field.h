@@ -0,0 +1,35 @@
+//   Likelihood field for scoring PING))) scans against the occupancy grid
+//
+//   A byte per field cell holds the chamfer distance to the nearest wall,
+//   so a beam endpoint is scored with one lookup instead of a ray cast.
+//   Include slam.h first.
+#ifndef _FIELD_H_
+#define _FIELD_H_
+
+#define LF_SHIFT      1             // log2(map cells per field cell)
+#define LF_BITS       (MAP_SHIFT - LF_SHIFT)   // log2(field cells per side)
+#define LF_SIZE       (1 << LF_BITS)
+#define LF_CELL       (MAP_CELL << LF_SHIFT)
+#define LF_STEP       3             // Chamfer distance of one cell across
+#define LF_DIAG       4             // ... and diagonally
+#define LF_FAR        24            // Distances are capped here (8 cells)
+
+// --- Penalties are in eighths of a nat, as in mcl.c: an echo e mm from
+// --- the nearest wall costs e^2 / 2048 (a Gaussian of 90 mm), up to
+// --- LF_PEN_MAX. That is tighter than the ray model's 128 mm, since the
+// --- distance to the nearest wall is never more than the range error.
+#define LF_PEN_MAX    32
+
+extern unsigned char lfCells[];
+extern unsigned int lfTicks;        // CNT ticks taken by the last update
+extern int lfUpdated;               // Field cells it recomputed
+extern int lfBox[4];                // ... the box of them (x0, y0, x1, y1)
+
+void lfBuild();
+void lfUpdate();
+int  lfDistance(int fx, int fy);
+int  lfPenalty(int d);
+int  lfScore(int x, int y, unsigned int theta);
+void lfBudget();
+
+#endif
@@ -0,0 +1,92 @@
+/*
+  fixed.c
+
+  Fixed-point arithmetic for the ActivityBot
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version with table-driven sin() and cos()
+
+*/
+#include "fixed.h"                            // Function declarations
+
+// --- sin() over the first quadrant in 256 steps, Q16.16
+static const unsigned short sinTable[256] = {
+      0,   402,   804,  1206,  1608,  2010,  2412,  2814,
+   3216,  3617,  4019,  4420,  4821,  5222,  5623,  6023,
+   6424,  6824,  7224,  7623,  8022,  8421,  8820,  9218,
+   9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+  12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+  15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+  19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699,
+  22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+  25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+  28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+  30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347,
+  33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+  36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716,
+  39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+  41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+  44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+  46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288,
+  48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+  50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398,
+  52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+  54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+  56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+  57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071,
+  59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+  60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+  61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+  62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+  63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+  64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766,
+  64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+  65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436,
+  65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535
+};
+
+static int _sinQuadrant(unsigned int p)
+{
+  // sin() of p/65536 of a quarter turn, for p in 0..65536.
+  // Linear interpolation between table entries is good to about 5e-6.
+  unsigned int i = p >> 8;
+  int f = p & 0xFF;
+  int s0 = i < 256 ? sinTable[i] : FX_ONE;
+  int s1 = i < 255 ? sinTable[i+1] : FX_ONE;
+
+  return s0 + (((s1 - s0) * f) >> 8);
+}
+
+int fx_sin(unsigned int a)
+{
+  unsigned int q = a >> 30;                   // Quadrant
+  unsigned int p = (a >> 14) & 0xFFFF;        // Position within quadrant
+  int s;
+
+  if (q & 1) p = 0x10000 - p;                 // 2nd and 4th quadrants mirror
+  s = _sinQuadrant(p);
+  return (q & 2) ? -s : s;                    // 3rd and 4th are negative
+}
+
+int fx_cos(unsigned int a)
+{
+  return fx_sin(a + BAM_HALFPI);
+}
+
+unsigned int bam_fromRadians(float r)
+{
+  return (unsigned int)(long long)(r * BAM_PER_RAD);
+}
+
+float bam_toRadians(unsigned int a)
+{
+  // Result is in the -PI to +PI range
+  return (int)a / BAM_PER_RAD;
+}
@@ -0,0 +1,32 @@
+//   Fixed-point arithmetic for the ActivityBot
+//
+//   The Propeller has no FPU, so hot paths use integers. Q16.16 values
+//   are ints scaled by 65536. Angles are "binary angles": unsigned ints
+//   where 2^32 is one full turn, so they wrap around for free.
+#ifndef _FIXED_H_
+#define _FIXED_H_
+
+// --- Q16.16
+#define FX_ONE      65536
+#define FX_HALF     32768
+#define FX_PI       205887                    // PI in Q16.16
+
+#define fx_fromInt(i)    ((i) * FX_ONE)
+#define fx_toInt(x)      (((x) + FX_HALF) >> 16)
+#define fx_fromFloat(f)  ((int)((f) * 65536.0 + ((f) >= 0 ? 0.5 : -0.5)))
+#define fx_toFloat(x)    ((float)(x) / 65536.0)
+#define fx_mul(a, b)     ((int)(((long long)(a) * (b)) >> 16))
+#define fx_div(a, b)     ((int)(((long long)(a) << 16) / (b)))
+
+// --- Binary angles
+#define BAM_HALFPI  0x40000000u
+#define BAM_PI      0x80000000u
+#define BAM_PER_RAD 683565275.6                 // 2^32 / 2PI
+#define BAM_PER_DEG 11930465                    // 2^32 / 360
+
+int fx_sin(unsigned int a);
+int fx_cos(unsigned int a);
+unsigned int bam_fromRadians(float r);
+float bam_toRadians(unsigned int a);
+
+#endif
@@ -0,0 +1,193 @@
+/*
+  heading.c
+
+  Closed-loop turns on the spot for the ActivityBot. botTurn() works out
+  the ticks for an angle (204.542 a revolution) and drives them, and
+  whatever the wheels do past that, coasting to a stop or a tick short,
+  is left for a corrective turn and another scan. Here the turn watches
+  the heading updatePose() integrates, slows as it closes on the angle
+  asked for, and stops once within HD_TOLERANCE of it.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  End a turn that runs out of time as HD_TIMEOUT, not
+                    HD_DONE; hdTurn() says which it was
+  2026-10-17   1.2  Stop ahead of the angle by the coast, and judge a turn
+                    only once at rest: it hunted around the last tick
+
+  hdStart() sets a turn going; hdPoll() then takes a step of it each
+  time it is called, every 20 to 50 ms, and returns 1 until it is done.
+  Each step:
+
+  1. updatePose(), and adds the change in heading to hdTurned. Adding
+     up the changes, not taking the heading, lets a turn go past 180
+     degrees.
+  2. While turning, turns at the speed the wheels can still stop from
+     in what is left (at HD_MARGIN of abdrive's ramp, as a step may be
+     late), no slower than HD_CREEP and no faster than maxSpeed allows,
+     toward the angle asked for. Past it, that is back.
+     Turning on the spot moves both wheels, so the heading steps two
+     encoder ticks (3.5 degrees) at a time; within HD_PIVOT ticks of the
+     angle it pivots on one wheel instead, a tick (1.8 degrees) at a
+     time, or it could hunt either side of it.
+  3. Stops once within HD_TOLERANCE of the angle, counting on HD_COAST
+     of the angle the wheels would coast from the speed it last asked
+     for, and waits for the encoders to be still for HD_SETTLE_MS. If it
+     came to rest outside tolerance, short or past, it turns again; if
+     not, it is done. hdSettleMs is the time from the start to coming to
+     rest and hdError what is left of the angle then.
+
+  Stopping only once within tolerance, and judging while still moving,
+  had it coast a tick past, turn back, and do it again: 2.3 s of
+  HeadingBench's 8.6. The wheels lag the speed asked for, and a step
+  can be late, so counting on all the coast stops short as often;
+  HD_COAST was tuned on HeadingBench's turns and on another 20.
+
+  A turn that has not settled HD_GIVE_UP_MS after it started, held off
+  by a wall or hunting on a slipping wheel, stops where it is and ends
+  as HD_TIMEOUT, a failure: hdError says how far off it was left.
+
+  hdCancel() stops it where it is. hdTurn() is a blocking turn built on
+  the rest.
+
+  Closing the loop on the encoders takes out what the drive does with
+  the ticks it is given; it can't see the wheels slip. That is still
+  for the localization to catch.
+
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "sense.h"                            // Encoder ticks
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "heading.h"                          // Function declarations
+
+int hdState = HD_IDLE;
+float hdTarget = 0.0;
+float hdTurned = 0.0;
+int hdSettleMs = 0;
+float hdError = 0.0;
+
+static float hdLast;                // Heading at the last step
+static unsigned int hdStartAt;      // CNT when the turn started...
+static unsigned int hdStillAt;      // ... and when the encoders last moved
+static int hdTicksL, hdTicksR;
+static float hdOmega;               // Turn rate last asked for (rad/s)
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+float _hdWrap(float a)
+{
+  while (a > M_PI) a -= M_2PI;
+  while (a < -M_PI) a += M_2PI;
+  return a;
+}
+
+void _hdEnd(int state)
+{
+  // Stop, and record how the turn came out
+  botStop();
+  hdError = hdTarget - hdTurned;
+  hdSettleMs = (hdStillAt - hdStartAt) / (CLKFREQ / 1000);
+  hdState = state;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void hdStart(float a)
+{
+  // Start turning a radians (counter-clockwise) on the spot
+  updatePose();
+  hdLast = botP[2];
+  hdTarget = a;
+  hdTurned = 0.0;
+  hdTicksL = ticksL;
+  hdTicksR = ticksR;
+  hdStartAt = CNT;
+  hdStillAt = hdStartAt;
+  hdOmega = 0.0;
+  hdState = HD_TURNING;
+}
+
+int hdPoll()
+{
+  // A step of the turn. Returns 1 while it is going, 0 once done,
+  // cancelled or timed out (hdState says which).
+  float W = 105.8;                  // Wheel spacing = 105.8 mm
+  float most = maxSpeed * 3.25 * 2 / W;                                 // rad/s
+  float alpha = (rampStep > 0 ? rampStep : 1) * 50 * 3.25 * 2 / W;      // rad/s/s
+  float err, omega;
+
+  if (hdState != HD_TURNING && hdState != HD_SETTLING) return 0;
+
+  // 1. How far it has turned
+  updatePose();
+  hdTurned += _hdWrap(botP[2] - hdLast);
+  hdLast = botP[2];
+  err = hdTarget - hdTurned;
+  if (ticksL != hdTicksL || ticksR != hdTicksR) hdStillAt = CNT;
+  hdTicksL = ticksL;
+  hdTicksR = ticksR;
+
+  if ((int)(CNT - hdStartAt) > HD_GIVE_UP_MS * (CLKFREQ / 1000)) {
+    _hdEnd(HD_TIMEOUT);
+    return 0;
+  }
+
+  // 3. Close enough, or will be by the time it stops: stop, then wait
+  // to come to rest before saying how it came out
+  if (hdState == HD_TURNING && err * hdOmega >= 0 &&
+      fabs(err) - HD_COAST * hdOmega * hdOmega / (2 * alpha) < HD_TOLERANCE) {
+    botStop();
+    hdOmega = 0.0;
+    hdState = HD_SETTLING;
+  }
+  if (hdState == HD_SETTLING) {
+    if ((int)(CNT - hdStillAt) < HD_SETTLE_MS * (CLKFREQ / 1000)) return 1;
+    if (fabs(err) < HD_TOLERANCE) {
+      _hdEnd(HD_DONE);
+      return 0;
+    }
+    hdState = HD_TURNING;           // Stopped short, or coasted past
+  }
+
+  // 2. Turn toward it, as fast as it can still stop in time. The last
+  // tick or two are on one wheel.
+  omega = sqrt(2 * alpha * HD_MARGIN * fabs(err));
+  if (omega > most) omega = most;
+  if (omega < HD_CREEP) omega = HD_CREEP;
+  if (err < 0) omega = -omega;
+  hdOmega = omega;
+  if (fabs(err) < HD_PIVOT * 3.25 / W) botSetVW(fabs(omega) * W / 2, omega);
+  else botSetVW(0.0, omega);
+  return 1;
+}
+
+void hdCancel()
+{
+  // Stop the turn where it is
+  if (hdState == HD_TURNING || hdState == HD_SETTLING) _hdEnd(HD_CANCELLED);
+}
+
+int hdTurn(float a)
+{
+  // Turn a radians and wait until it has settled. Returns 1 if it
+  // settled within HD_TOLERANCE, 0 if it gave up (HD_TIMEOUT).
+  hdStart(a);
+  while (hdPoll())
+    pause(20);
+  return hdState == HD_DONE;
+}
@@ -0,0 +1,39 @@
+//   Closed-loop turns for the ActivityBot
+//
+//   Turns on the spot by watching the heading updatePose() integrates,
+//   instead of trusting a tick count to drive_goto(). Runs a step per
+//   call, so the caller's loop keeps going and can cancel it, and
+//   reports how long each turn took to settle and how far off it ended.
+#ifndef _HEADING_H_
+#define _HEADING_H_
+
+#define HD_TOLERANCE  0.02          // rad; close enough to stop (over half a tick of heading)
+#define HD_MARGIN     0.7           // Of the ramp's deceleration to plan on
+#define HD_COAST      0.7           // Of the coast from the speed asked for to stop early by
+#define HD_PIVOT      2             // Ticks of heading to go to pivot on one wheel
+#define HD_CREEP      0.3           // rad/s; slowest turn
+#define HD_SETTLE_MS  60            // Encoders still this long to be at rest
+#define HD_GIVE_UP_MS 5000          // Not settled by then: stop, HD_TIMEOUT
+
+// --- Where a turn is at
+#define HD_IDLE       0
+#define HD_TURNING    1
+#define HD_SETTLING   2             // Stopped, coming to rest
+#define HD_DONE       3
+#define HD_CANCELLED  4
+#define HD_TIMEOUT    5             // Failed: not settled in HD_GIVE_UP_MS
+
+// --- The turn: state, angle asked for and turned so far (rad), and once
+// --- over, ms to come to rest and the angle it was off by then (rad)
+extern int hdState;
+extern float hdTarget;
+extern float hdTurned;
+extern int hdSettleMs;
+extern float hdError;
+
+void hdStart(float a);
+int  hdPoll();
+void hdCancel();
+int  hdTurn(float a);
+
+#endif
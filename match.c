@@ -0,0 +1,454 @@
+/*
+  match.c
+
+  Scan-to-scan matching for the ActivityBot. Each PING))) sweep sees
+  much of what the one before it saw. matchStore() keeps a scan as the
+  reference, in world coordinates from the odometry pose it was taken
+  at. matchScan() then finds the pose from which the next scan lines up
+  best with it, and returns how far that is from the odometry pose
+  along with a confidence.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  Offer a correction only if it halves the odometry rms
+  2026-10-17   1.2  Need MATCH_PAIRS echoes to offer one; say when it hurts
+
+  PING))) hears the nearest surface anywhere in its 30 degree cone, so
+  its echoes are not points on the walls, and matching them as points
+  drags the pose around. matchStore() instead finds the regions of
+  constant depth in the reference scan: runs of neighbouring beams with
+  the same range. A wall faces the sensor somewhere in such a run, at
+  that range; the direction, to a degree, that best explains the run and
+  its neighbours gives a line. Neighbours that heard the same line past
+  their cone edge extend it. matchScan() predicts each new echo from those
+  lines with the cone model in ekf.c (the perpendicular distance if the
+  line faces the beam, otherwise along the nearer cone edge), and Gauss-
+  Newton steps solve for the (x, y, theta) that minimizes the squared
+  range errors, echoes more than MATCH_GATE off left out. A weak prior
+  holds the pose to odometry along any direction the lines do not
+  constrain, such as down a corridor.
+
+  The predictions and the sums are integer. Only the 3x3 solve at the
+  end of each step, and the confidence, are float: a few dozen operations. A pass is at most
+  SCAN_MAX echoes against MATCH_LINES lines and there are at most
+  MATCH_ITERS passes, so the cost is bounded whatever the scans look like.
+
+  The confidence (0-100) falls as fewer than half the echoes are
+  explained, as the lines' normals fail to span both directions (to half,
+  when only one direction is constrained and the prior holds the other),
+  and as the rms error nears the gate. The correction is noisy at the
+  level of a degree or a centimetre, and a high confidence does not
+  mean it is better than the odometry: with no slip at all, applying
+  every correction of confidence MATCH_USE or more took MatchBench from
+  2 mm of error to 72. So matchScan() also scores the odometry pose
+  itself, and offers nothing (confidence 0) unless that leaves at least
+  MATCH_NOISE rms and the match halves it. An exact pose still leaves
+  5-23 mm against the cone model, but rarely loses half of it to a
+  wrong match.
+
+  Even gated, a correction is a guess, and nothing here can promise it
+  will not make the pose worse: a wrong match looks much like a right
+  one. Of 177 corrections applied over 36 MatchBench routes (1-3% slip,
+  12 seeds each), 26 turned the heading the wrong way, some by 8-14
+  degrees, and no threshold on the confidence, either rms, or the size
+  of the correction set them apart. Matches from few echoes were the
+  likeliest to be wrong, so none is offered from fewer than
+  MATCH_PAIRS. With that, corrections cut the mean error over those
+  routes from 212 mm to 173 (and left it unchanged with no slip), but
+  5 routes of 36 still ended further off than odometry alone: 4 by
+  3-16 mm, and one by 600 mm, where odometry's error happened to swing
+  back near the end and the last correction did not. Apply corrections
+  (matchCorrect()) only where the wheels are known to slip, and keep
+  scoring them on the route.
+
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "match.h"                            // Function declarations
+
+// --- PING))) cone, as in ekf.c
+#define MATCH_CONE    63303         // cos(15 degrees) in Q16.16
+#define MATCH_SIN     16962         // sin(15 degrees) in Q16.16
+#define MATCH_EDGE    32768         // cos(60 degrees): steepest edge echo used
+
+// --- Lines: ranges within MATCH_RCD mm are the same depth, and a line
+// --- is only extended by echoes from up to MATCH_STEEP degrees off it
+#define MATCH_RCD     20
+#define MATCH_STEEP   30
+#define MATCH_LINES   (SCAN_MAX / 2)
+#define MATCH_PAIRED  2             // Steps after which echoes keep their lines
+
+// --- Prior holding the pose to odometry: as much as 1/50 of an echo, and
+// --- for heading as an echo 140 mm off the rotation centre would
+#define MATCH_PRIOR_XY 0.02
+#define MATCH_PRIOR_TH 20000.0
+
+// --- A reference line through foot point f, with unit normal n pointing
+// --- away from the sensor that saw it and direction t
+typedef struct {
+  int nx, ny, tx, ty;               // Q16.16
+  int a, c;                         // t . f and n . f, mm in Q16.16
+  int lo, hi;                       // Extent along t from f, mm
+} matchLine;
+
+unsigned int matchTicks = 0;
+int matchPairs = 0;
+int matchRms = 0;
+int matchRmsOdom = 0;
+
+static matchLine lines[MATCH_LINES];
+static int numLines = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+int _matchRange(int i)
+{
+  // Echo of beam i in mm, or 0 if none
+  int r = scan_cm[i] * 10;
+  return r > 0 && r < MAP_RANGE ? r : 0;
+}
+
+int _matchPredict(matchLine *l, int sx, int sy, int ux, int uy, int *g, int *de, int *dp)
+{
+  // Range (mm, Q16.16) at which a sensor at (sx,sy) looking along (ux,uy)
+  // hears line l, or 0 if it does not. As in ekf.c: the perpendicular if
+  // the normal is inside the cone, otherwise along the cone edge nearer
+  // it. g is the side of the line the sensor is on, de how much longer
+  // than the perpendicular the range is (1/cos), and dp how fast that
+  // changes as the edge swings.
+  int d = fx_mul(l->nx, ux) + fx_mul(l->ny, uy);
+  int sg = d > 0 ? 1 : -1;
+  int r = sg * (l->c - fx_mul(l->nx, sx) - fx_mul(l->ny, sy));
+  int ei = FX_ONE, pi = 0, along;
+
+  if (r <= 0) return 0;
+  if (d > -MATCH_CONE && d < MATCH_CONE) {
+    int mx = sg * l->nx, my = sg * l->ny;
+    int ex, ey;
+    if (fx_mul(ux, my) - fx_mul(uy, mx) > 0) {
+      ex = fx_mul(ux, MATCH_CONE) - fx_mul(uy, MATCH_SIN);
+      ey = fx_mul(uy, MATCH_CONE) + fx_mul(ux, MATCH_SIN);
+    } else {
+      ex = fx_mul(ux, MATCH_CONE) + fx_mul(uy, MATCH_SIN);
+      ey = fx_mul(uy, MATCH_CONE) - fx_mul(ux, MATCH_SIN);
+    }
+    ei = fx_mul(mx, ex) + fx_mul(my, ey);
+    if (ei < MATCH_EDGE) return 0;
+    pi = fx_mul(my, ex) - fx_mul(mx, ey);
+    r = fx_div(r, ei);
+    along = (fx_mul(l->tx, sx + fx_mul(r, ex)) + fx_mul(l->ty, sy + fx_mul(r, ey)) - l->a) >> 16;
+  } else {
+    along = (fx_mul(l->tx, sx) + fx_mul(l->ty, sy) - l->a) >> 16;
+  }
+  if (along < l->lo || along > l->hi) return 0;
+  *g = sg;
+  *de = ei;
+  *dp = pi;
+  return r;
+}
+
+int _matchExpect(int r, int off)
+{
+  // Range (mm) a beam off degrees from the normal of a line r mm away
+  // should hear, or 0 if the line is too steep for it to hear at all
+  if (off < 0) off = -off;
+  if (off <= 15) return r;
+  if (off >= 75) return 0;
+  return r * FX_ONE / fx_cos((off - 15) * BAM_PER_DEG);
+}
+
+int _matchAlong(int r, int off)
+{
+  // How far along a line r mm away a ray off degrees from its normal
+  // meets it (mm)
+  if (off > 60) off = 60;
+  if (off < -60) off = -60;
+  return fx_mul(r, fx_sin(off * BAM_PER_DEG)) * FX_ONE / fx_cos(off * BAM_PER_DEG);
+}
+
+int _matchFit(int i, int j, int r, int *phi)
+{
+  // Direction (degrees, bot frame) of the normal of a line r mm away that
+  // best explains beams i to j and two neighbours either side. Returns
+  // the mean squared error (mm^2) of beams i to j alone.
+  int mid = (scanAngle[i] + scanAngle[j]) / 2, best = 0x7FFFFFFF, cost;
+  for (int f = scanAngle[i] - 15; f <= scanAngle[j] + 15; f++) {
+    cost = 0;
+    for (int k = i - 2; k <= j + 2; k++) {
+      int rk, e;
+      if (k < 0 || k >= numAngles || !(rk = _matchRange(k))) continue;
+      e = _matchExpect(r, scanAngle[k] - f);
+      e = e ? e - rk : MATCH_GATE;
+      if (e > MATCH_GATE || -e > MATCH_GATE) e = MATCH_GATE;
+      cost += e * e;
+    }
+    if (cost < best || (cost == best && (f - mid) * (f - mid) < (*phi - mid) * (*phi - mid))) {
+      best = cost;
+      *phi = f;
+    }
+  }
+  cost = 0;
+  for (int k = i; k <= j; k++) {
+    int e = _matchExpect(r, scanAngle[k] - *phi);
+    e = e ? e - _matchRange(k) : MATCH_GATE;
+    cost += e * e;
+  }
+  return cost / (j - i + 1);
+}
+
+int _matchSolve(float A[3][3], float b[3], float d[3])
+{
+  // Solve A d = b by Cramer's rule. Returns 0 if A is singular.
+  float det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+            - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+            + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+  if (det < 1e-6 && det > -1e-6) return 0;
+  for (int k = 0; k < 3; k++) {
+    float M[3][3];
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 3; j++)
+        M[i][j] = j == k ? b[i] : A[i][j];
+    d[k] = (M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1])
+          - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0])
+          + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0])) / det;
+  }
+  return 1;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void matchReset()
+{
+  // Forget the reference scan
+  numLines = 0;
+}
+
+void matchStore()
+{
+  // Keep the lines in the latest scan as the reference, placed in the
+  // world from the odometry pose
+  int sx = odomX + PINGOFFSET * fx_cos(odomTheta);
+  int sy = odomY + PINGOFFSET * fx_sin(odomTheta);
+  int i = 0;
+
+  numLines = 0;
+  while (i < numAngles && numLines < MATCH_LINES) {
+    int r = _matchRange(i), j = i, fx, fy, k, phi, e, rk;
+    unsigned int a;
+    matchLine *l;
+    if (!r) {
+      i++;
+      continue;
+    }
+
+    // A run of the same depth, two beams at least
+    while (j + 1 < numAngles && (rk = _matchRange(j + 1)) &&
+           rk - _matchRange(i) <= MATCH_RCD && _matchRange(i) - rk <= MATCH_RCD) {
+      if (rk < r) r = rk;
+      j++;
+    }
+    if (j == i) {
+      i++;
+      continue;
+    }
+    if (_matchFit(i, j, r, &phi) > MATCH_RCD * MATCH_RCD) {
+      i = j + 1;
+      continue;
+    }
+    a = odomTheta + phi * BAM_PER_DEG;
+    l = &lines[numLines++];
+    l->nx = fx_cos(a);
+    l->ny = fx_sin(a);
+    l->tx = -l->ny;
+    l->ty = l->nx;
+    fx = sx + r * l->nx;
+    fy = sy + r * l->ny;
+    l->a = fx_mul(l->tx, fx) + fx_mul(l->ty, fy);
+    l->c = fx_mul(l->nx, fx) + fx_mul(l->ny, fy);
+
+    // The line reaches as far as the cones of the run cover it, and on
+    // to where neighbours heard it past their cone edge
+    l->lo = _matchAlong(r, scanAngle[i] - phi - 15);
+    l->hi = _matchAlong(r, scanAngle[j] - phi + 15);
+    for (k = j + 1; k < numAngles && (rk = _matchRange(k)); k++) {
+      e = _matchExpect(r, scanAngle[k] - phi);
+      if (scanAngle[k] - phi > MATCH_STEEP + 15 ||
+          !e || rk - e > MATCH_RCD || e - rk > MATCH_RCD) break;
+      e = _matchAlong(r, scanAngle[k] - phi - 15);
+      if (e > l->hi) l->hi = e;
+    }
+    for (k = i - 1; k >= 0 && (rk = _matchRange(k)); k--) {
+      e = _matchExpect(r, scanAngle[k] - phi);
+      if (phi - scanAngle[k] > MATCH_STEEP + 15 ||
+          !e || rk - e > MATCH_RCD || e - rk > MATCH_RCD) break;
+      e = _matchAlong(r, scanAngle[k] - phi + 15);
+      if (e < l->lo) l->lo = e;
+    }
+    i = j + 1;
+  }
+}
+
+int matchScan(int corr[3])
+{
+  // Register the latest scan against the reference. corr[] gets the
+  // correction to add to the odometry pose: x and y in mm as Q16.16 and
+  // heading as a binary angle. Returns the confidence, 0 to 100; 0 means
+  // there was too little to match, or the odometry pose fits as well as
+  // the match would, and corr[] is zero.
+  unsigned int t = CNT;
+  unsigned int ang[SCAN_MAX];
+  int rng[SCAN_MAX];
+  unsigned char pair[SCAN_MAX];
+  int x = odomX, y = odomY, m = 0, n = 0;
+  unsigned int th = odomTheta;
+  long long S[3][3], b[3], ee = 0;
+  float conf = 0;
+
+  corr[0] = corr[1] = corr[2] = 0;
+  matchPairs = 0;
+  matchRms = 0;
+  matchRmsOdom = 0;
+  for (int i = 0; i < numAngles; i++) {
+    if (!(rng[m] = _matchRange(i))) continue;
+    rng[m] <<= 16;
+    ang[m++] = scanAngle[i] * BAM_PER_DEG;
+  }
+  if (numLines == 0 || m < MATCH_MIN) {
+    matchTicks = CNT - t;
+    return 0;
+  }
+
+  for (int iter = 0; iter < MATCH_ITERS; iter++) {
+    int c = fx_cos(th), s = fx_sin(th);
+    int sx = x + PINGOFFSET * c, sy = y + PINGOFFSET * s;
+    float A[3][3], v[3], d[3];
+
+    for (int i = 0; i < 3; i++) {
+      b[i] = 0;
+      for (int j = 0; j < 3; j++)
+        S[i][j] = 0;
+    }
+    n = 0;
+    ee = 0;
+
+    // Predict each echo from the nearest line the beam hears, and sum
+    // J'J and J'e with J = d range / d(x,y,theta), all in Q10
+    for (int i = 0; i < m; i++) {
+      int ux = fx_cos(th + ang[i]), uy = fx_sin(th + ang[i]);
+      int r = 0, g = 0, de = 0, dp = 0, j[3], e, k;
+      matchLine *best = 0;
+      for (int q = 0; q < numLines; q++) {
+        int gq, deq, dpq;
+        if (iter >= MATCH_PAIRED && q != pair[i]) continue;
+        int rq = _matchPredict(&lines[q], sx, sy, ux, uy, &gq, &deq, &dpq);
+        if (!rq || (best && rq >= r)) continue;
+        best = &lines[q];
+        r = rq;
+        g = gq;
+        de = deq;
+        dp = dpq;
+      }
+      if (!best) {
+        pair[i] = MATCH_LINES;
+        continue;
+      }
+      pair[i] = best - lines;
+      e = r - rng[i];
+      if (e >= MATCH_GATE << 16 || -e >= MATCH_GATE << 16) continue;
+      k = -fx_mul(best->nx, s) + fx_mul(best->ny, c);
+      j[0] = fx_div(-g * best->nx, de) >> 6;
+      j[1] = fx_div(-g * best->ny, de) >> 6;
+      j[2] = fx_div(-g * PINGOFFSET * k - fx_mul(r, dp), de) >> 6;
+      e >>= 6;
+      for (int p = 0; p < 3; p++) {
+        b[p] += (long long)j[p] * e;
+        for (int q = p; q < 3; q++)
+          S[p][q] += (long long)j[p] * j[q];
+      }
+      ee += (long long)e * e;
+      n++;
+    }
+    if (iter == 0 && n)
+      matchRmsOdom = sqrt((float)ee / n) / 1024;
+    if (n < MATCH_MIN) break;
+
+    // Solve (J'J + prior) d = -(J'e + prior pull), with d in mm and rad
+    for (int p = 0; p < 3; p++) {
+      v[p] = -(float)b[p] / (1 << 20);
+      for (int q = p; q < 3; q++)
+        A[p][q] = A[q][p] = (float)S[p][q] / (1 << 20);
+    }
+    A[0][0] += MATCH_PRIOR_XY;
+    A[1][1] += MATCH_PRIOR_XY;
+    A[2][2] += MATCH_PRIOR_TH;
+    v[0] -= MATCH_PRIOR_XY * fx_toFloat(x - odomX);
+    v[1] -= MATCH_PRIOR_XY * fx_toFloat(y - odomY);
+    v[2] -= MATCH_PRIOR_TH * bam_toRadians(th - odomTheta);
+    if (!_matchSolve(A, v, d)) break;
+    x += fx_fromFloat(d[0]);
+    y += fx_fromFloat(d[1]);
+    th += (int)(d[2] * BAM_PER_RAD);
+
+    // Confidence from these pairs: coverage, the smaller eigenvalue of
+    // the normals' spread (0.5 a pair at best), and the rms error
+    {
+      float sxx = A[0][0] / n, syy = A[1][1] / n, sxy = A[0][1] / n;
+      float h = (sxx + syy) / 2, g = (sxx - syy) / 2;
+      float spread = 4 * (h - sqrt(g * g + sxy * sxy));
+      float rms = sqrt((float)ee / n) / 1024;
+      if (spread > 1) spread = 1;
+      conf = 100.0 * (2 * n > m ? 1 : 2.0 * n / m) * (1 + spread) / 2 * (1 - rms / MATCH_GATE);
+      matchRms = rms;
+    }
+    matchPairs = n;
+    if (d[0] < 0.5 && d[0] > -0.5 && d[1] < 0.5 && d[1] > -0.5 &&
+        d[2] < 0.002 && d[2] > -0.002) break;
+  }
+
+  // Offer the correction only if enough echoes back it, odometry leaves
+  // more than the matcher's own noise, and the match explains half of it
+  if (matchPairs >= MATCH_PAIRS && conf > 0 &&
+      matchRmsOdom >= MATCH_NOISE && 2 * matchRms <= matchRmsOdom) {
+    corr[0] = x - odomX;
+    corr[1] = y - odomY;
+    corr[2] = th - odomTheta;
+  } else {
+    conf = 0;
+  }
+  matchTicks = CNT - t;
+  return conf;
+}
+
+void matchCorrect(int corr[3])
+{
+  // Apply a correction from matchScan() to the odometry (and botP[]).
+  // Only worth it for confidence MATCH_USE or more; see above.
+  setPose(fx_toFloat(odomX + corr[0]), fx_toFloat(odomY + corr[1]),
+          bam_toRadians(odomTheta + corr[2]));
+}
+
+void matchBudget()
+{
+  // Report what matching costs in hub RAM and time
+  print("match: %d lines, %d bytes%c\n", numLines, (int)sizeof(lines), CLREOL);
+  print("match: last %d pairs, rms %d mm (odometry %d), %d cycles%c\n",
+        matchPairs, matchRms, matchRmsOdom, matchTicks, CLREOL);
+}
@@ -0,0 +1,32 @@
+//   Scan-to-scan matching for the ActivityBot
+//
+//   Registers the latest PING))) scan against the one before it and says
+//   how far the odometry pose is off, and how much to trust that. A
+//   correction is only offered when it explains the scan much better than
+//   odometry does; otherwise the confidence is 0 and odometry stands. The
+//   work is bounded: MATCH_ITERS passes over at most SCAN_MAX beams, each
+//   against the few lines found in the reference scan.
+#ifndef _MATCH_H_
+#define _MATCH_H_
+
+#define MATCH_ITERS   6             // Gauss-Newton steps, at most
+#define MATCH_GATE    60           // mm; an echo farther off is an outlier
+#define MATCH_MIN     4             // Fewest echoes worth solving with
+#define MATCH_PAIRS   12            // Fewest echoes worth correcting with
+#define MATCH_NOISE   15            // mm rms; odometry that fits this well stands
+#define MATCH_USE     60            // Least confidence worth applying
+
+// --- The last match: CNT ticks it took, echoes used and their rms (mm),
+// --- and the rms the odometry pose left
+extern unsigned int matchTicks;
+extern int matchPairs;
+extern int matchRms;
+extern int matchRmsOdom;
+
+void matchReset();
+void matchStore();
+int  matchScan(int corr[3]);
+void matchCorrect(int corr[3]);
+void matchBudget();
+
+#endif
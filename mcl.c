@@ -0,0 +1,341 @@
+/*
+  mcl.c
+
+  Monte Carlo localization for the ActivityBot. Each particle is a guess
+  at the pose. The motion step moves every particle by the encoder ticks
+  updatePose() integrated, with wheel noise. The measurement step weights
+  each particle by how well the latest PING))) scan fits the occupancy
+  grid from there. The resampling step redraws the pool in proportion to
+  the weights.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  Score scans with the likelihood field as an option
+
+  Everything is integer. Particles keep x,y in quarter mm and heading as
+  a 16-bit binary angle, so one is 8 bytes and the two pools (current and
+  resampled) for MCL_MAX particles take 2 KB. The measurement step casts
+  each beam through the grid a cell at a time, stopping a little past the
+  measured range, and scores the miss with a Gaussian of MCL_SIGMA mm
+  capped at MCL_PEN_MAX. Log-likelihoods add; they are turned into weights
+  with a table of exp() relative to the best particle. With
+  MCL_MODEL_FIELD each echo is a lookup in the likelihood field instead
+  (field.c), and beams with no echo are skipped.
+
+*/
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "field.h"                            // Likelihood field
+#include "mcl.h"                              // Function declarations
+
+// ActivityBot geometry, as in odometry.c
+#define HALF_TICK     106496        // 3.25/2 mm in Q16.16
+#define TURN_TICK     20997988      // 3.25/105.8 rad as a binary angle
+
+// --- Motion noise: 1 sigma of 1/16 of each wheel's travel, plus a
+// --- quarter tick, per step
+#define MCL_SLIP_SHIFT 4
+#define MCL_TICK_NOISE (FX_ONE / 4)
+
+// --- Measurement model. Penalties are in 1/8 nat: a miss of e mm costs
+// --- e^2 / (2 * MCL_SIGMA^2) nats, which is (e/64)^2 eighths at 128 mm.
+#define MCL_SIGMA     128           // mm
+#define MCL_PEN_MAX   32            // Cap per beam (4 nats): outliers
+#define MCL_REACH     (3 * MCL_SIGMA) // Cast this far past the echo
+#define MCL_TEMPER    2             // Flatten the product over beams
+
+// --- exp(-i/8) * 65535, the weight of a particle i << MCL_TEMPER
+// --- eighths of a nat worse than the best one
+static const unsigned short expTable[64] = {
+  65535, 57834, 51039, 45042, 39749, 35078, 30957, 27319,
+  24109, 21276, 18776, 16570, 14623, 12905, 11388, 10050,
+   8869,  7827,  6907,  6096,  5379,  4747,  4190,  3697,
+   3263,  2879,  2541,  2242,  1979,  1746,  1541,  1360,
+   1200,  1059,   935,   825,   728,   642,   567,   500,
+    442,   390,   344,   303,   268,   236,   209,   184,
+    162,   143,   127,   112,    99,    87,    77,    68,
+     60,    53,    47,    41,    36,    32,    28,    25,
+};
+
+static particle poolA[MCL_MAX];
+static particle poolB[MCL_MAX];
+particle *mclPool = poolA;
+int mclCount = 0;
+static int mclTarget = MCL_MAX / 2;
+static int mclMoved = 0;
+static int mclModel = MCL_MODEL_RAY;
+static unsigned int mclSeed = 2463534242u;
+
+unsigned int mclMotionTicks = 0;
+unsigned int mclMeasureTicks = 0;
+unsigned int mclResampleTicks = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+unsigned int _mclRand()
+{
+  // xorshift32
+  mclSeed ^= mclSeed << 13;
+  mclSeed ^= mclSeed >> 17;
+  mclSeed ^= mclSeed << 5;
+  return mclSeed;
+}
+
+int _mclNoise()
+{
+  // Roughly Gaussian, 1 sigma in Q16.16: the sum of two uniform halves
+  // of one random word, scaled up by 5/2
+  unsigned int r = _mclRand();
+  int n = (int)(r & 0xFFFF) + (int)(r >> 16) - 0x10000;
+  return (n * 5) >> 1;
+}
+
+int _mclUniform(int spread)
+{
+  // Uniform on -spread..spread
+  return (int)(_mclRand() % (unsigned int)(2 * spread + 1)) - spread;
+}
+
+int _mclPenalty(int sx, int sy, unsigned int a, int r)
+{
+  // Cast from (sx,sy) (Q16.16 cells, map corner at 0) along binary angle
+  // a until an occupied cell, and score the difference from the measured
+  // range r (mm, MAP_RANGE meaning no echo).
+  int dx = fx_cos(a);
+  int dy = fx_sin(a);
+  int kmax = (r + MCL_REACH) >> MAP_CELL_SHIFT;
+  int k, e;
+
+  if (kmax > MAP_RANGE >> MAP_CELL_SHIFT) kmax = MAP_RANGE >> MAP_CELL_SHIFT;
+  for (k = 1; k <= kmax; k++) {
+    unsigned int cx, cy;
+    int i;
+    sx += dx;
+    sy += dy;
+    cx = sx >> 16;
+    cy = sy >> 16;
+    if (cx >= MAP_SIZE || cy >= MAP_SIZE) break;
+    i = (cy << MAP_SHIFT) | cx;
+    if (((mapCells[i >> 1] >> ((i & 1) << 2)) & 15) >= MAP_WALL) break;
+  }
+
+  if (k > kmax) {
+    // Nothing in reach: right if there was no echo either
+    if (r >= MAP_RANGE) return 0;
+    e = MCL_REACH;
+  } else {
+    e = (k << MAP_CELL_SHIFT) - MAP_CELL/2 - r;
+    if (e < 0) e = -e;
+  }
+  if (e >= MCL_REACH) return MCL_PEN_MAX;
+  e = ((e >> 3) * (e >> 3)) >> 6;
+  return e < MCL_PEN_MAX ? e : MCL_PEN_MAX;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void mclInit(float x, float y, float theta, int spread, int spreadDeg)
+{
+  // Scatter the particles uniformly within spread mm and spreadDeg
+  // degrees of (x,y,theta)
+  int px = (int)(x * 4);
+  int py = (int)(y * 4);
+  unsigned int th = bam_fromRadians(theta);
+  int dth = spreadDeg * (BAM_PER_DEG >> 16);
+
+  mclPool = poolA;
+  mclCount = mclTarget;
+  for (int n = 0; n < mclCount; n++) {
+    particle *p = &mclPool[n];
+    p->x = px + _mclUniform(spread * 4);
+    p->y = py + _mclUniform(spread * 4);
+    p->theta = (th >> 16) + _mclUniform(dth);
+    p->w = 65535;
+  }
+  mclMoved = 1;
+}
+
+void mclSetModel(int model)
+{
+  // MCL_MODEL_RAY (the default) casts every beam through the map;
+  // MCL_MODEL_FIELD looks its endpoint up in the likelihood field
+  mclModel = model;
+}
+
+void mclSetCount(int n)
+{
+  // Use n particles of the pool from the next resample (or mclInit())
+  if (n < 1) n = 1;
+  if (n > MCL_MAX) n = MCL_MAX;
+  mclTarget = n;
+}
+
+void mclMotion(int deltaL, int deltaR)
+{
+  // Move every particle by deltaL/deltaR encoder ticks, each with its own
+  // draw of wheel noise. The arc is taken as a chord at the mean heading.
+  unsigned int t = CNT;
+  int sl = (deltaL < 0 ? -deltaL : deltaL) * (FX_ONE >> MCL_SLIP_SHIFT) + MCL_TICK_NOISE;
+  int sr = (deltaR < 0 ? -deltaR : deltaR) * (FX_ONE >> MCL_SLIP_SHIFT) + MCL_TICK_NOISE;
+
+  if (deltaL == 0 && deltaR == 0) return;
+  for (int n = 0; n < mclCount; n++) {
+    particle *p = &mclPool[n];
+    int dl = (deltaL << 16) + fx_mul(_mclNoise(), sl);    // Q16.16 ticks
+    int dr = (deltaR << 16) + fx_mul(_mclNoise(), sr);
+    unsigned int th = p->theta << 16;
+    unsigned int turn = (unsigned int)(((long long)(dr - dl) * TURN_TICK) >> 16);
+    unsigned int mid = th + (unsigned int)((int)turn / 2);
+    int ds = fx_mul(dl + dr, HALF_TICK);                  // Q16.16 mm
+
+    p->x += (fx_mul(ds, fx_cos(mid)) + (1 << 13)) >> 14;
+    p->y += (fx_mul(ds, fx_sin(mid)) + (1 << 13)) >> 14;
+    p->theta = (th + turn + 0x8000) >> 16;
+  }
+  mclMoved = 1;
+  mclMotionTicks = CNT - t;
+}
+
+int mclScore(int x, int y, unsigned int theta)
+{
+  // Penalty of the latest scan (scan_cm[] at scanAngle[]) seen from pose
+  // (x,y,theta), Q16.16 mm and a binary angle, under the current model
+  int sx, sy, pen = 0;
+
+  if (mclModel == MCL_MODEL_FIELD) return lfScore(x, y, theta);
+
+  // Sensor position in Q16.16 cells, map corner at 0
+  sx = ((x + PINGOFFSET * fx_cos(theta)) >> MAP_CELL_SHIFT) + ((MAP_SIZE/2) << 16);
+  sy = ((y + PINGOFFSET * fx_sin(theta)) >> MAP_CELL_SHIFT) + ((MAP_SIZE/2) << 16);
+  for (int i = 0; i < numAngles; i++) {
+    int r = scan_cm[i] * 10;
+    if (r <= 0) continue;                           // Beam not read yet
+    if (r > MAP_RANGE) r = MAP_RANGE;
+    pen += _mclPenalty(sx, sy, theta + scanAngle[i] * BAM_PER_DEG, r);
+  }
+  return pen;
+}
+
+void mclMeasure()
+{
+  // Weight each particle by the latest scan against the map
+  unsigned int t = CNT;
+  int best = 0x7FFFFFFF;
+
+  if (mclModel == MCL_MODEL_FIELD) lfUpdate();
+  for (int n = 0; n < mclCount; n++) {
+    particle *p = &mclPool[n];
+    int pen = mclScore(p->x << 14, p->y << 14, p->theta << 16);
+    p->w = pen;
+    if (pen < best) best = pen;
+  }
+
+  for (int n = 0; n < mclCount; n++) {
+    int i = (mclPool[n].w - best) >> MCL_TEMPER;
+    mclPool[n].w = i < 64 ? expTable[i] : 0;
+  }
+  mclMeasureTicks = CNT - t;
+}
+
+void mclResample()
+{
+  // Low-variance resampling: one random offset, then mclTarget evenly
+  // spaced picks along the running sum of the weights. O(N), and a
+  // particle with weight w is copied w / (total / N) times, give or take
+  // one.
+  unsigned int t = CNT;
+  particle *next = (mclPool == poolA) ? poolB : poolA;
+  unsigned int total = 0;
+  unsigned int step, u, c;
+  int j = 0;
+
+  for (int n = 0; n < mclCount; n++)
+    total += mclPool[n].w;
+  if (total == 0) return;
+
+  step = total / mclTarget;
+  u = step ? _mclRand() % step : 0;
+  c = mclPool[0].w;
+  for (int m = 0; m < mclTarget; m++) {
+    while (u >= c) c += mclPool[++j].w;
+    next[m] = mclPool[j];
+    next[m].w = 65535;
+    u += step;
+  }
+  mclPool = next;
+  mclCount = mclTarget;
+  mclResampleTicks = CNT - t;
+}
+
+void mclUpdate()
+{
+  // Run updatePose() and move the particles by the same ticks
+  int l = ticksL;
+  int r = ticksR;
+  updatePose();
+  mclMotion(ticksL - l, ticksR - r);
+}
+
+void mclScan()
+{
+  // Weight and resample on the latest scan. Skipped if the bot has not
+  // moved since the last one, so standing still cannot collapse the pool
+  // onto a few particles.
+  if (!mclMoved || mclCount == 0) return;
+  mclMeasure();
+  mclResample();
+  mclMoved = 0;
+}
+
+void mclPose(float pose[3])
+{
+  // Weighted mean of the particles. Headings are averaged as offsets
+  // from the first particle so they do not wrap.
+  long long sx = 0, sy = 0, st = 0, sw = 0;
+  unsigned short ref = mclPool[0].theta;
+
+  for (int n = 0; n < mclCount; n++) {
+    particle *p = &mclPool[n];
+    sx += (long long)p->w * p->x;
+    sy += (long long)p->w * p->y;
+    st += (long long)p->w * (short)(p->theta - ref);
+    sw += p->w;
+  }
+  if (sw == 0) return;
+  pose[0] = (float)sx / sw / 4;
+  pose[1] = (float)sy / sw / 4;
+  pose[2] = bam_toRadians((unsigned int)(unsigned short)(ref + (short)(st / sw)) << 16);
+}
+
+void mclCorrect()
+{
+  // Move the odometry (and botP[]) to the filter's estimate
+  float p[3];
+  mclPose(p);
+  setPose(p[0], p[1], p[2]);
+}
+
+void mclBudget()
+{
+  // Report what the filter costs in hub RAM and time
+  int n = mclCount ? mclCount : 1;
+  print("mcl: %d of %d particles, %d bytes%c\n",
+        mclCount, MCL_MAX, (int)(sizeof(poolA) + sizeof(poolB)), CLREOL);
+  print("mcl: cycles per particle: motion %d, measure %d, resample %d%c\n",
+        mclMotionTicks / n, mclMeasureTicks / n, mclResampleTicks / n, CLREOL);
+}
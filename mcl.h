@@ -0,0 +1,43 @@
+//   Monte Carlo localization for the ActivityBot
+//
+//   A particle filter that tracks the pose against the occupancy grid in
+//   slam.c. The pool is allocated statically; mclSetCount() picks how
+//   much of it is used, trading accuracy against cycles.
+#ifndef _MCL_H_
+#define _MCL_H_
+
+#define MCL_MAX       128           // Particles in the pool
+
+#define MCL_MODEL_RAY   0           // Score scans by ray casting the map
+#define MCL_MODEL_FIELD 1           // Score scans with the likelihood field
+
+// --- One particle, 8 bytes
+typedef struct {
+  short x;                          // Quarter mm, world frame
+  short y;                          // Quarter mm, world frame
+  unsigned short theta;             // Binary angle, 2^16 per turn
+  unsigned short w;                 // Weight, 0 to 65535
+} particle;
+
+extern particle *mclPool;          // The particles in use (one of two pools)
+extern int mclCount;
+
+// --- CNT ticks taken by the last run of each step
+extern unsigned int mclMotionTicks;
+extern unsigned int mclMeasureTicks;
+extern unsigned int mclResampleTicks;
+
+void mclInit(float x, float y, float theta, int spread, int spreadDeg);
+void mclSetModel(int model);
+void mclSetCount(int n);
+void mclMotion(int deltaL, int deltaR);
+int  mclScore(int x, int y, unsigned int theta);
+void mclMeasure();
+void mclResample();
+void mclUpdate();
+void mclScan();
+void mclPose(float pose[3]);
+void mclCorrect();
+void mclBudget();
+
+#endif
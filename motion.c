@@ -0,0 +1,517 @@
+/*
+  motion.c
+
+  A queue of motion commands for the ActivityBot, run by a drive cog.
+  botMove() and botTurn() hand a tick count to drive_goto(), which holds
+  up the calling cog until the bot gets there: no sensing, planning or
+  odometry happens meanwhile, and nothing can stop it early. Here the
+  main cog queues commands and goes on with its work, and can see how
+  far along they are or cancel them. While the drive cog runs,
+  botMove() and botTurn() queue their step too, and wait for it.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  Moves, turns and arcs follow S-curve profiles
+                    (scurve.c), and overlap the next one queued
+  2026-10-17   1.2  mqStop() retires the queue; unsigned cancel bits
+  2026-10-17   1.3  mqStatus(): MQ_FAILED for an id that was never queued
+  2026-10-17   1.4  mqPredictMs is when the whole queue will be done,
+                    overlaps and all; botMove()/botTurn() use the queue
+                    while the drive cog runs
+
+  The queue is a ring of MQ_SIZE commands. Only the main cog adds to it
+  (mqHead) and only the drive cog takes from it (mqTail), so neither
+  needs a lock. A command keeps its slot until it finishes.
+
+  Every MQ_TICK_MS the drive cog:
+
+  1. Drops anything mqCancel() has cancelled: the command running, which
+     stops the wheels, and any queued behind it.
+  2. Starts the next command if none is running.
+  3. Drives it a tick. A move, turn or arc is a number of ticks for each
+     wheel, planned as an S-curve profile (scurve.c) from the speeds the
+     wheels have; every tick a wheel is behind the profile adds SC_GAIN
+     ticks/s. A velocity command goes through botSetVW() until its time
+     is up, or, with no time, until another command is queued.
+
+  A move, turn or arc is planned to end at rest, from whatever speed
+  the wheels have (none, unless a velocity command was running). If the
+  next command is a move, turn or arc already queued when this
+  one starts to slow, the next one starts early, as this one's slowing
+  and its speeding up would take the same time, and the wheels follow
+  the sum of the two profiles meanwhile. The S-curves are symmetric, so
+  a move into a move keeps its speed, and a move into a turn rounds the
+  corner with the outer wheel rolling through; each wheel still goes
+  exactly its ticks for both. Otherwise it takes up what is left to
+  within a tick and is done once the wheels come to rest.
+
+  The wheels are stopped when the queue runs dry.
+
+  Each tick the drive cog also works out mqPredictMs, how long the queue
+  has left as it stands: the rest of the command running and of any
+  overlapping it, then each command queued behind them less the time it
+  would overlap the one before, as _mqBeginNext() will, and MQ_SETTLE
+  ticks wherever the wheels are to come to rest. Each command's profile
+  from rest is planned once, as it is queued, on the main cog, so this
+  is a few additions a command. A velocity command with no time counts
+  as none.
+
+  botMove() and botTurn() can't overlap anything: they wait for their
+  own step to be done before the caller can ask for the next. Through
+  the queue they are still profiled, can be cancelled from another cog,
+  and don't fight the drive cog for the wheels, but they are slower:
+  SCurveBench's sequence takes 11.2 s that way against 9.3 s with
+  drive_goto(), whose straight ramps are quicker than an S-curve's
+  jerk-limited ones. Queued, the same steps take 6.8 s, and mqPredictMs
+  has the end within 40 ms from when the last is queued.
+
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simpletools header
+#include "abdrive.h"                          // Include abdrive header
+
+#include "move.h"                             // Move the ActivityBot around
+#include "scurve.h"                           // Jerk-limited motion profiles
+#include "motion.h"                           // Function declarations
+
+volatile int mqRunning = 0;
+volatile float mqProgress = 0.0;
+volatile int mqDone = 0;
+volatile int mqCancelled = 0;
+volatile int mqPredictMs = 0;
+
+static int *cog = 0;
+static mqCommand mqQueue[MQ_SIZE];
+static volatile int mqHead = 0;     // Next free slot; main cog only
+static volatile int mqTail = 0;     // Oldest command; drive cog only, or mqStop()
+static int mqNextId = 1;
+static volatile int mqCancelTo = 0; // Commands up to this id are cancelled
+static volatile unsigned int mqCancelBits = 0;  // By id % 32: cancelled, not done
+
+// --- The command running: where it starts on the encoders and when,
+// --- the ticks each wheel has to go, and the profiles they follow
+static float mqStartL, mqStartR;
+static unsigned int mqT0;
+static float mqTicksL, mqTicksR;
+static scWheels mqPlan;
+static int mqElapsed;
+static int mqStopping;              // At the end, coming to rest
+// --- The command after it, if started early to overlap it
+static int mqOverlap = 0;
+static unsigned int mqNextT0;
+static float mqNextL, mqNextR;
+static scWheels mqNextPlan;
+static int mqLastL, mqLastR;        // Encoders a tick ago...
+static int mqStillFor = 0;          // ... and ticks since they last moved
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _mqWheels(float left, float right)
+{
+  if (left > maxSpeed) left = maxSpeed;
+  if (left < -maxSpeed) left = -maxSpeed;
+  if (right > maxSpeed) right = maxSpeed;
+  if (right < -maxSpeed) right = -maxSpeed;
+  leftSpeed = round(left);
+  rightSpeed = round(right);
+  botSpeed = (leftSpeed + rightSpeed) / 2;
+  drive_speed(leftSpeed, rightSpeed);
+}
+
+void _mqTicksFor(mqCommand *c, float *left, float *right)
+{
+  // The ticks each wheel has to go for a move, turn or arc
+  float W = 105.8;                  // Wheel spacing = 105.8 mm
+  float a = c->a, t;
+
+  *left = 0;
+  *right = 0;
+  if (c->kind == MQ_MOVE) {
+    *left = a / 3.25;
+    *right = a / 3.25;
+  } else if (c->kind == MQ_TURN) {
+    // As botTurn(): the right wheel takes half the turn, the left the rest
+    while (a > M_PI) a -= M_2PI;
+    while (a < -M_PI) a += M_2PI;
+    t = a * W / 3.25;
+    *right = t / 2;
+    *left = *right - t;
+  } else if (c->kind == MQ_ARC) {
+    t = a * fabs(c->b) / 3.25;
+    *left = t - (c->b < 0 ? -a : a) * W / 2 / 3.25;
+    *right = t + (c->b < 0 ? -a : a) * W / 2 / 3.25;
+  }
+}
+
+float _mqEase(scProfile *p, int down)
+{
+  // Time p takes speeding up, or slowing down
+  scRamp *r = down ? &p->down : &p->up;
+  return 2 * r->ta + r->tc;
+}
+
+int _mqPush(int kind, float a, float b, int ms)
+{
+  // Queue a command and return its id, or 0 if the queue is full
+  int next = (mqHead + 1) % MQ_SIZE;
+  mqCommand *c = &mqQueue[mqHead];
+  if (next == mqTail) return 0;
+  c->id = mqNextId++;
+  c->kind = kind;
+  c->a = a;
+  c->b = b;
+  c->ms = ms;
+  c->time = c->up = c->down = 0;
+  if (kind != MQ_VW) {
+    // Its profile from rest, for mqPredictMs
+    scWheels p;
+    scProfile *lead;
+    float l, r;
+    _mqTicksFor(c, &l, &r);
+    scPlanWheels(&p, l, r, 0, 0, 0, 0);
+    lead = fabs(l) > fabs(r) ? &p.left : &p.right;
+    c->time = p.time;
+    c->up = _mqEase(lead, 0);
+    c->down = _mqEase(lead, 1);
+  }
+  mqHead = next;                    // Publish only once it is filled in
+  return c->id;
+}
+
+void _mqBegin(mqCommand *c)
+{
+  // Set c going: for a move, turn or arc, plan each wheel's profile
+  int l, r;
+
+  mqElapsed = 0;
+  mqStopping = 0;
+  mqStillFor = 0;
+  if (c->kind == MQ_VW) {
+    drive_setRampStep(rampStep);
+    return;
+  }
+  drive_getTicks(&l, &r);
+  mqStartL = l;
+  mqStartR = r;
+  mqT0 = CNT;
+  _mqTicksFor(c, &mqTicksL, &mqTicksR);
+  scPlanWheels(&mqPlan, mqTicksL, mqTicksR, leftSpeed, rightSpeed, 0, 0);
+  drive_setRampStep(2 * rampStep);  // The profile keeps to rampStep
+}
+
+void _mqBeginNext()
+{
+  // Start the command after the one running early, if it is a move, turn
+  // or arc and the one running has got to where it would overlap
+  int next = (mqTail + 1) % MQ_SIZE;
+  float t = (float)(CNT - mqT0) / CLKFREQ, ease;
+  scWheels *p = &mqPlan;
+  int left = fabs(mqTicksL) > fabs(mqTicksR);
+
+  if (mqOverlap || next == mqHead || mqQueue[next].kind == MQ_VW || mqQueue[next].id <= mqCancelTo)
+    return;
+  _mqTicksFor(&mqQueue[next], &mqNextL, &mqNextR);
+  scPlanWheels(&mqNextPlan, mqNextL, mqNextR, 0, 0, 0, 0);
+  ease = _mqEase(left ? &p->left : &p->right, 1);
+  left = fabs(mqNextL) > fabs(mqNextR);
+  if (ease > _mqEase(left ? &mqNextPlan.left : &mqNextPlan.right, 0))
+    ease = _mqEase(left ? &mqNextPlan.left : &mqNextPlan.right, 0);
+  if (t < p->time - ease) return;
+  mqNextT0 = mqT0 + (p->time - ease) * CLKFREQ;
+  mqOverlap = 1;
+}
+
+void _mqAdopt()
+{
+  // The command started early is now the one running
+  mqStartL += mqTicksL;
+  mqStartR += mqTicksR;
+  mqTicksL = mqNextL;
+  mqTicksR = mqNextR;
+  mqPlan = mqNextPlan;
+  mqT0 = mqNextT0;
+  mqElapsed = 0;
+  mqStopping = 0;
+  mqStillFor = 0;
+  mqOverlap = 0;
+}
+
+int _mqStill()
+{
+  // Whether the wheels have stopped: not moved for MQ_SETTLE ticks, as
+  // at the end of a ramp down a wheel can take more than a tick to move
+  // one encoder count
+  int l, r;
+  drive_getTicks(&l, &r);
+  if (l == mqLastL && r == mqLastR) mqStillFor++;
+  else mqStillFor = 0;
+  mqLastL = l;
+  mqLastR = r;
+  return mqStillFor >= MQ_SETTLE;
+}
+
+int _mqTicks()
+{
+  // A tick of a move, turn or arc, and of the next one if it overlaps.
+  // Returns 1 once it is done.
+  float t = (float)(CNT - mqT0) / CLKFREQ;
+  float xL, xR, vL, vR, nL, nR, lead;
+  int l, r;
+
+  _mqBeginNext();
+  xL = mqStartL + scAt(&mqPlan.left, t, &vL);
+  xR = mqStartR + scAt(&mqPlan.right, t, &vR);
+  if (mqOverlap) {
+    t = (float)(CNT - mqNextT0) / CLKFREQ;
+    xL += scAt(&mqNextPlan.left, t, &nL);
+    xR += scAt(&mqNextPlan.right, t, &nR);
+    vL += nL;
+    vR += nR;
+    t = (float)(CNT - mqT0) / CLKFREQ;
+  }
+  drive_getTicks(&l, &r);
+  lead = fabs(mqTicksL) > fabs(mqTicksR) ? mqTicksL : mqTicksR;
+  mqProgress = fabs(lead) < 0.5 ? 1.0 : (lead == mqTicksL ? l - mqStartL : r - mqStartR) / lead;
+  if (mqProgress > 1) mqProgress = 1;
+  if (mqProgress < 0) mqProgress = 0;
+  xL -= l;
+  xR -= r;
+
+  if (t < mqPlan.time || mqOverlap) {
+    _mqWheels(vL + SC_GAIN * xL, vR + SC_GAIN * xR);
+    return t >= mqPlan.time;
+  }
+
+  // Stopping: take up what is left to within a tick, then wait for rest
+  if (fabs(xL) < 1) xL = 0;
+  if (fabs(xR) < 1) xR = 0;
+  _mqWheels(SC_GAIN * xL, SC_GAIN * xR);
+  return (xL == 0 && xR == 0 && _mqStill()) || ++mqStopping > MQ_SETTLE_MAX;
+}
+
+int _mqStep(mqCommand *c)
+{
+  // Drive c a tick. Returns 1 once it is done.
+  if (c->kind != MQ_VW) return _mqTicks();
+  botSetVW(c->a, c->b);
+  mqElapsed += MQ_TICK_MS;
+  if (c->ms > 0) {
+    mqProgress = (float)mqElapsed / c->ms;
+    return mqElapsed >= c->ms;
+  }
+  return (mqTail + 1) % MQ_SIZE != mqHead;
+}
+
+int _mqLeft(mqCommand *c)
+{
+  // Ms until all that is queued is done, as it stands (see above)
+  float left = 0, down = 0, t;
+  int i = mqTail, stop = 0;
+
+  if (c && c->kind == MQ_VW) {
+    if (c->ms > 0) left = (c->ms - mqElapsed) / 1000.0;
+  } else if (c && mqOverlap) {
+    i = (i + 1) % MQ_SIZE;
+    left = (float)(int)(mqNextT0 - CNT) / CLKFREQ + mqNextPlan.time;
+    down = mqQueue[i].down;
+    stop = 1;
+  } else if (c) {
+    t = mqPlan.time - (float)(CNT - mqT0) / CLKFREQ;
+    left = t > 0 ? t : 0;
+    down = _mqEase(fabs(mqTicksL) > fabs(mqTicksR) ? &mqPlan.left : &mqPlan.right, 1);
+    stop = 1;
+  } else {
+    i = (i + MQ_SIZE - 1) % MQ_SIZE;
+  }
+  for (i = (i + 1) % MQ_SIZE; i != mqHead; i = (i + 1) % MQ_SIZE) {
+    mqCommand *n = &mqQueue[i];
+    if (n->id <= mqCancelTo) break;
+    if (n->kind == MQ_VW) {
+      if (stop) left += MQ_SETTLE * MQ_TICK_MS / 1000.0;
+      left += n->ms / 1000.0;
+      stop = 0;
+    } else {
+      left += n->time - (stop ? (down < n->up ? down : n->up) : 0);
+      down = n->down;
+      stop = 1;
+    }
+  }
+  if (stop) left += MQ_SETTLE * MQ_TICK_MS / 1000.0;
+  return left * 1000;
+}
+
+void _mqWait(int kind, float a)
+{
+  // botMove() or botTurn() while the drive cog runs: queue the step
+  // behind whatever is there, and wait for it to be done
+  int id;
+  while (!(id = _mqPush(kind, a, 0, 0)))
+    pause(MQ_TICK_MS);
+  while (mqStatus(id) == MQ_QUEUED || mqStatus(id) == MQ_RUNNING)
+    pause(MQ_TICK_MS);
+}
+
+void _mqFinish(int cancelled)
+{
+  // Retire the command at the tail
+  int id = mqQueue[mqTail].id;
+  if (cancelled) {
+    mqOverlap = 0;
+    mqCancelBits |= 1u << (id & 31);
+    mqCancelled = id;
+  } else {
+    mqCancelBits &= ~(1u << (id & 31));
+    mqDone = id;
+  }
+  mqTail = (mqTail + 1) % MQ_SIZE;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+int *mqStart()
+{
+  if (!cog) {
+    cog = cog_run(&mqLoop, 128);
+    if (cog) botDrive = &_mqWait;
+  }
+  return cog;
+}
+
+void mqStop()
+{
+  // Stop the drive cog, the wheels, and whatever was running. With the
+  // drive cog gone, this cog retires what it left in the queue.
+  if (cog) cog_end(cog);
+  cog = 0;
+  botDrive = 0;
+  mqCancelTo = mqNextId - 1;
+  while (mqTail != mqHead)
+    _mqFinish(1);
+  mqRunning = 0;
+  mqProgress = 0.0;
+  mqPredictMs = 0;
+  mqStillFor = 0;
+  botStop();
+  drive_setRampStep(rampStep);
+}
+
+int mqMove(int mm)
+{
+  // Queue a move straight ahead (mm, negative to back up)
+  return _mqPush(MQ_MOVE, mm, 0, 0);
+}
+
+int mqTurn(float a)
+{
+  // Queue a turn on the spot (radians, counter-clockwise)
+  return _mqPush(MQ_TURN, a, 0, 0);
+}
+
+int mqArc(float radius, float a)
+{
+  // Queue a drive forward a radians round a circle of radius mm, its
+  // centre to the left for a positive radius and to the right for a
+  // negative one
+  return _mqPush(MQ_ARC, a, radius, 0);
+}
+
+int mqVW(float vel, float omega, int ms)
+{
+  // Queue velocity (mm/s) and omega (rad/s) for ms, or with ms 0 until
+  // the next command is queued
+  return _mqPush(MQ_VW, vel, omega, ms);
+}
+
+int mqStatus(int id)
+{
+  // What became of command id: MQ_QUEUED, MQ_RUNNING, MQ_DONE or
+  // MQ_CANCELLED. Good for the last 32 commands. One started early to
+  // overlap the one before is still MQ_QUEUED until that one is done.
+  // MQ_FAILED for 0, what a full queue returns, or any other id not
+  // handed out.
+  int last = mqDone > mqCancelled ? mqDone : mqCancelled;
+  if (id <= 0 || id >= mqNextId) return MQ_FAILED;
+  if (id == mqRunning) return MQ_RUNNING;
+  if (id > last) return id <= mqCancelTo ? MQ_CANCELLED : MQ_QUEUED;
+  return mqCancelBits & (1u << (id & 31)) ? MQ_CANCELLED : MQ_DONE;
+}
+
+int mqPending()
+{
+  // Commands queued or running
+  return (mqHead - mqTail + MQ_SIZE) % MQ_SIZE;
+}
+
+void mqCancel()
+{
+  // Cancel everything queued so far. The drive cog stops the wheels on
+  // its next tick.
+  mqCancelTo = mqNextId - 1;
+}
+
+void mqLoop(void *par)
+{
+  // Drive cog: run the queue forever
+  unsigned int t = CNT;
+  mqCommand *c = 0;
+  (void)par;
+
+  while (1) {
+    // 1. Cancelled commands
+    if (c && c->id <= mqCancelTo) {
+      _mqFinish(1);
+      c = 0;
+      mqRunning = 0;
+      _mqWheels(0, 0);
+      drive_setRampStep(rampStep);
+    }
+    while (!c && mqTail != mqHead && mqQueue[mqTail].id <= mqCancelTo)
+      _mqFinish(1);
+
+    // 2. The next command
+    if (!c && mqTail != mqHead) {
+      c = &mqQueue[mqTail];
+      _mqBegin(c);
+      mqProgress = 0.0;
+      mqRunning = c->id;
+    }
+
+    // 3. A tick of it
+    if (c && _mqStep(c)) {
+      _mqFinish(0);
+      c = 0;
+      mqRunning = 0;
+      if (mqOverlap) {
+        c = &mqQueue[mqTail];
+        _mqAdopt();
+        mqRunning = c->id;
+      }
+    }
+
+    // 4. Nothing left to do
+    if (!c && mqTail == mqHead && (leftSpeed || rightSpeed)) {
+      _mqWheels(0, 0);
+      drive_setRampStep(rampStep);
+    }
+    mqPredictMs = _mqLeft(c);
+
+    t += MQ_TICK_MS * (CLKFREQ / 1000);
+    if ((int)(t - CNT) > 0) {
+      waitcnt(t);
+    } else {
+      t = CNT;                            // Overran, so don't try to catch up
+    }
+  }
+}
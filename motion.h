@@ -0,0 +1,57 @@
+//   Motion command queue for the ActivityBot
+//
+//   Moves, turns, arcs and velocity commands are queued from the main
+//   cog and run one after another by a drive cog, so the main cog keeps
+//   sensing and planning while the bot moves, and can cancel the rest
+//   of a maneuver when something gets in the way.
+#ifndef _MOTION_H_
+#define _MOTION_H_
+
+#define MQ_SIZE       8             // Commands the queue holds
+#define MQ_TICK_MS    20            // Drive cog period, as abdrive's ramp
+#define MQ_SETTLE     3             // Ticks the wheels must be still to be at rest
+#define MQ_SETTLE_MAX 50            // Most ticks to wait for that
+
+// --- Kinds of command
+#define MQ_MOVE       0             // Straight, a mm
+#define MQ_TURN       1             // On the spot, a rad (counter-clockwise)
+#define MQ_ARC        2             // a rad round a circle of radius b mm (left +)
+#define MQ_VW         3             // a mm/s and b rad/s for ms (0: until the next)
+
+// --- What became of a command
+#define MQ_QUEUED     0
+#define MQ_RUNNING    1
+#define MQ_DONE       2
+#define MQ_CANCELLED  3
+#define MQ_FAILED     4             // Never queued (id 0: the queue was full)
+
+typedef struct {
+  int id;                           // Numbered from 1 as queued
+  int kind;
+  float a;
+  float b;
+  int ms;
+  float time, up, down;             // Its profile from rest (s): in all, speeding up, slowing down
+} mqCommand;
+
+// --- The drive cog's view: command running (0 if none; ids start at 1), how far through
+// --- it (0 to 1), ms until all that is queued is done, last one
+// --- finished, and last one cancelled
+extern volatile int mqRunning;
+extern volatile float mqProgress;
+extern volatile int mqPredictMs;
+extern volatile int mqDone;
+extern volatile int mqCancelled;
+
+int *mqStart();
+void mqStop();
+int  mqMove(int mm);
+int  mqTurn(float a);
+int  mqArc(float radius, float a);
+int  mqVW(float vel, float omega, int ms);
+int  mqStatus(int id);
+int  mqPending();
+void mqCancel();
+void mqLoop(void *par);
+
+#endif
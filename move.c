@@ -20,6 +20,18 @@
                     to be mm for distance, radians for angles, ticks for 
                     wheel speeds
   2015-12-01   3.1  Clean up more old code. Rename to move.c
+  2026-10-17   3.2  botSetRotation(): wheel speed difference is omega * L,
+                    not omega * L / R
+  2026-10-17   3.3  Keep the ramp step for planners
+  2026-10-17   3.4  botSetVW(): mix v and omega into wheel speeds that
+                    keep the arc, or the turn or speed (botSetMix()),
+                    and carry the fraction of a tick between calls
+  2026-10-17   3.5  botMove()/botTurn() still stop dead and drive_goto():
+                    they can't know the next step, so S-curves and
+                    blending are left to the motion queue (motion.c)
+  2026-10-17   3.6  pid_omega(): use pid.c, timed from CNT
+  2026-10-17   3.7  botMove()/botTurn() go through the motion queue
+                    while its drive cog runs (botDrive)
 
 */
 #include <math.h>                             // Needed for atan2() and M_PI
@@ -30,12 +42,22 @@
 #include "move.h"                             // Move the ActivityBot around
 #include "transforms.h"                       // Coordinate transforms
 #include "slam.h"                             // Localization, Mapping, and Coordinates
+#include "pid.h"                              // PID controllers
+#include "motion.h"                           // Motion queue command kinds
 
 int maxSpeed = 128;   // ticks/s
 int minSpeed = 0;     // ticks/s
+int rampStep = 4;     // ticks/s per 20 ms, as abdrive starts
 int botSpeed;         // ticks/s
 int leftSpeed;        // ticks/s
 int rightSpeed;       // ticks/s
+int botMix = BOT_MIX_ARC;
+void (*botDrive)(int kind, float a) = 0;
+
+// --- botSetVW() wheel speed left over from rounding last time (ticks/s)
+float mixLeft = 0.0;
+float mixRight = 0.0;
+pidState botHeadingPid;  // pid_omega(): heading to the goal, set up on first use
 
 // ----------------------------------------------
 // Local helper functions.
@@ -134,6 +156,56 @@ int _setSpeed(int s)
   return (delta);
 }
 
+void _mixWheels(float vel, float omega)
+{
+  // Set leftSpeed and rightSpeed for linear velocity vel (mm/s) and
+  // angular velocity omega (rad/s). If a wheel would pass maxSpeed, give
+  // way as botMix says:
+  //   BOT_MIX_ARC    scale both down together, keeping the curvature
+  //   BOT_MIX_TURN   keep omega, slow down
+  //   BOT_MIX_SPEED  keep vel, turn less
+  // The wheels take whole ticks/s, so what rounding leaves over is added
+  // in next time: on average the bot gets what was asked for, even below
+  // a tick (3.25 mm/s).
+
+  float L = 105.8;                  // Wheel spacing = 105.8 mm
+  float s = vel / 3.25;             // Mean wheel speed (ticks/s)
+  float d = omega * L / 3.25;       // Right less left (ticks/s)
+  float over = fabs(s) + fabs(d) / 2;
+  float left, right;
+
+  if (over > maxSpeed) {
+    if (botMix == BOT_MIX_TURN) {
+      if (d > 2 * maxSpeed) d = 2 * maxSpeed;
+      if (d < -2 * maxSpeed) d = -2 * maxSpeed;
+      over = maxSpeed - fabs(d) / 2;
+      if (s > over) s = over;
+      if (s < -over) s = -over;
+    } else if (botMix == BOT_MIX_SPEED) {
+      if (s > maxSpeed) s = maxSpeed;
+      if (s < -maxSpeed) s = -maxSpeed;
+      over = 2 * (maxSpeed - fabs(s));
+      if (d > over) d = over;
+      if (d < -over) d = -over;
+    } else {
+      s = s * maxSpeed / over;
+      d = d * maxSpeed / over;
+    }
+  }
+
+  left = s - d / 2 + mixLeft;
+  right = s + d / 2 + mixRight;
+  leftSpeed = round(left);
+  rightSpeed = round(right);
+  if (leftSpeed > maxSpeed) leftSpeed = maxSpeed;
+  if (leftSpeed < -maxSpeed) leftSpeed = -maxSpeed;
+  if (rightSpeed > maxSpeed) rightSpeed = maxSpeed;
+  if (rightSpeed < -maxSpeed) rightSpeed = -maxSpeed;
+  mixLeft = fabs(left - leftSpeed) < 1.0 ? left - leftSpeed : 0.0;
+  mixRight = fabs(right - rightSpeed) < 1.0 ? right - rightSpeed : 0.0;
+  botSpeed = (leftSpeed + rightSpeed) / 2;
+}
+
 void _driveSpeed(int left, int right) {
   drive_speed(left+LSERVOBIAS, right+RSERVOBIAS);
 }
@@ -152,18 +224,27 @@ void botStop()
   leftSpeed = 0;
   rightSpeed = 0;
   botSpeed = 0;
+  mixLeft = 0.0;
+  mixRight = 0.0;
   drive_speed(0,0);
 }
 
 void botTurn(float a)
 {
   // Stop the ActivityBot and turn the requested angle (in radians).
-  // Assume we want half of the turn on each wheel.
+  // Assume we want half of the turn on each wheel. To blend a turn into
+  // the moves either side of it, queue them with mqTurn() (motion.c).
+  // While the queue's drive cog runs, the turn goes through it.
 
   int l_ticks = 0;
   int r_ticks = 0;
   int turn_ticks = 0;
 
+  if (botDrive) {
+    botDrive(MQ_TURN, a);
+    return;
+  }
+
   drive_speed(0,0); // Stop bot
   leftSpeed = 0;
   rightSpeed = 0;
@@ -180,10 +261,17 @@ void botTurn(float a)
 void botMove(int mm)
 {
   // Stop the ActivityBot and move the requested distance (in mm).
+  // mqMove() (motion.c) blends into the next step instead. While the
+  // queue's drive cog runs, the move goes through it.
 
   // Encoder ticks are 3.25 mm/tick, so 13 cm = 4 ticks
   int ticks = mm * 4 / 13;
 
+  if (botDrive) {
+    botDrive(MQ_MOVE, mm);
+    return;
+  }
+
   drive_speed(0,0); // Stop bot
   leftSpeed = 0;
   rightSpeed = 0;
@@ -210,7 +298,8 @@ void botSetRampRate(int r)
   // Encoder ticks are 3.25 mm/tick, so 13 mm = 4 ticks
 
   //print("botSetRampRate: r = %d cm/sec/sec %c\n", r, CLREOL);
-  drive_setRampStep(r*4/13);
+  rampStep = r*4/13;
+  drive_setRampStep(rampStep);
 }
 
 void botSetSpeed(float vel)
@@ -229,7 +318,7 @@ void botSetRotation(float omega)
   // Set the ActivityBot's rate of rotation to omega radians/sec
   // The ActivityBot width is 105.8 mm, the wheel radius is 33.1 mm,
   // and one wheel rotation is 64 ticks.
-  // omega = (rightSpeed - leftSpeed) * radius / botWidth
+  // omega = (rightSpeed - leftSpeed) / botWidth, speeds in mm/s
 
   float L = 105.8;  // Wheel spacing = 105.8 mm
   float R = 33.1;   // Wheel radius = 33.1 mm
@@ -238,7 +327,7 @@ void botSetRotation(float omega)
   float deltaV;     // Wheel speed difference (mm/s)
   int deltaT;       // Wheel speed difference (ticks/s)
 
-  deltaV = omega * L / R;
+  deltaV = omega * L;
   deltaT = round( deltaV * C / (2.0*M_PI*R));
  
   _setDelta(deltaT); // Calc wheel speeds, modify avg speed if necessary
@@ -247,18 +336,23 @@ void botSetRotation(float omega)
   drive_speed(leftSpeed, rightSpeed);
 }
 
+void botSetMix(int mode)
+{
+  // What botSetVW() gives way on when the wheels can't do both velocity
+  // and omega: BOT_MIX_ARC, BOT_MIX_TURN or BOT_MIX_SPEED
+  botMix = mode;
+}
+
 void botSetVW(float vel, float omega)
 {
   // Set wheel speeds so that ActivityBot moves at linear velocity (mm/s)
-  // and angular velocity omega (rad/s). If both are not possible, angular
-  // velocity takes precedence.
+  // and angular velocity omega (rad/s). If both are not possible, botMix
+  // says which gives way; by default both, keeping the arc. The bot
+  // doesn't back up: a negative velocity is taken as 0.
 
-  float leftV;
-  float rightV;
-
-  if (vel < 3.25) vel = 0.0;
-  botSpeed = round(vel/3.25); // Set target speed
-  botSetRotation(omega);  // Set wheel speeds to achieve target omega
+  if (vel < 0.0) vel = 0.0;
+  _mixWheels(vel, omega);
+  drive_speed(leftSpeed, rightSpeed);
 }
 
 float pid_omega(float xy[2])
@@ -266,34 +360,15 @@ float pid_omega(float xy[2])
   // Calculate the angular rotation of the ActivityBot based on a target (x,y)
   // position for the bot. The target is in bot coordinate frame, so current bot
   // pose is (x,y) = (0,0) theta = 0 by definition.
-
-  // PID tuning parameters
-  float Kc = -2.0;
-  float Ki = -0.0;
-  float Kd = 0.0;
-  // cyle-to-cycle errors
-  static float e_sum = 0.0;
-  static float old_e = 0.0;
-  // current errors
-  float e;
-  float e_dot;
-  float omega;
-
-  // The error is the difference between the current bot heading and the
-  // direction to the target.
-  e = 0.0 - atan2(xy[1], xy[0]);
-
-  // Make sure |e| < PI to avoid instability (+PI same as -PI)
-  if (e < -M_PI) e = e + 2.0*M_PI;
-  if (e >  M_PI) e = e - 2.0*M_PI;
-
-  e_dot = (e - old_e)/0.1;
-  e_sum += e * 0.1;
-
-  omega = Kc * e + Ki * e_sum + Kd * e_dot;
-  old_e = e;
-
-  return omega;
+  //
+  // The measurement is the bot's heading relative to the direction to the
+  // target, the setpoint 0. botHeadingPid times its own steps, where this
+  // used to take every call as 0.1 s.
+  if (!botHeadingPid.kp) {
+    pidInit(&botHeadingPid, 2.0, 0.0, 0.0);
+    pidWrap(&botHeadingPid, 2.0*M_PI);         // +PI same as -PI
+  }
+  return pidUpdate(&botHeadingPid, 0.0, -atan2(xy[1], xy[0]));
 }
 void executePlan(float plan[2])
 {
@@ -8,10 +8,22 @@
 #define M_2PI (2.0*M_PI)
 
 // Wheel speeds in ticks/sec
+extern int maxSpeed;
+extern int rampStep;         // ticks/s per 20 ms
 extern int botSpeed;
 extern int leftSpeed;        // ticks/s
 extern int rightSpeed;       // ticks/s
 
+// What botSetVW() gives way on when the wheels can't do both
+#define BOT_MIX_ARC   0             // Scale velocity and omega together
+#define BOT_MIX_TURN  1             // Keep omega
+#define BOT_MIX_SPEED 2             // Keep velocity
+extern int botMix;
+
+// Set by mqStart() (motion.c) while its drive cog runs: botMove() and
+// botTurn() hand their step (MQ_MOVE mm or MQ_TURN rad) to it
+extern void (*botDrive)(int kind, float a);
+
 //   A set of routines to make the ActivityBot move
 int turnTicks(int a);
 
@@ -27,6 +39,7 @@ void botSetDeltaSpeed(int d);
 void botStop();
 
 void botSetSpeed(float mmps);
+void botSetMix(int mode);
 void botSetVW(float velocity, float omega);
 float pid_omega(float xy[2]);
 
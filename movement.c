@@ -19,6 +19,7 @@
   2015-08-29   3.0  Remove old non-functional routines, standardize units
                     to be mm for distance, radians for angles, ticks for 
                     wheel speeds
+  2026-10-17   3.1  pid_omega(): use pid.c, timed from CNT
 
 */
 #include <math.h>                             // Needed for atan2() and M_PI
@@ -27,12 +28,14 @@
 #include "abdrive.h"                          // Include abdrive header
 #include "botports.h"                         // Ports in use for the ActivityBot
 #include "movement.h"                         // Move the ActivityBot around
+#include "pid.h"                              // PID controllers
 
 volatile int maxSpeed = 128;   // ticks/s
 volatile int minSpeed = 0;     // ticks/s
 volatile int botSpeed;         // ticks/s
 volatile int leftSpeed;        // ticks/s
 volatile int rightSpeed;       // ticks/s
+pidState headingPid;           // pid_omega()
 
 // ----------------------------------------------
 // Local helper functions.
@@ -180,6 +183,12 @@ void botTurn(float a)
   drive_goto(l_ticks, r_ticks); // Turn in place
 }
 
+void botTurnAngle(int angle)
+{
+  // Stop the ActivityBot and turn the requested angle (in degrees).
+  botTurn(angle * M_PI / 180.0);
+}
+
 void botMove(int mm)
 {
   // Stop the ActivityBot and move the requested distance (in mm).
@@ -252,32 +261,11 @@ void botSetVW(float vel, float omega)
 float pid_omega(float xy[2])
 {
   // The goal (x,y) is in bot coordinate frame, so current bot
-  // theta = 0 by definition.
-  float Kc = -2.0;
-  float Ki = -0.0;
-  float Kd = 0.0;
-
-  static float e_sum = 0.0;
-  static float old_e = 0.0;
-
-  float e;
-  float e_dot;
-  float omega;
-
-  //print ("xy = (%f,%f)%c\n", xy[0], xy[1], CLREOL);
-
-  // Make sure |e| < PI
-  e = 0.0 - atan2(xy[1], xy[0]);
-  if (e < -M_PI) e = e + 2.0*M_PI;
-  if (e >  M_PI) e = e - 2.0*M_PI;
-
-  e_dot = (e - old_e)/0.1;
-  old_e = e;
-
-  e_sum += e * 0.1;
-
-  //print ("e = %f, e_sum = %f, e_dot = %f%c\n", e, e_sum, e_dot, CLREOL);
-  omega = Kc * e + Ki * e_sum + Kd * e_dot;
-
-  return omega;
+  // theta = 0 by definition. The measurement is the heading relative
+  // to the goal, the setpoint 0.
+  if (!headingPid.kp) {
+    pidInit(&headingPid, 2.0, 0.0, 0.0);
+    pidWrap(&headingPid, 2.0*M_PI);           // Make sure |e| < PI
+  }
+  return pidUpdate(&headingPid, 0.0, -atan2(xy[1], xy[0]));
 } 
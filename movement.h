@@ -5,6 +5,7 @@
 #ifndef M_PI
 #define M_PI  3.141592654
 #endif 
+#define M_2PI (2.0*M_PI)
 
 
 
@@ -0,0 +1,135 @@
+/*
+  odometry.c
+
+  Dead reckoning for the ActivityBot from wheel encoder counts, without
+  floating point.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version, replaces the float ICC update
+  2026-10-17   1.1  Split long or sharply turning updates into steps
+
+  Heading is not integrated. For a differential drive it is exactly
+  proportional to the running (right - left) tick difference, so it is
+  recomputed from that difference every update and never drifts from
+  rounding. Position moves along the chord of the arc driven since the
+  last update: length ds*sin(h)/h at heading theta+h, where h is half the
+  heading change. No ICC radius, no division.
+
+  sin(h)/h is taken from its series to h^4, good to a few parts in a
+  million up to half a radian, and ds is Q16.16, which holds about 20000
+  ticks. An update that covers more than either, from a caller that
+  fell behind, is split into steps that each stay inside both, along
+  the same arc: the wheels are taken to have kept the same ratio
+  throughout.
+
+*/
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Function declarations
+
+// ActivityBot geometry: 3.25 mm/tick, wheel spacing 105.8 mm
+#define HALF_TICK   106496        // 3.25/2 mm in Q16.16 (exact)
+#define TURN_TICK   20997988      // 3.25/105.8 rad as a binary angle
+#define HALF_TURN   1007          // 3.25/105.8/2 rad in Q16.16
+
+// --- Most wheel difference (ticks) for h of half a radian, and most
+// --- wheel sum for ds to stay in Q16.16, in one step
+#define STEP_TURN   32
+#define STEP_SUM    16384
+
+// --- Current pose
+int odomX = 0;
+int odomY = 0;
+unsigned int odomTheta = 0;
+
+// --- Reference for the heading and the last encoder counts seen
+static unsigned int baseTheta = 0;
+static int baseDiff = 0;
+static int lastL = 0;
+static int lastR = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _odomStep(int ticksLeft, int ticksRight)
+{
+  // Advance the pose along one arc to the new (absolute) encoder counts
+  int deltaL = ticksLeft - lastL;
+  int deltaR = ticksRight - lastR;
+  unsigned int theta;
+  unsigned int mid;
+  int ds;
+
+  theta = baseTheta + (unsigned int)(ticksRight - ticksLeft - baseDiff) * TURN_TICK;
+  mid = odomTheta + (unsigned int)((int)(theta - odomTheta) / 2);
+
+  ds = (deltaL + deltaR) * HALF_TICK;
+  if (deltaL != deltaR && ds != 0) {
+    // Chord factor sin(h)/h = 1 - h^2/6 + h^4/120
+    int h = (deltaR - deltaL) * HALF_TURN;
+    int h2 = fx_mul(h, h);
+    ds = fx_mul(ds, FX_ONE - h2/6 + fx_mul(h2, h2)/120);
+  }
+
+  odomX += fx_mul(ds, fx_cos(mid));
+  odomY += fx_mul(ds, fx_sin(mid));
+  odomTheta = theta;
+  lastL = ticksLeft;
+  lastR = ticksRight;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void odomReset(int ticksLeft, int ticksRight, float x, float y, float theta)
+{
+  // Place the bot at (x,y,theta) with the encoders reading ticksLeft/Right
+  odomX = fx_fromFloat(x);
+  odomY = fx_fromFloat(y);
+  odomTheta = bam_fromRadians(theta);
+  baseTheta = odomTheta;
+  baseDiff = ticksRight - ticksLeft;
+  lastL = ticksLeft;
+  lastR = ticksRight;
+}
+
+void odomUpdate(int ticksLeft, int ticksRight)
+{
+  // Advance the pose to the new (absolute) encoder counts, in as many
+  // steps as it takes to keep each one accurate
+  int deltaL = ticksLeft - lastL;
+  int deltaR = ticksRight - lastR;
+  int turn = deltaR > deltaL ? deltaR - deltaL : deltaL - deltaR;
+  int sum = deltaL + deltaR > 0 ? deltaL + deltaR : -(deltaL + deltaR);
+  int n = turn / STEP_TURN, k;
+  int l0 = lastL, r0 = lastR;
+
+  if (sum / STEP_SUM > n) n = sum / STEP_SUM;
+  for (k = 1; k <= n; k++)
+    _odomStep(l0 + (int)((long long)deltaL * k / (n + 1)),
+              r0 + (int)((long long)deltaR * k / (n + 1)));
+  _odomStep(ticksLeft, ticksRight);
+}
+
+float odomGetX()
+{
+  return fx_toFloat(odomX);
+}
+
+float odomGetY()
+{
+  return fx_toFloat(odomY);
+}
+
+float odomGetTheta()
+{
+  return bam_toRadians(odomTheta);
+}
@@ -0,0 +1,18 @@
+//   Fixed-point dead reckoning for the ActivityBot
+#ifndef _ODOMETRY_H_
+#define _ODOMETRY_H_
+
+// --- Pose, kept as integers
+extern int odomX;                   // mm, Q16.16
+extern int odomY;                   // mm, Q16.16
+extern unsigned int odomTheta;      // binary angle (2^32 per turn)
+
+void odomReset(int ticksLeft, int ticksRight, float x, float y, float theta);
+void odomUpdate(int ticksLeft, int ticksRight);
+
+// --- Float views, for printing
+float odomGetX();
+float odomGetY();
+float odomGetTheta();
+
+#endif
@@ -0,0 +1,265 @@
+/*
+  pid.c
+
+  PID controllers for the ActivityBot. pid_omega() in move.c kept its
+  integral and last error in static variables, so there could only be
+  one, and took every step to be 0.1 s, which a loop slowed by print()
+  or a PING))) timeout isn't. Here each controller is a struct of its
+  own, and measures the time since its last step.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  Each step, with e = setpoint - measurement and dt the time since the
+  last step (no more than PID_DT_MAX):
+
+    integral += ki e dt, held between iMin and iMax
+    u = kp e + integral - kd d(measurement)/dt
+    out = u held between outMin and outMax
+    integral += kb (out - u) dt
+
+  - The derivative is of the measurement, not the error, so a step in
+    the setpoint doesn't kick the output. It is smoothed by a first
+    order filter with time constant tau, as a difference of two noisy
+    readings over a short step is mostly noise.
+  - While the output is held at a limit, the last line bleeds the
+    integral back toward what would just reach it (back-calculation),
+    so the integral doesn't wind up and overshoot once the error turns.
+    Clamping the integral itself is the cruder, simpler guard.
+  - With a wrap period (2 PI for an angle) the error and the change in
+    the measurement are taken the short way round.
+
+  A limit pair left equal (as pidInit() leaves them) is no limit. The
+  first step only takes the measurement: there is no dt yet.
+
+  pidFx is the same, in Q16.16. Its time step is CNT ticks over CLKFREQ
+  in Q16.16 seconds; the rate of change of the measurement saturates
+  rather than overflow on a very short step.
+
+*/
+#include "simpletools.h"                      // Include simpletools header
+
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "pid.h"                              // Function declarations
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+float _pidWrap(float x, float period)
+{
+  if (period <= 0) return x;
+  while (x > period / 2) x -= period;
+  while (x < -period / 2) x += period;
+  return x;
+}
+
+float _pidHold(float x, float lo, float hi)
+{
+  if (lo >= hi) return x;
+  return x < lo ? lo : x > hi ? hi : x;
+}
+
+int _pidFxWrap(int x, int period)
+{
+  if (period <= 0) return x;
+  while (x > period / 2) x -= period;
+  while (x < -period / 2) x += period;
+  return x;
+}
+
+int _pidFxHold(int x, int lo, int hi)
+{
+  if (lo >= hi) return x;
+  return x < lo ? lo : x > hi ? hi : x;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void pidInit(pidState *p, float kp, float ki, float kd)
+{
+  // A controller with these gains and no limits, filter or wrap
+  p->kp = kp;
+  p->ki = ki;
+  p->kd = kd;
+  p->outMin = p->outMax = 0;
+  p->iMin = p->iMax = 0;
+  p->kb = 0;
+  p->tau = 0;
+  p->wrap = 0;
+  pidReset(p);
+}
+
+void pidLimits(pidState *p, float outMin, float outMax)
+{
+  p->outMin = outMin;
+  p->outMax = outMax;
+}
+
+void pidIntegralLimits(pidState *p, float iMin, float iMax)
+{
+  p->iMin = iMin;
+  p->iMax = iMax;
+}
+
+void pidAntiWindup(pidState *p, float kb)
+{
+  // Unwind the integral at kb (1/s) times how far the output is held
+  // past its limit. About ki / kp is a good start.
+  p->kb = kb;
+}
+
+void pidFilter(pidState *p, float tau)
+{
+  p->tau = tau;
+}
+
+void pidWrap(pidState *p, float period)
+{
+  p->wrap = period;
+}
+
+void pidReset(pidState *p)
+{
+  // Forget the past: the next step starts afresh
+  p->integral = 0;
+  p->deriv = 0;
+  p->last = 0;
+  p->dt = 0;
+  p->out = 0;
+  p->started = 0;
+}
+
+float pidUpdateDt(pidState *p, float setpoint, float measurement, float dt)
+{
+  // A step of the controller, dt seconds after the last. Returns the output.
+  float e = _pidWrap(setpoint - measurement, p->wrap);
+  float u;
+
+  if (dt > PID_DT_MAX) dt = PID_DT_MAX;
+  if (!p->started || dt <= 0) {
+    dt = 0;
+    if (!p->started) p->last = measurement;
+    p->started = 1;
+  }
+  p->dt = dt;
+
+  if (dt > 0) {
+    float rate = _pidWrap(measurement - p->last, p->wrap) / dt;
+    if (p->tau > 0) p->deriv += (rate - p->deriv) * dt / (p->tau + dt);
+    else p->deriv = rate;
+    p->integral = _pidHold(p->integral + p->ki * e * dt, p->iMin, p->iMax);
+  }
+  p->last = measurement;
+
+  u = p->kp * e + p->integral - p->kd * p->deriv;
+  p->out = _pidHold(u, p->outMin, p->outMax);
+  if (p->kb > 0 && dt > 0) p->integral += p->kb * (p->out - u) * dt;
+  return p->out;
+}
+
+float pidUpdate(pidState *p, float setpoint, float measurement)
+{
+  // A step of the controller, timed from CNT. Returns the output.
+  unsigned int now = CNT;
+  float dt = p->started ? (float)(now - p->at) / CLKFREQ : 0;
+  p->at = now;
+  return pidUpdateDt(p, setpoint, measurement, dt);
+}
+
+void pidFxInit(pidFx *p, int kp, int ki, int kd)
+{
+  p->kp = kp;
+  p->ki = ki;
+  p->kd = kd;
+  p->outMin = p->outMax = 0;
+  p->iMin = p->iMax = 0;
+  p->kb = 0;
+  p->tau = 0;
+  p->wrap = 0;
+  pidFxReset(p);
+}
+
+void pidFxLimits(pidFx *p, int outMin, int outMax)
+{
+  p->outMin = outMin;
+  p->outMax = outMax;
+}
+
+void pidFxIntegralLimits(pidFx *p, int iMin, int iMax)
+{
+  p->iMin = iMin;
+  p->iMax = iMax;
+}
+
+void pidFxAntiWindup(pidFx *p, int kb)
+{
+  p->kb = kb;
+}
+
+void pidFxFilter(pidFx *p, int tau)
+{
+  p->tau = tau;
+}
+
+void pidFxWrap(pidFx *p, int period)
+{
+  p->wrap = period;
+}
+
+void pidFxReset(pidFx *p)
+{
+  p->integral = 0;
+  p->deriv = 0;
+  p->last = 0;
+  p->dt = 0;
+  p->out = 0;
+  p->started = 0;
+}
+
+int pidFxUpdateDt(pidFx *p, int setpoint, int measurement, int dt)
+{
+  // A step of the controller, dt (Q16.16 s) after the last. Returns the output.
+  int e = _pidFxWrap(setpoint - measurement, p->wrap);
+  int u;
+
+  if (dt > fx_fromFloat(PID_DT_MAX)) dt = fx_fromFloat(PID_DT_MAX);
+  if (!p->started || dt <= 0) {
+    dt = 0;
+    if (!p->started) p->last = measurement;
+    p->started = 1;
+  }
+  p->dt = dt;
+
+  if (dt > 0) {
+    long long rate = ((long long)_pidFxWrap(measurement - p->last, p->wrap) << 16) / dt;
+    if (rate > 0x7fffffff) rate = 0x7fffffff;
+    if (rate < -0x7fffffff) rate = -0x7fffffff;
+    if (p->tau > 0) p->deriv += fx_mul((int)rate - p->deriv, fx_div(dt, p->tau + dt));
+    else p->deriv = rate;
+    p->integral = _pidFxHold(p->integral + fx_mul(fx_mul(p->ki, e), dt), p->iMin, p->iMax);
+  }
+  p->last = measurement;
+
+  u = fx_mul(p->kp, e) + p->integral - fx_mul(p->kd, p->deriv);
+  p->out = _pidFxHold(u, p->outMin, p->outMax);
+  if (p->kb > 0 && dt > 0) p->integral += fx_mul(fx_mul(p->kb, p->out - u), dt);
+  return p->out;
+}
+
+int pidFxUpdate(pidFx *p, int setpoint, int measurement)
+{
+  unsigned int now = CNT;
+  int dt = p->started ? (int)(((long long)(now - p->at) << 16) / CLKFREQ) : 0;
+  p->at = now;
+  return pidFxUpdateDt(p, setpoint, measurement, dt);
+}
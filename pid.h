@@ -0,0 +1,66 @@
+//   PID controllers for the ActivityBot
+//
+//   Each controller keeps its own state in a struct, so any number can
+//   run at once, and measures its own time step from CNT. Integral
+//   clamping, back-calculation anti-windup and a filtered derivative on
+//   the measurement are optional. pidFx is the same controller in Q16.16
+//   (fixed.h), for loops run too often to spend floating point on.
+#ifndef _PID_H_
+#define _PID_H_
+
+#define PID_DT_MAX    0.5           // s; a longer step is taken as this
+
+typedef struct {
+  float kp, ki, kd;                 // Gains
+  float outMin, outMax;             // Output limits
+  float iMin, iMax;                 // Integral term limits
+  float kb;                         // Back-calculation gain (1/s), 0 for none
+  float tau;                        // Derivative filter time constant (s), 0 for none
+  float wrap;                       // Period of the measurement (2 PI for an angle), 0 for none
+  float integral;                   // Integral term, in output units
+  float deriv;                      // Filtered rate of change of the measurement
+  float last;                       // Measurement last step
+  float dt;                         // Last time step (s)
+  float out;                        // Last output
+  unsigned int at;                  // CNT at the last step
+  int started;
+} pidState;
+
+void  pidInit(pidState *p, float kp, float ki, float kd);
+void  pidLimits(pidState *p, float outMin, float outMax);
+void  pidIntegralLimits(pidState *p, float iMin, float iMax);
+void  pidAntiWindup(pidState *p, float kb);
+void  pidFilter(pidState *p, float tau);
+void  pidWrap(pidState *p, float period);
+void  pidReset(pidState *p);
+float pidUpdate(pidState *p, float setpoint, float measurement);
+float pidUpdateDt(pidState *p, float setpoint, float measurement, float dt);
+
+// --- Q16.16: gains, limits and values are fixed.h numbers, kb and tau too
+typedef struct {
+  int kp, ki, kd;
+  int outMin, outMax;
+  int iMin, iMax;
+  int kb;
+  int tau;
+  int wrap;
+  int integral;
+  int deriv;
+  int last;
+  int dt;
+  int out;
+  unsigned int at;
+  int started;
+} pidFx;
+
+void pidFxInit(pidFx *p, int kp, int ki, int kd);
+void pidFxLimits(pidFx *p, int outMin, int outMax);
+void pidFxIntegralLimits(pidFx *p, int iMin, int iMax);
+void pidFxAntiWindup(pidFx *p, int kb);
+void pidFxFilter(pidFx *p, int tau);
+void pidFxWrap(pidFx *p, int period);
+void pidFxReset(pidFx *p);
+int  pidFxUpdate(pidFx *p, int setpoint, int measurement);
+int  pidFxUpdateDt(pidFx *p, int setpoint, int measurement, int dt);
+
+#endif
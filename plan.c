@@ -11,9 +11,29 @@
   Date        Ver   Comments
   ==========  ====  ==================================================
   2015-12-04   1.0  Initial version of gotoGoal(), avoidObstacle(), plan() 
+  2026-10-17   1.1  Blend goal attraction and obstacle repulsion using
+                    a table of e^(-beta*d), cheap enough for every tick
+
+  The plan is a velocity (xdot, ydot) in mm/s in the world frame, as
+  executePlan() in move.c expects. Near nothing, it heads for the goal.
+  Each echo in scan_cm[] pushes away from itself, the nearer the harder,
+  and the nearer the nearest echo the more that push takes over:
+
+    s    = 1 - e^(-beta * nearest)
+    plan = s * goal + (1 - s) * avoid
+
+  Straight repulsion stalls wherever it balances the goal's pull: head
+  on to a box, or short of a goal near a wall. So avoid is the push
+  turned 70 degrees, to slide along what it pushes off from. It turns
+  toward the goal's side as seen from the clear, and keeps to that side
+  until clear again. Echoes beyond the goal are left out.
+
+  The weights e^(-beta*d) come from planExp[], built once, and the beam
+  directions from the sin/cos table in fixed.c, so a plan costs a few
+  integer multiplies per beam and no calls to exp(), sin() or cos().
 
 */
-#include <math.h>                             // Needed for sin(), cos (), atan2()
+#include <math.h>                             // Needed for sqrt(), exp()
 
 #include "simpletools.h"                      // Include simpletools header
 #include "plan.h"                             // Function declarations
@@ -21,28 +41,126 @@
 #include "botports.h"                         // Ports in use for the ActivityBot
 #include "slam.h"                             // Localization, transforms, and maps
 #include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "fixed.h"                            // Fixed-point arithmetic
 
+#define PLAN_EXP_SHIFT 2                      // log2(cm per planExp[] entry)
+#define PLAN_EXP_SIZE  64                     // Entries; beyond the last, e^(-beta*d) is 0
+#define PLAN_COS_SLIDE 0.342                  // Avoid is the push turned 70 degrees
+#define PLAN_SIN_SLIDE 0.940
+#define PLAN_CLEAR     fx_fromFloat(0.9)      // Goal share above which the bot is in the clear
 
 // --- ActivityBot current plan (xdot, ydot)
 float plan[] = {0.0, 0.0};
 
+// --- The last plan's parts: goal and avoid vectors (mm/s, world frame),
+// --- the goal's share s (Q16.16) and the nearest echo (mm, 0 if none)
+float planGoal[2] = {0.0, 0.0};
+float planAvoid[2] = {0.0, 0.0};
+int planShare = FX_ONE;
+int planNearest = 0;
+
+// --- Distance to the goal (mm) and the side avoid slides to (1 left,
+// --- -1 right)
+static float planRange = 0.0;
+static int planSide = 1;
+
+// --- e^(-beta * d) in Q16.16, for d in steps of 1 << PLAN_EXP_SHIFT cm
+static int planExp[PLAN_EXP_SIZE + 1];
+static int planReady = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _planInit()
+{
+  // Fill planExp[]; the last entry is 0 so lookups past the end fade out
+  for (int i = 0; i < PLAN_EXP_SIZE; i++)
+    planExp[i] = fx_fromFloat(exp(-PLAN_BETA * 10.0 * (i << PLAN_EXP_SHIFT)));
+  planExp[PLAN_EXP_SIZE] = 0;
+  planReady = 1;
+}
+
+int _planWeight(int cm)
+{
+  // e^(-beta * cm) in Q16.16, interpolating between planExp[] entries
+  int i = cm >> PLAN_EXP_SHIFT, f = cm & ((1 << PLAN_EXP_SHIFT) - 1);
+  if (cm < 0) return FX_ONE;
+  if (i >= PLAN_EXP_SIZE) return 0;
+  return planExp[i] - (((planExp[i] - planExp[i + 1]) * f) >> PLAN_EXP_SHIFT);
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
 // --- Overall plan selection
-void makePlan(float *goal, float *obstacle)
+void makePlan(float *goal)
 {
-  float beta = 0.5;      // Blending factor
-  float s;
-  float obsD = 0.0;
-  
-  s = 1.0 - exp(-beta * obsD);
-  
-  plan[0] = 0.0;
-  plan[1] = 0.0;
+  // Blend heading for goal (x,y) with steering clear of the latest scan
+  float s, push[2], turn;
+
+  gotoGoal(goal);
+  avoidObstacle(push);
+
+  planShare = FX_ONE - (planNearest > 0 ? _planWeight(planNearest / 10) : 0);
+
+  // Slide to the goal's side of the push, picking the side while still
+  // in the clear and keeping it until clear again
+  turn = push[0] * planGoal[1] - push[1] * planGoal[0];
+  if (planShare > PLAN_CLEAR) planSide = turn < 0 ? -1 : 1;
+  planAvoid[0] = PLAN_COS_SLIDE * push[0] - PLAN_SIN_SLIDE * planSide * push[1];
+  planAvoid[1] = PLAN_COS_SLIDE * push[1] + PLAN_SIN_SLIDE * planSide * push[0];
+
+  s = fx_toFloat(planShare);
+  plan[0] = s * planGoal[0] + (1.0 - s) * planAvoid[0];
+  plan[1] = s * planGoal[1] + (1.0 - s) * planAvoid[1];
 }
+
  // --- Possible planning functions
 void gotoGoal(float *goal)
 {
+  // Head for goal (x,y), slowing in the last PLAN_SPEED / PLAN_K_GOAL mm
+  float dx = goal[0] - botP[0];
+  float dy = goal[1] - botP[1];
+  float d = sqrt(dx*dx + dy*dy);
+  float k = PLAN_K_GOAL;
+
+  planRange = d;
+  if (d * k > PLAN_SPEED) k = PLAN_SPEED / d;
+  planGoal[0] = k * dx;
+  planGoal[1] = k * dy;
 }
   
 void avoidObstacle(float *obstacle)
 {
-}  
\ No newline at end of file
+  // Put in obstacle[] a push away from the echoes in scan_cm[], each
+  // weighted by e^(-beta * range); PLAN_SPEED straight away from a
+  // single echo. Echoes beyond the goal of the last gotoGoal() are
+  // ignored. Sets planNearest.
+  unsigned int theta;
+  int sx = 0, sy = 0, sw = 0;
+
+  if (!planReady) _planInit();
+  theta = bam_fromRadians(botP[2]);
+  planNearest = 0;
+  for (int i = 0; i < numAngles; i++) {
+    int cm = scan_cm[i], w;
+    unsigned int a;
+    if (cm <= 0 || cm * 10 >= MAP_RANGE) continue;
+    if (planRange > 0.0 && cm * 10 > planRange) continue;
+    if (planNearest == 0 || cm * 10 < planNearest) planNearest = cm * 10;
+    w = _planWeight(cm);
+    a = theta + scanAngle[i] * BAM_PER_DEG;
+    sx += fx_mul(w, fx_cos(a));
+    sy += fx_mul(w, fx_sin(a));
+    sw += w;
+  }
+  if (sw == 0) {
+    obstacle[0] = 0.0;
+    obstacle[1] = 0.0;
+    return;
+  }
+  obstacle[0] = -PLAN_SPEED * sx / sw;
+  obstacle[1] = -PLAN_SPEED * sy / sw;
+}  
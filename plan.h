@@ -2,10 +2,18 @@
 #ifndef _PLAN_H_
 #define _PLAN_H_
 
+#define PLAN_SPEED    150.0         // mm/s, fastest plan
+#define PLAN_K_GOAL   1.0           // 1/s, pull toward the goal per mm off
+#define PLAN_BETA     0.005         // 1/mm, how fast an echo's push fades
+
 // --- Planning
 extern float plan[2];
+extern float planGoal[2];
+extern float planAvoid[2];
+extern int planShare;
+extern int planNearest;
 
-void makePlan(float *goal, float *obstacle);
+void makePlan(float *goal);
 void gotoGoal(float *goal);
 void avoidObstacle(float *obstacle);
 
@@ -0,0 +1,171 @@
+/*
+  profile.c
+
+  Velocity profiles for the ActivityBot's planned paths. goTowardPose()
+  and GoToGoal.c hold the speed between 33 and 200 mm/s however sharp
+  the turn, and when the turn asks more of the wheels than maxSpeed
+  allows, _setDelta() in move.c quietly takes it out of the speed. A
+  profile sets the speed along the path ahead of time instead, from
+  what the bot can actually do.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  The path is a list of waypoints joined by straight lines. vpBuild()
+  puts points along it every vpStep mm (VP_DS, or more for a long path)
+  and gives each the fastest speed allowed by:
+
+  - the bend there: the curvature k of the circle through the points
+    VP_SPAN mm behind and ahead on the path. Going round it at v takes
+    v^2 k of sideways acceleration, which must stay under VP_LATERAL;
+    and the outer wheel goes at v (1 + k W / 2), which must stay under
+    maxSpeed. A corner between two straight segments is treated as the
+    bend a follower rounds it on.
+  - the cap asked for.
+
+  Then two passes bring in the drive's ramp, rampStep ticks/s every 20
+  ms. The forward pass keeps each speed within reach of the one before
+  from a standing start (or vStart); the backward pass keeps each within
+  reach of stopping for the one after, down to 0 at the end. What is
+  left is the fastest profile the limits allow.
+
+  The profile is a short per point: 256 bytes.
+
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "move.h"                             // Move the ActivityBot around
+#include "profile.h"                          // Function declarations
+
+short vpSpeed[VP_SAMPLES];
+int vpCount = 0;
+float vpStep = VP_DS;
+float vpLength = 0.0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _vpPoint(float path[][2], int n, float s, float *p)
+{
+  // The point s mm along path, clamped to its ends
+  int i = 0;
+  if (s < 0) s = 0;
+  for (; i < n - 2; i++) {
+    float len = sqrt(pow(path[i + 1][0] - path[i][0], 2.0) + pow(path[i + 1][1] - path[i][1], 2.0));
+    if (s <= len) break;
+    s -= len;
+  }
+  {
+    float dx = path[i + 1][0] - path[i][0], dy = path[i + 1][1] - path[i][1];
+    float len = sqrt(dx*dx + dy*dy);
+    float t = len > 0 ? s / len : 0;
+    if (t > 1) t = 1;
+    p[0] = path[i][0] + t * dx;
+    p[1] = path[i][1] + t * dy;
+  }
+}
+
+float _vpCurvature(float *a, float *b, float *c)
+{
+  // Curvature (1/mm) of the circle through a, b and c: four times the
+  // area of the triangle over the product of its sides
+  float ab = sqrt(pow(b[0] - a[0], 2.0) + pow(b[1] - a[1], 2.0));
+  float bc = sqrt(pow(c[0] - b[0], 2.0) + pow(c[1] - b[1], 2.0));
+  float ca = sqrt(pow(a[0] - c[0], 2.0) + pow(a[1] - c[1], 2.0));
+  float cross = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+  if (ab * bc * ca == 0) return 0.0;
+  return 2 * fabs(cross) / (ab * bc * ca);
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void vpBuild(float path[][2], int n, float vStart, float vMax)
+{
+  // Profile path[0] to path[n - 1] (mm) starting at vStart and going no
+  // faster than vMax (mm/s)
+  float wheel = maxSpeed * 3.25;
+  float accel = (rampStep > 0 ? rampStep : 1) * 50 * 3.25;  // mm/s/s
+  int last;
+
+  vpLength = 0;
+  for (int i = 0; i < n - 1; i++)
+    vpLength += sqrt(pow(path[i + 1][0] - path[i][0], 2.0) + pow(path[i + 1][1] - path[i][1], 2.0));
+  if (n < 2 || vpLength == 0) {
+    vpCount = 0;
+    return;
+  }
+  vpCount = ceil(vpLength / VP_DS) + 1;
+  if (vpCount > VP_SAMPLES) vpCount = VP_SAMPLES;
+  vpStep = vpLength / (vpCount - 1);
+  last = vpCount - 1;
+  if (vMax > wheel) vMax = wheel;
+
+  // The bends and the cap
+  for (int i = 0; i <= last; i++) {
+    float a[2], b[2], c[2], k, v = vMax;
+    _vpPoint(path, n, i * vpStep - VP_SPAN, a);
+    _vpPoint(path, n, i * vpStep, b);
+    _vpPoint(path, n, i * vpStep + VP_SPAN, c);
+    k = _vpCurvature(a, b, c);
+    if (k * v * v > VP_LATERAL) v = sqrt(VP_LATERAL / k);
+    if (v * (1 + k * VP_WIDTH / 2) > wheel) v = wheel / (1 + k * VP_WIDTH / 2);
+    vpSpeed[i] = v;
+  }
+  if (vpSpeed[0] > vStart) vpSpeed[0] = vStart;
+  vpSpeed[last] = 0;
+
+  // Forward pass: no faster than the ramp can get there
+  for (int i = 1; i <= last; i++) {
+    float v = sqrt(vpSpeed[i - 1] * vpSpeed[i - 1] + 2 * accel * vpStep);
+    if (vpSpeed[i] > v) vpSpeed[i] = v;
+  }
+
+  // Backward pass: no faster than the ramp can stop from in time
+  for (int i = last - 1; i >= 0; i--) {
+    float v = sqrt(vpSpeed[i + 1] * vpSpeed[i + 1] + 2 * accel * vpStep);
+    if (vpSpeed[i] > v) vpSpeed[i] = v;
+  }
+}
+
+float vpAt(float s)
+{
+  // Speed (mm/s) s mm along the path, between the points either side
+  int i;
+  float t;
+  if (vpCount == 0) return 0.0;
+  if (s <= 0) return vpSpeed[0];
+  if (s >= vpLength) return vpSpeed[vpCount - 1];
+  i = s / vpStep;
+  if (i >= vpCount - 1) return vpSpeed[vpCount - 1];
+  t = s / vpStep - i;
+  return vpSpeed[i] + t * (vpSpeed[i + 1] - vpSpeed[i]);
+}
+
+float vpTime()
+{
+  // Seconds the profile takes end to end
+  float t = 0;
+  for (int i = 0; i < vpCount - 1; i++)
+    if (vpSpeed[i] + vpSpeed[i + 1] > 0)
+      t += 2 * vpStep / (vpSpeed[i] + vpSpeed[i + 1]);
+  return t;
+}
+
+void vpBudget()
+{
+  // Report the profile and the hub RAM it takes
+  print("profile: %d points %d mm apart, %d mm, %d ms, %d bytes%c\n", vpCount, (int)vpStep,
+        (int)vpLength, (int)(vpTime() * 1000), (int)sizeof(vpSpeed), CLREOL);
+}
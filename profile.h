@@ -0,0 +1,27 @@
+//   Velocity profiles for planned paths
+//
+//   Works out, once per path, the fastest speed at each point along it
+//   that the wheels, the drive's ramp and the bends allow, so a follower
+//   can run flat out on the straights and slow only where it has to.
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#define VP_SAMPLES    128           // Most points in a profile
+#define VP_DS         50.0          // mm; closest spacing of the points
+#define VP_SPAN       150.0         // mm; bends are measured over this either side
+#define VP_LATERAL    300.0         // mm/s/s; most sideways acceleration in a bend
+#define VP_WIDTH      105.8         // mm; wheel spacing
+
+// --- The profile: vpCount speeds (mm/s) vpStep mm apart, from the start
+// --- of the path to its end, vpLength mm along
+extern short vpSpeed[VP_SAMPLES];
+extern int vpCount;
+extern float vpStep;
+extern float vpLength;
+
+void  vpBuild(float path[][2], int n, float vStart, float vMax);
+float vpAt(float s);
+float vpTime();
+void  vpBudget();
+
+#endif
@@ -0,0 +1,123 @@
+/*
+  pt.c
+
+  Runs protothreads (pt.h) on one cog. startSensor() spends a cog and a
+  100-long stack on the sensor loop, and the motion queue another cog
+  and 128 longs, for loops that spend most of their time waiting on the
+  servo or the clock. As protothreads they can take turns on one cog,
+  each for the few bytes of its pt, and leave the other cogs for work
+  that has to run alongside.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  A protothread is a function whose body sits in a switch on the line
+  it last waited at (Dunkels' local continuations). A wait stores the
+  line and returns; the next call jumps back to it. So a thread needs
+  no stack of its own while it waits, and its waits can only be in its
+  own body, not in functions it calls: whatever it calls runs to the
+  end before any other thread gets the cog.
+
+  ptStep() runs each thread once, in the order they were added, and
+  drops those that ended. If none yielded, it then sleeps the cog until
+  the soonest wake time of those waiting on the clock, or no longer
+  than PT_POLL_MS if one is waiting on a condition or an event, which
+  may be set from another cog. ptRun() steps until every thread has
+  ended or one calls ptQuit().
+
+  Events are counters: ptSignal() counts one, and PT_WAIT_EVENT() waits
+  for the count to change. Any number of threads can wait on the same
+  event, and a signal from another cog is seen too, with no lock.
+
+*/
+#include "simpletools.h"                      // Include simpletools header
+
+#include "pt.h"                               // Function declarations
+
+static pt *ptState[PT_THREADS];
+static ptThread ptRunners[PT_THREADS];
+static int ptCount = 0;
+static volatile int ptRunning = 0;
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+int ptAdd(pt *p, ptThread thread)
+{
+  // Start thread with state p. Returns its slot, or -1 if there is no room.
+  int i;
+  for (i = 0; i < ptCount; i++)
+    if (!ptRunners[i]) break;
+  if (i == PT_THREADS) return -1;
+  PT_INIT(p);
+  ptState[i] = p;
+  ptRunners[i] = thread;
+  if (i == ptCount) ptCount++;
+  return i;
+}
+
+int ptStep()
+{
+  // Run each thread once, then sleep until one is due. Returns the
+  // number of threads still running.
+  int alive = 0, ready = 0, polling = 0, sleeping = 0;
+  unsigned int wake = 0, now;
+
+  for (int i = 0; i < ptCount; i++) {
+    if (!ptRunners[i]) continue;
+    switch (ptRunners[i](ptState[i])) {
+      case PT_ENDED:
+        ptRunners[i] = 0;
+        continue;
+      case PT_YIELDED:
+        ready = 1;
+        break;
+      case PT_WAITING:
+        polling = 1;
+        break;
+      case PT_SLEEPING:
+        if (!sleeping || (int)(ptState[i]->wake - wake) < 0) wake = ptState[i]->wake;
+        sleeping = 1;
+        break;
+    }
+    alive++;
+  }
+  while (ptCount > 0 && !ptRunners[ptCount-1]) ptCount--;
+
+  if (ready || alive == 0) return alive;
+  now = CNT;
+  if (polling) {
+    unsigned int poll = now + PT_POLL_MS * (CLKFREQ / 1000);
+    if (!sleeping || (int)(poll - wake) < 0) wake = poll;
+  }
+  if ((int)(wake - now) > PT_WAIT_MIN) waitcnt(wake);
+  return alive;
+}
+
+void ptRun()
+{
+  // Run the threads until they have all ended or one calls ptQuit()
+  ptRunning = 1;
+  while (ptRunning && ptStep() > 0)
+    ;
+  ptRunning = 0;
+}
+
+void ptQuit()
+{
+  ptRunning = 0;
+}
+
+void ptSignal(volatile unsigned int *ev)
+{
+  // Count an event; threads in PT_WAIT_EVENT() on it go on
+  (*ev)++;
+}
@@ -0,0 +1,92 @@
+//   Protothreads for the ActivityBot
+//
+//   Stackless cooperative threads, so several loops (sensing, odometry,
+//   telemetry, behaviors) can share one cog instead of a cog and a stack
+//   each. A thread is a function that returns at each wait and picks up
+//   there on its next call; ptRun() calls them in turn, and sleeps the
+//   cog when they are all waiting on the clock.
+//
+//   A thread's locals don't survive a wait: keep state in statics or
+//   in a struct that embeds the pt. A switch of its own can't span a
+//   wait either, as the waits are case labels of a switch (PT_BEGIN).
+#ifndef _PT_H_
+#define _PT_H_
+
+#define PT_THREADS    8             // Threads ptRun() holds
+#define PT_POLL_MS    1             // Longest sleep while a thread waits on a condition
+#define PT_WAIT_MIN   2000          // CNT ticks; closer than this, spin, not waitcnt()
+
+// --- What a thread returned
+#define PT_WAITING    0             // On a condition or an event
+#define PT_SLEEPING   1             // On the clock, until wake
+#define PT_YIELDED    2             // Ready to go on
+#define PT_ENDED      3
+
+typedef struct pt {
+  int lc;                           // Line to go on from (0: the start)
+  unsigned int wake;                // CNT to go on at
+  unsigned int seen;                // Event count when the wait began
+} pt;
+
+typedef int (*ptThread)(pt *p);
+
+// --- The waits below are case labels the code before them runs into.
+// --- Say so, or -Wimplicit-fallthrough warns wherever a thread waits.
+#if defined(__has_attribute)
+#if __has_attribute(fallthrough)
+#define PT_FALLTHROUGH      __attribute__((fallthrough))
+#endif
+#endif
+#ifndef PT_FALLTHROUGH
+#define PT_FALLTHROUGH      do {} while (0)
+#endif
+
+// --- Thread body: PT_BEGIN(p); ... PT_END(p);
+#define PT_INIT(p)          ((p)->lc = 0, (p)->wake = CNT)
+#define PT_BEGIN(p)         switch ((p)->lc) { case 0:
+#define PT_END(p)           } (p)->lc = 0; return PT_ENDED
+#define PT_EXIT(p)          do { (p)->lc = 0; return PT_ENDED; } while (0)
+#define PT_RESTART(p)       do { (p)->lc = 0; return PT_YIELDED; } while (0)
+
+// --- Let the other threads run, then go on
+#define PT_YIELD(p) \
+  do { (p)->lc = __LINE__; return PT_YIELDED; case __LINE__:; } while (0)
+
+// --- Go on once c is true; c is checked each time the thread is run
+#define PT_WAIT_UNTIL(p, c) \
+  do { (p)->lc = __LINE__; PT_FALLTHROUGH; case __LINE__: \
+       if (!(c)) return PT_WAITING; } while (0)
+
+// --- Go on at CNT t...
+#define PT_WAIT_CNT(p, t) \
+  do { (p)->wake = (t); (p)->lc = __LINE__; PT_FALLTHROUGH; case __LINE__: \
+       if ((int)(CNT - (p)->wake) < 0) return PT_SLEEPING; } while (0)
+
+// --- ... ms from now...
+#define PT_WAIT_MS(p, ms) \
+  PT_WAIT_CNT(p, CNT + (unsigned int)(ms) * (CLKFREQ / 1000))
+
+// --- ... or ms after the last wake, for a fixed rate that doesn't
+// --- drift with the work between. Behind by a whole period or more, it
+// --- starts again from now rather than run back to back to catch up.
+#define PT_WAIT_NEXT(p, ms) \
+  do { unsigned int _period = (unsigned int)(ms) * (CLKFREQ / 1000); \
+       if ((int)(CNT - (p)->wake) >= (int)_period) (p)->wake = CNT; \
+       PT_WAIT_CNT(p, (p)->wake + _period); } while (0)
+
+// --- Go on once event ev (a counter, see ptSignal()) has been signalled
+// --- since the wait began
+#define PT_WAIT_EVENT(p, ev) \
+  do { (p)->seen = (ev); PT_WAIT_UNTIL(p, (ev) != (p)->seen); } while (0)
+
+// --- Run child thread c to the end
+#define PT_SPAWN(p, c, call) \
+  do { PT_INIT(c); PT_WAIT_UNTIL(p, (call) == PT_ENDED); } while (0)
+
+int  ptAdd(pt *p, ptThread thread);
+int  ptStep();
+void ptRun();
+void ptQuit();
+void ptSignal(volatile unsigned int *ev);
+
+#endif
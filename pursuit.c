@@ -0,0 +1,158 @@
+/*
+  pursuit.c
+
+  Pure pursuit path following for the ActivityBot. goTowardPose() in
+  move.c drives at one goal, slows to a crawl as it nears it and then
+  turns on the spot, so a route of several waypoints stops and pivots
+  at each. Here the bot steers for a point some way down the route
+  instead, and rounds each corner on an arc without stopping.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  Take the speed from a velocity profile (profile.c)
+
+  Each tick ppFollow():
+
+  1. Finds the look-ahead point: where a circle of radius L around the
+     bot last crosses the route, searching forward from the segment it
+     was on. L is PP_LOOK_MIN plus PP_LOOK_TIME of travel at the bot's
+     speed, so it looks farther ahead and cuts corners more smoothly when
+     going fast, and tracks tightly when slow. Once the end of the route
+     is within L, the end is the look-ahead point.
+  2. Takes the arc from the bot, tangent to its heading, through that
+     point: curvature 2 y / L^2, with y the point's offset to the left.
+  3. Picks the speed: the route's velocity profile (profile.c, built by
+     ppSetPath()) at how far along it the bot is, and no faster than
+     keeps the outer wheel under maxSpeed on this arc, so _setDelta()
+     never has to take the turn out of the speed.
+  4. Drives v and v * curvature with botSetVW().
+
+*/
+#include <math.h>                             // Needed for sqrt(), sin(), cos()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "profile.h"                          // Velocity profiles
+#include "pursuit.h"                          // Function declarations
+
+float ppPath[PP_POINTS][2];
+int ppPoints = 0;
+int ppSeg = 0;
+int ppAt = 0;
+float ppProgress = 0.0;
+float ppTarget[2];
+float ppCurve = 0.0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+float _ppDist(float *a, float *b)
+{
+  return sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]));
+}
+
+int _ppCross(int i, float look, float *p)
+{
+  // Where a circle of radius look around the bot leaves segment i, put in
+  // p[]. Returns 0 if it doesn't.
+  float dx = ppPath[i + 1][0] - ppPath[i][0], dy = ppPath[i + 1][1] - ppPath[i][1];
+  float fx = ppPath[i][0] - botP[0], fy = ppPath[i][1] - botP[1];
+  float a = dx*dx + dy*dy, b = 2 * (fx*dx + fy*dy), c = fx*fx + fy*fy - look*look;
+  float disc = b*b - 4*a*c, t;
+  if (a == 0 || disc < 0) return 0;
+  t = (-b + sqrt(disc)) / (2 * a);
+  if (t < 0 || t > 1) return 0;
+  p[0] = ppPath[i][0] + t * dx;
+  p[1] = ppPath[i][1] + t * dy;
+  return 1;
+}
+
+float _ppAlong(int i)
+{
+  // How far along segment i the bot is, 0 at its start and 1 at its end
+  float dx = ppPath[i + 1][0] - ppPath[i][0], dy = ppPath[i + 1][1] - ppPath[i][1];
+  float a = dx*dx + dy*dy;
+  if (a == 0) return 1;
+  return ((botP[0] - ppPath[i][0]) * dx + (botP[1] - ppPath[i][1]) * dy) / a;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void ppSetPath(float path[][2], int n)
+{
+  // Follow the waypoints path[0] to path[n - 1] (mm, world frame). The
+  // first is usually where the bot is.
+  if (n > PP_POINTS) n = PP_POINTS;
+  for (int i = 0; i < n; i++) {
+    ppPath[i][0] = path[i][0];
+    ppPath[i][1] = path[i][1];
+  }
+  ppPoints = n;
+  ppSeg = 0;
+  ppAt = 0;
+  ppProgress = 0;
+  vpBuild(ppPath, n, abs(botSpeed) * 3.25, PP_SPEED);
+}
+
+int ppFollow()
+{
+  // One tick of following the path: steer for the look-ahead point.
+  // Returns 1 while following, 0 once at the end (and stopped).
+  float look = PP_LOOK_MIN + PP_LOOK_TIME * abs(botSpeed) * 3.25;
+  float *end = ppPath[ppPoints > 0 ? ppPoints - 1 : 0];
+  float v, c = cos(botP[2]), s = sin(botP[2]);
+  float done = 0, x, y, k;
+
+  if (ppPoints == 0 || _ppDist(botP, end) < PP_CLOSE) {
+    botSetVW(0.0, 0.0);
+    return 0;
+  }
+
+  // 1. The look-ahead point. Segments whose end is inside the circle are
+  // behind it; if the bot has strayed so far that the circle misses the
+  // segment it is on, steer for that segment's end.
+  while (ppSeg < ppPoints - 1 && _ppDist(botP, ppPath[ppSeg + 1]) < look)
+    ppSeg++;
+  if (ppSeg >= ppPoints - 1) {
+    ppSeg = ppPoints - 1;
+    ppTarget[0] = end[0];
+    ppTarget[1] = end[1];
+  } else if (!_ppCross(ppSeg, look, ppTarget)) {
+    ppTarget[0] = ppPath[ppSeg + 1][0];
+    ppTarget[1] = ppPath[ppSeg + 1][1];
+  }
+
+  // 2. The arc through it, in the bot frame
+  x = (ppTarget[0] - botP[0]) * c + (ppTarget[1] - botP[1]) * s;
+  y = (ppTarget[1] - botP[1]) * c - (ppTarget[0] - botP[0]) * s;
+  ppCurve = x*x + y*y > 1 ? 2 * y / (x*x + y*y) : 0.0;
+
+  // 3. The speed. How far along the route the bot is: past the segments
+  // it has gone beyond the end of, and along the one it is on.
+  while (ppAt < ppPoints - 2 && _ppAlong(ppAt) >= 1)
+    ppAt++;
+  for (int i = 0; i < ppAt; i++)
+    done += _ppDist(ppPath[i], ppPath[i + 1]);
+  x = _ppAlong(ppAt);
+  ppProgress = done + (x < 0 ? 0 : x > 1 ? 1 : x) * _ppDist(ppPath[ppAt], ppPath[ppAt + 1]);
+  v = vpAt(ppProgress);
+  k = fabs(ppCurve);
+  if (v * (1 + k * VP_WIDTH / 2) > maxSpeed * 3.25) v = maxSpeed * 3.25 / (1 + k * VP_WIDTH / 2);
+  if (v < PP_CREEP) v = PP_CREEP;
+
+  // 4. Drive it
+  botSetVW(v, v * ppCurve);
+  return 1;
+}
@@ -0,0 +1,31 @@
+//   Pure pursuit path following for the ActivityBot
+//
+//   Follows a list of waypoints without stopping at any of them. Each
+//   tick the bot steers along the arc through a point a look-ahead
+//   distance down the path, farther out the faster it goes, at the speed
+//   the path's velocity profile (profile.c) gives for where it is.
+#ifndef _PURSUIT_H_
+#define _PURSUIT_H_
+
+#define PP_POINTS     16            // Most waypoints in a path
+#define PP_SPEED      416.0         // mm/s on the straight, if maxSpeed allows
+#define PP_LOOK_MIN   100.0         // mm; look-ahead at a standstill...
+#define PP_LOOK_TIME  0.6           // s; ... plus this long at the current speed
+#define PP_CREEP      30.0          // mm/s; slowest, short of the end
+#define PP_CLOSE      20.0          // mm; end of the path reached
+
+// --- The path, and the last tick: segment being followed, segment the
+// --- bot is on and how far along the path (mm), the point steered for
+// --- (mm, world frame) and the curvature of the arc (1/mm)
+extern float ppPath[PP_POINTS][2];
+extern int ppPoints;
+extern int ppSeg;
+extern int ppAt;
+extern float ppProgress;
+extern float ppTarget[2];
+extern float ppCurve;
+
+void ppSetPath(float path[][2], int n);
+int  ppFollow();
+
+#endif
@@ -0,0 +1,293 @@
+/*
+  reloc.c
+
+  Global relocalization for the ActivityBot. After a reboot, or when the
+  bot has been carried somewhere, the pose is unknown. relocAddScan()
+  collects one or two PING))) sweeps taken at the same spot (turning in
+  place between them is fine: odometry tracks the turn). relocSearch()
+  then finds the pose from which they best fit the map in slam.c.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  Poses are scored as in field.c: the sum of the likelihood field
+  penalties at the echoes. The search is at field cell resolution (128
+  mm) for position and RELOC_STEP degrees for heading, which is about one
+  cell of swing at the longest range, and then refined around the best.
+
+  An exhaustive search would score every heading at all 64 x 64 cells.
+  Instead, for each heading, the translations are split into blocks of
+  16 x 16 cells, then 8 x 8, and so on down to single cells. A pyramid
+  holds, for each block size, the smallest field distance in each block.
+  A block of translations moves each echo over at most 2 x 2 pyramid
+  blocks of its size, so the smallest distance among those gives a
+  penalty no worse than any translation in the block can get. The sum of
+  those bounds the score of the whole block, and a block whose bound is
+  no better than the best pose found so far is dropped unopened. Blocks
+  are opened depth first, the best of each four first, so a good pose is
+  found early and most of the pose space is never looked at.
+
+  The pyramid is built from lfCells[] at each search: 1360 bytes for
+  RELOC_LEVELS of 4.
+
+*/
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "field.h"                            // Likelihood field
+#include "reloc.h"                            // Function declarations
+
+#define RELOC_CELL_SHIFT (MAP_CELL_SHIFT + LF_SHIFT)   // log2(field cell in mm)
+#define RELOC_PYR     ((LF_SIZE * LF_SIZE - (LF_SIZE >> RELOC_LEVELS) * (LF_SIZE >> RELOC_LEVELS)) / 3)
+#define RELOC_STACK   (4 * RELOC_LEVELS + (LF_SIZE >> RELOC_LEVELS) * (LF_SIZE >> RELOC_LEVELS))
+
+// --- Refinement around the best pose: +-RELOC_FINE_XY steps of 32 mm and
+// --- +-RELOC_FINE_TH steps of 1 degree
+#define RELOC_FINE_XY 3
+#define RELOC_FINE_TH 2
+
+// --- An echo, relative to the bot's heading at the first sweep
+typedef struct {
+  unsigned int turn;                // Bot heading (binary angle)
+  unsigned int dir;                 // Beam direction (binary angle)
+  int r;                            // mm
+} relocBeam;
+
+// --- A block of translations: cells (x,y) to (x,y) + 2^level - 1
+typedef struct {
+  signed char x, y, level;
+  short bound;
+} relocNode;
+
+unsigned int relocTicks = 0;
+int relocNodes = 0;
+int relocScore = 0;
+
+static relocBeam beams[RELOC_BEAMS];
+static int numBeams = 0;
+static unsigned int firstTheta = 0;
+static unsigned char pyr[RELOC_PYR];
+static int pyrAt[RELOC_LEVELS + 1];
+static signed char ox[RELOC_BEAMS], oy[RELOC_BEAMS];
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _relocBuild()
+{
+  // Pyramid level k holds the smallest field distance in each block of
+  // 2^k x 2^k cells
+  int at = 0;
+  for (int k = 1; k <= RELOC_LEVELS; k++) {
+    int n = LF_SIZE >> k;
+    pyrAt[k] = at;
+    for (int y = 0; y < n; y++) {
+      for (int x = 0; x < n; x++) {
+        int d = LF_FAR;
+        for (int j = 0; j < 4; j++) {
+          int cx = 2 * x + (j & 1), cy = 2 * y + (j >> 1), c;
+          if (k == 1)
+            c = lfCells[(cy << LF_BITS) | cx];
+          else
+            c = pyr[pyrAt[k - 1] + cy * (2 * n) + cx];
+          if (c < d) d = c;
+        }
+        pyr[at++] = d;
+      }
+    }
+  }
+}
+
+int _relocLevel(int k, int bx, int by)
+{
+  // Smallest field distance in block (bx,by) of level k; LF_FAR off the field
+  int n = LF_SIZE >> k;
+  if ((unsigned int)bx >= (unsigned int)n || (unsigned int)by >= (unsigned int)n) return LF_FAR;
+  if (k == 0) return lfCells[(by << LF_BITS) | bx];
+  return pyr[pyrAt[k] + by * n + bx];
+}
+
+int _relocBound(int k, int cx, int cy, int limit)
+{
+  // Penalty no translation in the block can beat, for the echo offsets
+  // in ox[] and oy[]. Gives up once it reaches limit.
+  int pen = 0, w = (1 << k) - 1;
+  for (int i = 0; i < numBeams && pen < limit; i++) {
+    int x0 = cx + ox[i], y0 = cy + oy[i];
+    int bx0 = x0 >> k, bx1 = (x0 + w) >> k;
+    int by0 = y0 >> k, by1 = (y0 + w) >> k;
+    int d = _relocLevel(k, bx0, by0), e;
+    if (bx1 != bx0 && (e = _relocLevel(k, bx1, by0)) < d) d = e;
+    if (by1 != by0 && (e = _relocLevel(k, bx0, by1)) < d) d = e;
+    if (bx1 != bx0 && by1 != by0 && (e = _relocLevel(k, bx1, by1)) < d) d = e;
+    pen += lfPenalty(d);
+  }
+  relocNodes++;
+  return pen;
+}
+
+int _relocScore(int x, int y, unsigned int theta)
+{
+  // Penalty of the echoes from pose (x,y,theta), Q16.16 mm and a binary
+  // angle, as lfScore() scores a scan
+  int pen = 0;
+  for (int i = 0; i < numBeams; i++) {
+    relocBeam *b = &beams[i];
+    int ex = x + PINGOFFSET * fx_cos(theta + b->turn) + b->r * fx_cos(theta + b->dir);
+    int ey = y + PINGOFFSET * fx_sin(theta + b->turn) + b->r * fx_sin(theta + b->dir);
+    int fx = (ex >> (16 + RELOC_CELL_SHIFT)) + LF_SIZE/2;
+    int fy = (ey >> (16 + RELOC_CELL_SHIFT)) + LF_SIZE/2;
+    pen += lfPenalty(lfDistance(fx, fy));
+  }
+  return pen;
+}
+
+void _relocPush(relocNode *stack, int *top, int base, int x, int y, int k, int bound)
+{
+  // Push keeping the entries from base up sorted by bound, best on top
+  int i = (*top)++;
+  while (i > base && stack[i - 1].bound < bound) {
+    stack[i] = stack[i - 1];
+    i--;
+  }
+  stack[i].x = x;
+  stack[i].y = y;
+  stack[i].level = k;
+  stack[i].bound = bound;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void relocClear()
+{
+  // Forget the sweeps collected so far
+  numBeams = 0;
+}
+
+int relocAddScan()
+{
+  // Add the echoes of the latest sweep (scan_cm[] at scanAngle[]). The
+  // bot may have turned in place since the first sweep, but not moved.
+  // Returns the echoes held.
+  unsigned int turn;
+  if (numBeams == 0) firstTheta = odomTheta;
+  turn = odomTheta - firstTheta;
+  for (int i = 0; i < numAngles && numBeams < RELOC_BEAMS; i++) {
+    int r = scan_cm[i] * 10;
+    if (r <= 0 || r >= MAP_RANGE) continue;
+    beams[numBeams].turn = turn;
+    beams[numBeams].dir = turn + scanAngle[i] * BAM_PER_DEG;
+    beams[numBeams].r = r;
+    numBeams++;
+  }
+  return numBeams;
+}
+
+int relocSearch(float pose[3])
+{
+  // Find the pose from which the sweeps best fit the map, and put it in
+  // pose[] (as it is now, after any turn since the first sweep). Returns
+  // the penalty there, or -1 if there are no echoes to go on.
+  unsigned int t = CNT;
+  relocNode stack[RELOC_STACK];
+  int best = 0x7FFF, bx = 0, by = 0, roots = LF_SIZE >> RELOC_LEVELS;
+  unsigned int bth = 0;
+
+  relocNodes = 0;
+  if (numBeams == 0) return -1;
+  lfUpdate();
+  _relocBuild();
+
+  for (int h = 0; h < 360; h += RELOC_STEP) {
+    unsigned int theta = (unsigned int)h * BAM_PER_DEG;
+    int top = 0;
+
+    // Echo offsets from the bot's cell at this heading, in cells
+    for (int i = 0; i < numBeams; i++) {
+      relocBeam *b = &beams[i];
+      int ex = PINGOFFSET * fx_cos(theta + b->turn) + b->r * fx_cos(theta + b->dir);
+      int ey = PINGOFFSET * fx_sin(theta + b->turn) + b->r * fx_sin(theta + b->dir);
+      ox[i] = (ex + fx_fromInt(LF_CELL/2)) >> (16 + RELOC_CELL_SHIFT);
+      oy[i] = (ey + fx_fromInt(LF_CELL/2)) >> (16 + RELOC_CELL_SHIFT);
+    }
+
+    // Branch and bound, depth first, opening the best block of each four
+    // first
+    for (int y = 0; y < roots; y++) {
+      for (int x = 0; x < roots; x++) {
+        int cx = x << RELOC_LEVELS, cy = y << RELOC_LEVELS;
+        int b = _relocBound(RELOC_LEVELS, cx, cy, best);
+        if (b < best) _relocPush(stack, &top, 0, cx, cy, RELOC_LEVELS, b);
+      }
+    }
+    while (top > 0) {
+      relocNode n = stack[--top];
+      int k = n.level - 1, base = top;
+      if (n.bound >= best) continue;
+      if (n.level == 0) {
+        best = n.bound;
+        bx = n.x;
+        by = n.y;
+        bth = theta;
+        continue;
+      }
+      for (int j = 0; j < 4; j++) {
+        int cx = n.x + ((j & 1) << k), cy = n.y + ((j >> 1) << k);
+        int b = _relocBound(k, cx, cy, best);
+        if (b < best) _relocPush(stack, &top, base, cx, cy, k, b);
+      }
+    }
+  }
+
+  // Refine around the best cell and heading
+  {
+    int x0 = fx_fromInt((bx - LF_SIZE/2) * LF_CELL + LF_CELL/2);
+    int y0 = fx_fromInt((by - LF_SIZE/2) * LF_CELL + LF_CELL/2);
+    int fine = 0x7FFFFFFF, fx = x0, fy = y0;
+    unsigned int fth = bth;
+    for (int k = -RELOC_FINE_TH; k <= RELOC_FINE_TH; k++) {
+      for (int i = -RELOC_FINE_XY; i <= RELOC_FINE_XY; i++) {
+        for (int j = -RELOC_FINE_XY; j <= RELOC_FINE_XY; j++) {
+          int x = x0 + fx_fromInt(32 * i), y = y0 + fx_fromInt(32 * j);
+          unsigned int th = bth + k * BAM_PER_DEG;
+          int pen = _relocScore(x, y, th);
+          if (pen < fine || (pen == fine && i == 0 && j == 0 && k == 0)) {
+            fine = pen;
+            fx = x;
+            fy = y;
+            fth = th;
+          }
+        }
+      }
+    }
+    pose[0] = fx_toFloat(fx);
+    pose[1] = fx_toFloat(fy);
+    pose[2] = bam_toRadians(fth + (odomTheta - firstTheta));
+    relocScore = fine;
+  }
+  relocTicks = CNT - t;
+  return relocScore;
+}
+
+void relocBudget()
+{
+  // Report what the search costs in hub RAM and time
+  print("reloc: %d echoes, %d bytes%c\n", numBeams,
+        (int)(sizeof(beams) + sizeof(pyr) + sizeof(ox) + sizeof(oy)), CLREOL);
+  print("reloc: last search %d nodes of %d exhaustive, %d cycles%c\n",
+        relocNodes, (360 / RELOC_STEP) * LF_SIZE * LF_SIZE, relocTicks, CLREOL);
+}
@@ -0,0 +1,25 @@
+//   Global relocalization for the ActivityBot
+//
+//   Finds the pose from one or two PING))) sweeps against a stored map,
+//   with no starting guess. Branch and bound over a pyramid of the
+//   likelihood field (field.c) skips most of the pose space. Include
+//   slam.h and field.h first.
+#ifndef _RELOC_H_
+#define _RELOC_H_
+
+#define RELOC_LEVELS  4             // Pyramid levels: blocks of 2 to 16 field cells
+#define RELOC_STEP    2             // Heading step of the search (degrees)
+#define RELOC_BEAMS   (2 * SCAN_MAX)
+
+// --- The last search: CNT ticks, pyramid nodes scored, and the best
+// --- penalty found, in eighths of a nat as in field.h
+extern unsigned int relocTicks;
+extern int relocNodes;
+extern int relocScore;
+
+void relocClear();
+int  relocAddScan();
+int  relocSearch(float pose[3]);
+void relocBudget();
+
+#endif
@@ -0,0 +1,196 @@
+/*
+  sched.c
+
+  A fixed-rate scheduler for the ActivityBot's control loop. The main
+  loops did their work and then pause(100), so the period was 100 ms
+  plus however long the work took, and that changed with every PING)))
+  timeout and every line printed, while pid_omega() and updatePose()
+  took it to be a steady 100 ms. Here each step of the loop is a task
+  with its own period, released on a fixed grid of CNT times that
+  doesn't drift with the work, and the scheduler keeps count of how
+  well it holds to it.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  schAdd() registers a task: a function to call every periodMs. schRun()
+  then, over and over:
+
+  1. Of the tasks whose release time has come, runs the one with the
+     shortest period, so a slow planner can't hold up a fast estimator
+     any longer than the planner's one run (rate-monotonic priority; a
+     task on one cog runs to the end, it isn't preempted).
+  2. With none due, waits for the next release with waitcnt(), or spins
+     if it is closer than SCH_WAIT_MIN: waitcnt() on a time already
+     past waits for CNT to wrap, 53 s at 80 MHz.
+
+  A task's next release is its last plus its period, not its start plus
+  its period, so lateness doesn't add up into drift. A run that ends
+  past its next release is an overrun. If it ends a whole period or
+  more past it, the releases it covered are dropped rather than run
+  back to back to catch up, and counted.
+
+  Per task it counts runs, overruns and dropped releases, and the most
+  and total lateness (start past release: the jitter of its period) and
+  run time. schReport() prints them; schUs() turns CNT ticks to us.
+
+  Times are compared as differences of CNT, which are right across its
+  wrap as long as they are under 26 s at 80 MHz; periods are kept well
+  inside that.
+
+*/
+#include "simpletools.h"                      // Include simpletools header
+
+#include "sched.h"                            // Function declarations
+
+schTask schTasks[SCH_TASKS];
+int schCount = 0;
+
+static volatile int schRunning = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+int _schDue()
+{
+  // The task due to run now with the shortest period, or -1 if none is.
+  int best = -1;
+  unsigned int now = CNT;
+  for (int i = 0; i < schCount; i++) {
+    if ((int)(now - schTasks[i].release) < 0) continue;
+    if (best < 0 || schTasks[i].period < schTasks[best].period) best = i;
+  }
+  return best;
+}
+
+unsigned int _schNext()
+{
+  // The soonest release
+  unsigned int next = schTasks[0].release;
+  for (int i = 1; i < schCount; i++)
+    if ((int)(schTasks[i].release - next) < 0) next = schTasks[i].release;
+  return next;
+}
+
+void _schWait(unsigned int until)
+{
+  int left = (int)(until - CNT);
+  if (left > SCH_WAIT_MIN) waitcnt(until);
+  else while ((int)(until - CNT) > 0);
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+int schAdd(char *name, void (*fn)(void), int periodMs)
+{
+  // Register fn to run every periodMs. Returns its index in schTasks,
+  // or -1 if there is no room.
+  schTask *t;
+  if (schCount >= SCH_TASKS || periodMs <= 0) return -1;
+  t = &schTasks[schCount];
+  t->name = name;
+  t->fn = fn;
+  t->period = (unsigned int)periodMs * (CLKFREQ / 1000);
+  t->release = CNT;
+  return schCount++;
+}
+
+void schStart()
+{
+  // Release every task now, and start the counts afresh
+  unsigned int now = CNT;
+  for (int i = 0; i < schCount; i++) schTasks[i].release = now;
+  schClear();
+}
+
+int schStep()
+{
+  // Wait for the next task due, run it, and return its index
+  int i;
+  unsigned int start, end, late;
+  schTask *t;
+
+  if (schCount == 0) return -1;
+  while ((i = _schDue()) < 0) _schWait(_schNext());
+  t = &schTasks[i];
+
+  start = CNT;
+  late = start - t->release;
+  t->fn();
+  end = CNT;
+
+  t->runs++;
+  t->lateSum += late;
+  if (late > t->lateMax) t->lateMax = late;
+  t->execSum += end - start;
+  if (end - start > t->execMax) t->execMax = end - start;
+
+  t->release += t->period;
+  if ((int)(end - t->release) > 0) {
+    unsigned int missed = (end - t->release) / t->period;
+    t->overruns++;
+    t->dropped += missed;
+    t->release += missed * t->period;
+  }
+  return i;
+}
+
+void schRun(int ms)
+{
+  // Run tasks for ms, or with ms 0, until schQuit()
+  unsigned int until = CNT + (unsigned int)ms * (CLKFREQ / 1000);
+  schStart();
+  schRunning = 1;
+  while (schRunning) {
+    if (ms > 0 && (int)(_schNext() - until) >= 0) {
+      _schWait(until);
+      break;
+    }
+    schStep();
+  }
+  schRunning = 0;
+}
+
+void schQuit()
+{
+  // Stop schRun() once the task running returns
+  schRunning = 0;
+}
+
+void schClear()
+{
+  for (int i = 0; i < schCount; i++) {
+    schTask *t = &schTasks[i];
+    t->runs = t->overruns = t->dropped = 0;
+    t->lateMax = t->lateSum = 0;
+    t->execMax = t->execSum = 0;
+  }
+}
+
+int schUs(unsigned int ticks)
+{
+  return (int)(ticks / (CLKFREQ / 1000000));
+}
+
+void schReport()
+{
+  // One line per task: period, runs, overruns, dropped, lateness and run time (us)
+  print("task        period  runs  over  drop  late avg/max  run avg/max%c\n", CLREOL);
+  for (int i = 0; i < schCount; i++) {
+    schTask *t = &schTasks[i];
+    int n = t->runs > 0 ? t->runs : 1;
+    print("%-10s %5d ms %5d %5d %5d %6d/%-6d %6d/%-6d%c\n", t->name,
+          schUs(t->period) / 1000, t->runs, t->overruns, t->dropped,
+          schUs((unsigned int)(t->lateSum / n)), schUs(t->lateMax), schUs((unsigned int)(t->execSum / n)), schUs(t->execMax), CLREOL);
+  }
+}
@@ -0,0 +1,40 @@
+//   Fixed-rate task scheduler for the ActivityBot
+//
+//   Sense, estimate, plan and act steps are registered as tasks with a
+//   period each, and run on one cog at release times kept on CNT, the
+//   shortest period first (rate monotonic). Each task's lateness, run
+//   time, missed deadlines and dropped releases are counted, so a loop
+//   rate is something measured rather than a pause(100) and a hope.
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#define SCH_TASKS     8             // Tasks the scheduler holds
+#define SCH_WAIT_MIN  2000          // CNT ticks; closer than this, spin, not waitcnt()
+
+typedef struct {
+  char *name;
+  void (*fn)(void);
+  unsigned int period;              // CNT ticks
+  unsigned int release;             // CNT when its next run is due
+  int runs;
+  int overruns;                     // Runs that ended past the next release
+  int dropped;                      // Releases skipped as the last run was too late
+  unsigned int lateMax;             // Start past release, CNT ticks: most...
+  unsigned long long lateSum;       // ... and total
+  unsigned int execMax;             // Run time, CNT ticks: most...
+  unsigned long long execSum;       // ... and total
+} schTask;
+
+extern schTask schTasks[SCH_TASKS];
+extern int schCount;
+
+int  schAdd(char *name, void (*fn)(void), int periodMs);
+void schStart();
+int  schStep();
+void schRun(int ms);
+void schQuit();
+void schClear();
+int  schUs(unsigned int ticks);
+void schReport();
+
+#endif
@@ -0,0 +1,183 @@
+/*
+  scurve.c
+
+  Jerk-limited motion profiles for the ActivityBot. botMove() and
+  botTurn() stop dead, then hand drive_goto() a tick count to cover at
+  abdrive's one ramp rate, so every move pays for a full stop and start,
+  and the acceleration jumps straight from nothing to full. Here a move
+  is planned from the speed the wheel already has, with the
+  acceleration built up and eased off over SC_JERK_MS, and can end still
+  moving so the next one carries on from there. Only the motion queue
+  (motion.c) knows what comes next, so only it plans this way.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  A profile is three parts: a change of speed from v0 up (or down) to a
+  cruising speed, the cruise, and a change down to vEnd. Each change is
+  an S: jerk builds the acceleration up to aMax, it holds there, and jerk
+  takes it off again; if the change is too small to reach aMax the hold
+  is left out and the peak is lower. The S is symmetric, so however it
+  is shaped it covers the average of its two speeds times its time.
+
+  scPlan() finds the fastest cruise, up to vMax, whose two changes fit
+  in the distance, by halving the interval; whatever distance is left
+  over is covered at the cruise. If the distance is too short even to
+  get from v0 to vEnd, it overshoots, and the caller's feedback has to
+  bring it back.
+
+  scPlanWheels() plans both wheels at abdrive's ramp rate and maxSpeed,
+  then slows the quicker one so both end together, keeping a move
+  straight and a turn on the spot.
+
+*/
+#include <math.h>                             // Needed for sqrt()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "move.h"                             // Move the ActivityBot around
+#include "scurve.h"                           // Function declarations
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+float _scRamp(scRamp *r, float va, float vb, float aMax, float jMax)
+{
+  // Plan a change from va to vb. Returns the distance it covers.
+  float dv = fabs(vb - va), s = vb >= va ? 1 : -1;
+  r->va = va;
+  r->vb = vb;
+  if (dv >= aMax * aMax / jMax) {
+    r->ta = aMax / jMax;
+    r->tc = dv / aMax - r->ta;
+    r->ap = s * aMax;
+  } else {
+    r->ta = sqrt(dv / jMax);
+    r->tc = 0;
+    r->ap = s * jMax * r->ta;
+  }
+  return (va + vb) / 2 * (2 * r->ta + r->tc);
+}
+
+float _scRampAt(scRamp *r, float t, float *v)
+{
+  // Distance covered t into change r, and the speed then
+  float j = r->ta > 0 ? r->ap / r->ta : 0;
+  float v1, x1, v2, x2;
+  if (t <= r->ta) {
+    *v = r->va + j * t * t / 2;
+    return r->va * t + j * t * t * t / 6;
+  }
+  v1 = r->va + j * r->ta * r->ta / 2;
+  x1 = r->va * r->ta + j * r->ta * r->ta * r->ta / 6;
+  t -= r->ta;
+  if (t <= r->tc) {
+    *v = v1 + r->ap * t;
+    return x1 + v1 * t + r->ap * t * t / 2;
+  }
+  v2 = v1 + r->ap * r->tc;
+  x2 = x1 + v1 * r->tc + r->ap * r->tc * r->tc / 2;
+  t -= r->tc;
+  if (t > r->ta) t = r->ta;
+  *v = v2 + r->ap * t - j * t * t / 2;
+  return x2 + v2 * t + r->ap * t * t / 2 - j * t * t * t / 6;
+}
+
+float _scChanges(scProfile *p, float v0, float vc, float vEnd, float aMax, float jMax)
+{
+  // Plan the changes into and out of cruising at vc. Returns their distance.
+  p->cruise = vc;
+  return _scRamp(&p->up, v0, vc, aMax, jMax) + _scRamp(&p->down, vc, vEnd, aMax, jMax);
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void scPlan(scProfile *p, float dist, float v0, float vEnd, float vMax, float aMax, float jMax)
+{
+  // Plan covering dist, starting at v0 and ending at vEnd, no faster
+  // than vMax, accelerating at no more than aMax and changing that at
+  // no more than jMax. vEnd must be the way dist goes, or 0.
+  float lo, hi, d;
+
+  p->sign = dist < 0 ? -1 : 1;
+  p->dist = fabs(dist);
+  v0 *= p->sign;
+  vEnd *= p->sign;
+  if (vEnd < 0) vEnd = 0;
+  if (vEnd > vMax) vEnd = vMax;
+  if (v0 > vMax) v0 = vMax;
+  lo = vEnd > v0 ? vEnd : v0 > 0 ? v0 : 0;
+  hi = vMax;
+
+  if (_scChanges(p, v0, hi, vEnd, aMax, jMax) > p->dist) {
+    if (_scChanges(p, v0, lo, vEnd, aMax, jMax) < p->dist) {
+      for (int i = 0; i < 16; i++) {
+        if (_scChanges(p, v0, (lo + hi) / 2, vEnd, aMax, jMax) > p->dist) hi = (lo + hi) / 2;
+        else lo = (lo + hi) / 2;
+      }
+    }
+    hi = lo;
+  }
+  d = _scChanges(p, v0, hi, vEnd, aMax, jMax);
+  p->tCruise = hi > 0.01 && d < p->dist ? (p->dist - d) / hi : 0;
+  p->time = 2 * p->up.ta + p->up.tc + p->tCruise + 2 * p->down.ta + p->down.tc;
+}
+
+void scStretch(scProfile *p, float time, float v0, float vEnd, float vMax, float aMax, float jMax)
+{
+  // Replan p, cruising slower, to take time instead (if it would be quicker)
+  float dist = p->dist * p->sign, lo = 0, hi = vMax;
+  if (p->time >= time || p->dist < 0.5) return;
+  for (int i = 0; i < 16; i++) {
+    scPlan(p, dist, v0, vEnd, (lo + hi) / 2, aMax, jMax);
+    if (p->time > time) lo = (lo + hi) / 2;
+    else hi = (lo + hi) / 2;
+  }
+  scPlan(p, dist, v0, vEnd, hi, aMax, jMax);
+}
+
+float scAt(scProfile *p, float t, float *v)
+{
+  // Distance along p t seconds in, and the speed then. Past the end it
+  // carries on at the end speed.
+  float t1 = 2 * p->up.ta + p->up.tc, t2 = 2 * p->down.ta + p->down.tc, x;
+  if (t < 0) t = 0;
+  if (t <= t1) {
+    x = _scRampAt(&p->up, t, v);
+  } else if (t <= t1 + p->tCruise) {
+    *v = p->cruise;
+    x = (p->up.va + p->up.vb) / 2 * t1 + p->cruise * (t - t1);
+  } else if (t <= p->time) {
+    x = (p->up.va + p->up.vb) / 2 * t1 + p->cruise * p->tCruise
+      + _scRampAt(&p->down, t - t1 - p->tCruise, v);
+  } else {
+    *v = p->down.vb;
+    x = (p->up.va + p->up.vb) / 2 * t1 + p->cruise * p->tCruise
+      + (p->down.va + p->down.vb) / 2 * t2 + p->down.vb * (t - p->time);
+  }
+  *v *= p->sign;
+  return x * p->sign;
+}
+
+void scPlanWheels(scWheels *w, float ticksL, float ticksR, float v0L, float v0R, float vEndL, float vEndR)
+{
+  // Plan each wheel's ticks from its speed now to its end speed (ticks/s)
+  // at abdrive's ramp rate and under maxSpeed, ending together
+  float aMax = (rampStep > 0 ? rampStep : 1) * 50.0;    // ticks/s/s
+  float jMax = aMax * 1000 / SC_JERK_MS;
+  scPlan(&w->left, ticksL, v0L, vEndL, maxSpeed, aMax, jMax);
+  scPlan(&w->right, ticksR, v0R, vEndR, maxSpeed, aMax, jMax);
+  w->time = w->left.time > w->right.time ? w->left.time : w->right.time;
+  scStretch(&w->left, w->time, v0L, vEndL, maxSpeed, aMax, jMax);
+  scStretch(&w->right, w->time, v0R, vEndR, maxSpeed, aMax, jMax);
+}
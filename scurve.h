@@ -0,0 +1,39 @@
+//   Jerk-limited (S-curve) motion profiles
+//
+//   Plans how fast to go, moment by moment, to cover a distance starting
+//   and ending at given speeds, within a top speed, acceleration and
+//   jerk. Used a wheel at a time, in encoder ticks, by the motion queue
+//   (motion.c).
+#ifndef _SCURVE_H_
+#define _SCURVE_H_
+
+#define SC_JERK_MS    80            // ms to build up to full acceleration
+#define SC_GAIN       5.0           // 1/s; wheel speed per tick behind the plan
+
+typedef struct {                    // One change of speed
+  float va, vb;                     // From and to
+  float ta;                         // Time building up (and easing off) acceleration
+  float tc;                         // Time at full acceleration
+  float ap;                         // That acceleration, signed
+} scRamp;
+
+typedef struct {
+  float dist;                       // To cover, >= 0 (sign gives the direction)
+  float sign;
+  scRamp up, down;                  // Start to cruise, cruise to end
+  float cruise;                     // Speed between
+  float tCruise;                    // Time at it
+  float time;                       // Total
+} scProfile;
+
+typedef struct {                    // A profile for each wheel, ending together
+  scProfile left, right;
+  float time;
+} scWheels;
+
+void  scPlan(scProfile *p, float dist, float v0, float vEnd, float vMax, float aMax, float jMax);
+void  scStretch(scProfile *p, float time, float v0, float vEnd, float vMax, float aMax, float jMax);
+float scAt(scProfile *p, float t, float *v);
+void  scPlanWheels(scWheels *w, float ticksL, float ticksR, float v0L, float v0R, float vEndL, float vEndR);
+
+#endif
@@ -19,6 +19,13 @@
   2015-08-18   2.2  Add updatePose()
 
   2015-12-01   3.0 Rename from sensors.c, move updatePose() to slam.c 
+  2026-10-17   3.1  Sensor cog runs continuously and publishes snapshots
+  2026-10-17   3.2  Asynchronous, pipelined pingScan()
+  2026-10-17   3.3  Runtime scan patterns, serpentine sweep order
+  2026-10-17   3.4  sensorThread(): the sensor loop as a protothread,
+                    and sensorEvent for each new snapshot
+  2026-10-17   3.5  stopSensor(): finish a snapshot the cog was stopped
+                    in the middle of
 
 */
 #include <math.h>                             // Needed for sin(), cos (), atan2()
@@ -29,46 +36,220 @@
 #include "abdrive.h"                          // Include abdrive header
 
 #include "botports.h"                         // Ports in use for the ActivityBot
+#include "pt.h"                               // Protothreads
 #include "sense.h"                            // Function declarations
 
 // --- PING))) sensor
-int pingerAngle = 900;
-int pingFront = 1000;
-int pingLeft = 1000;
-int pingRight = 1000;
-int scanAngle[] = {-90, -80, -70, -60, -50, -40, -30, -20, -10, 0, 10, 20, 30, 40, 50, 60, 70, 80, 90};
-int scan_cm[]   = {  0,   0,   0,   0,   0,   0,   0,   0,   0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0};
-int numAngles   = sizeof(scanAngle) / sizeof(*scanAngle);
+volatile int pingerAngle = 900;
+volatile int pingFront = 1000;
+volatile int pingLeft = 1000;
+volatile int pingRight = 1000;
+static scanPattern defaultPattern = {
+  19, {-90, -80, -70, -60, -50, -40, -30, -20, -10, 0, 10, 20, 30, 40, 50, 60, 70, 80, 90},
+  SCAN_SERPENTINE, 0, 0
+};
+static scanPattern *pattern = &defaultPattern;
+int *scanAngle  = defaultPattern.angle;
+int scan_cm[SCAN_MAX];
+int numAngles   = 19;
 // --- IR sensors
-int detectLeft = 0;
-int detectRight = 0;
+volatile int detectLeft = 0;
+volatile int detectRight = 0;
 // --- Odometry
 int ticksL = 0;
 int ticksR = 0;
 // --- General variables
 static int *cog = 0;
+static volatile unsigned int sensorPeriod = 0;  // clock ticks, 0 = flat out
+// --- Latest readings, guarded by a sequence counter that is odd while
+// --- an update is in progress
+static volatile unsigned int sensorSeq = 0;
+static volatile sensorData sensorNow;
+volatile unsigned int sensorEvent = 0;   // Counts snapshots, for PT_WAIT_EVENT()
+static unsigned int sensorAt = 0;        // CNT of sensorThread()'s last pass
+// --- Asynchronous scanner
+#define SCAN_IDLE   0
+#define SCAN_SLEW   1
+volatile int scanBeams = 0;         // Beams read so far in this sweep
+static int scanState = SCAN_IDLE;
+static int scanNext = 0;            // scanAngle[] index being aimed at
+static int scanStep = 1;            // +1 sweeping up, -1 sweeping down
+static unsigned int scanStart = 0;  // CNT when the sweep began
+static unsigned int settleAt = 0;   // CNT when the servo will be there
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _aim(int angle)
+{
+  // Start the PING))) servo toward angle (degrees, bot frame) and work
+  // out when it will get there.
+  int deltaAngle;
+  // Convert from bot coordinate frame to servo coordinate frame
+  // (i.e., servo 0 is 90 degrees clockwise)
+  angle = 10 * angle + 900;
+  while (angle > 1800)
+    angle = angle - 3600;
+  while (angle < -1800)
+    angle = angle + 3600;
+
+  if (angle < 0) angle = 0;
+  if (angle > 1800) angle = 1800; 
+  servo_angle(PINGSERVO, angle+PINGBIAS);
+
+  // Allow time for sensor to move
+  deltaAngle = pingerAngle > angle ? pingerAngle-angle : angle-pingerAngle;
+  settleAt = CNT;
+  if (deltaAngle > 10) settleAt += deltaAngle/2 * (CLKFREQ/1000);
+
+  pingerAngle = angle;
+}
+
+void _snapshot()
+{
+  // Copy the readings in the globals into the snapshot
+  int l, r;
+  drive_getTicks(&l, &r);
+
+  sensorNow.time = CNT;
+  sensorNow.detectLeft = detectLeft;
+  sensorNow.detectRight = detectRight;
+  sensorNow.pingFront = pingFront;
+  sensorNow.pingLeft = pingLeft;
+  sensorNow.pingRight = pingRight;
+  sensorNow.ticksL = l;
+  sensorNow.ticksR = r;
+}
+
+void _publish()
+{
+  // Publish the readings in the globals as a new snapshot for sensorRead()
+  sensorSeq++;
+  _snapshot();
+  sensorSeq++;
+  sensorEvent++;
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
 
 int *startSensor()
 {
   if(!cog){
-    cog = cog_run(&updateSensor, 100);
+    cog = cog_run(&sensorLoop, 100);
   }
   return cog;
 }
 
 void stopSensor()
 {
-  cog_end(cog);
+  // Stop the sensor cog. If it was stopped in the middle of publishing,
+  // sensorSeq is left odd and sensorRead() would wait on it forever, so
+  // finish that snapshot here.
+  if (cog) cog_end(cog);
   cog = 0;
+  if (sensorSeq & 1) {
+    _snapshot();
+    sensorSeq++;
+    sensorEvent++;
+  }
+}
+
+void sensorSetRate(int hz)
+{
+  // Set how often the sensor cog takes readings. The rate is an upper
+  // limit: a pass that needs to swing the PING))) sideways takes longer.
+  sensorPeriod = hz > 0 ? CLKFREQ / hz : 0;
+}
+
+void sensorLoop(void *par)
+{
+  // Sensor cog: take readings forever at the rate set by sensorSetRate()
+  unsigned int t = CNT;
+  (void)par;
+
+  while (1) {
+    updateSensor();
+    t += sensorPeriod;
+    if ((int)(t - CNT) > 0) {
+      waitcnt(t);
+    } else {
+      t = CNT;                            // Overran, so don't try to catch up
+    }
+  }
 }
 
 void updateSensor()
 {
+  // One pass over the sensors. Results go to the globals and to a new
+  // snapshot for sensorRead().
   detectLeft = irLeft();
+  if (detectLeft) {
+    pingLeft = pingAngle(90);
+  }
+
   detectRight = irRight();
-  //updateTicks();
-  pingerAngle = 900;
-  pingFront = pingAngle(pingerAngle);
+  if (detectRight) {
+    pingRight = pingAngle(-90);
+  }
+
+  pingFront = pingAngle(0);
+  _publish();
+}
+
+int sensorThread(pt *p)
+{
+  // The sensor loop as a protothread, to share a cog with others instead
+  // of taking one of its own: ptAdd(&p, sensorThread). The same passes as
+  // updateSensor() at the rate set by sensorSetRate(), but it lets the
+  // other threads run while the servo slews and between passes. The
+  // ping itself still holds the cog until the echo is back (19 ms at most).
+  PT_BEGIN(p);
+  sensorAt = CNT;
+  while (1) {
+    detectLeft = irLeft();
+    if (detectLeft) {
+      _aim(90);
+      PT_WAIT_CNT(p, settleAt);
+      pingLeft = ping_cm(PINGER);
+    }
+
+    detectRight = irRight();
+    if (detectRight) {
+      _aim(-90);
+      PT_WAIT_CNT(p, settleAt);
+      pingRight = ping_cm(PINGER);
+    }
+
+    _aim(0);
+    PT_WAIT_CNT(p, settleAt);
+    pingFront = ping_cm(PINGER);
+    _publish();
+
+    sensorAt += sensorPeriod;
+    if ((int)(CNT - sensorAt) >= (int)sensorPeriod) sensorAt = CNT;  // Overran, so don't try to catch up
+    if (sensorPeriod) PT_WAIT_CNT(p, sensorAt);
+    else PT_YIELD(p);
+  }
+  PT_END(p);
+}
+
+unsigned int sensorRead(sensorData *s)
+{
+  // Copy the latest snapshot without taking a lock. If the sensor cog
+  // published while we were copying, copy again. Returns the sequence
+  // number, which changes each time a new snapshot is published.
+  unsigned int seq;
+
+  do {
+    while ((seq = sensorSeq) & 1)
+      ;
+    *s = sensorNow;
+  } while (seq != sensorSeq);
+
+  return seq;
 }
 
 int pingHere()
@@ -81,35 +262,136 @@ int pingHere()
 
 void pingScan()
 {
-  for (int i=0; i < numAngles; i++) {
-    if (scanAngle[i] < -90) scanAngle[i] = -90;
-    if (scanAngle[i] >  90) scanAngle[i] =  90;
-    scan_cm[i] = pingAngle(scanAngle[i]);
+  // Blocking sweep over scanAngle[], built on the asynchronous scanner
+  pingScanStart();
+  while (!pingScanComplete())
+    pingScanPoll();
+}
+
+void scanPatternRange(scanPattern *p, int from, int to, int step)
+{
+  // Pattern from one angle to another (degrees, bot frame) in fixed steps
+  int n = 0;
+
+  if (step < 1) step = 1;
+  if (from > to) {
+    int t = from;
+    from = to;
+    to = t;
   }
+  for (int a = from; a <= to && n < SCAN_MAX; a += step)
+    p->angle[n++] = a;
+  scanPatternSet(p, p->angle, n);
 }
 
-int pingAngle(int angle)
+void scanPatternSet(scanPattern *p, const int *angles, int n)
 {
-  int deltaAngle;
-  // Convert from bot coordinate frame to servo coordinate frame
-  // (i.e., servo 0 is 90 degrees clockwise)
-  angle = 10 * angle + 900;
-  while (angle > 1800)
-    angle = angle - 3600;
-  while (angle < -1800)
-    angle = angle + 3600;
+  // Pattern over an arbitrary set of angles (degrees, bot frame). They
+  // are clipped to the servo's range and kept in ascending order.
+  if (n > SCAN_MAX) n = SCAN_MAX;
+  for (int i = 0; i < n; i++) {
+    int a = angles[i];
+    int j = i;
+    if (a < -90) a = -90;
+    if (a >  90) a =  90;
+    while (j > 0 && p->angle[j-1] > a) {
+      p->angle[j] = p->angle[j-1];
+      j--;
+    }
+    p->angle[j] = a;
+  }
+  p->count = n;
+  p->order = SCAN_SERPENTINE;
+  p->sweeps = 0;
+  p->sweepTicks = 0;
+}
 
-  if (angle < 0) angle = 0;
-  if (angle > 1800) angle = 1800; 
-  servo_angle(PINGSERVO, angle+PINGBIAS);
+float scanPatternRate(scanPattern *p)
+{
+  // Full sweeps per second, as measured on the last sweep
+  return p->sweepTicks ? (float)CLKFREQ / p->sweepTicks : 0.0;
+}
 
-  // Allow time for sensor to move
-  deltaAngle = pingerAngle > angle ? pingerAngle-angle : angle-pingerAngle;
-//  print("pingerAngle = %d, angle = %d, deltaAngle = %d %c\n", pingerAngle, angle, deltaAngle, CLREOL);
-  if(deltaAngle > 10) pause(deltaAngle/2);
+void pingScanPattern(scanPattern *p)
+{
+  // Scan with pattern p from now on. scanAngle[] and numAngles follow it.
+  pattern = p;
+  scanAngle = p->angle;
+  numAngles = p->count;
+  for (int i = 0; i < numAngles; i++)
+    scan_cm[i] = 0;
+  scanState = SCAN_IDLE;
+}
 
-  pingerAngle = angle;
+void pingScanStart()
+{
+  // Begin a sweep over scanAngle[]. Call pingScanPoll() often until
+  // pingScanComplete(); each beam lands in scan_cm[] as soon as it is read.
+  // Don't run this while the sensor cog is also driving the servo.
+  //
+  // Every beam has to be visited, so the least servo travel is to go to
+  // the nearer end of the pattern first and sweep to the other end.
+  // Back-to-back sweeps then alternate direction.
+  int first, last;
+
+  scanBeams = 0;
+  if (numAngles <= 0) {
+    scanState = SCAN_IDLE;
+    return;
+  }
+  first = 10 * scanAngle[0] + 900;
+  last = 10 * scanAngle[numAngles-1] + 900;
+  if (pattern->order == SCAN_SERPENTINE && abs(pingerAngle - last) < abs(pingerAngle - first)) {
+    scanNext = numAngles - 1;
+    scanStep = -1;
+  } else {
+    scanNext = 0;
+    scanStep = 1;
+  }
+  scanStart = CNT;
+  _aim(scanAngle[scanNext]);
+  scanState = SCAN_SLEW;
+}
 
+int pingScanPoll()
+{
+  // Read the next beam if the servo has had time to get there. Returns
+  // the scanAngle[] index of the beam that landed, or -1 if none did.
+  int i = scanNext;
+
+  if (scanState != SCAN_SLEW || (int)(CNT - settleAt) < 0)
+    return -1;
+
+  // Send the servo on to the next angle before pinging this one. The
+  // servo only picks up the new position at its next 20 ms pulse and
+  // then takes a moment to start moving, so the echo is normally back
+  // before the beam leaves this angle. The slew to the next angle then
+  // overlaps the echo wait instead of following it.
+  if (i + scanStep >= 0 && i + scanStep < numAngles) {
+    scanNext = i + scanStep;
+    _aim(scanAngle[scanNext]);
+    scan_cm[i] = ping_cm(PINGER);
+  } else {
+    scan_cm[i] = ping_cm(PINGER);
+    pattern->sweepTicks = CNT - scanStart;
+    pattern->sweeps++;
+    scanState = SCAN_IDLE;
+  }
+  scanBeams++;
+  return i;
+}
+
+int pingScanComplete()
+{
+  return scanState == SCAN_IDLE;
+}
+
+int pingAngle(int angle)
+{
+  // Point the PING))) at angle (degrees, bot frame), wait for the servo
+  // to get there, and return the range in cm
+  _aim(angle);
+  if ((int)(settleAt - CNT) > 0) waitcnt(settleAt);
   return(ping_cm(PINGER));
 }
 
@@ -1,21 +1,45 @@
 //   A set of routines to get data from the ActivityBot's sensors
+#ifndef _SENSE_H_
+#define _SENSE_H_
+
+// --- PING))) scan patterns
+#define SCAN_MAX        37          // Most beams in a pattern (5 degree steps)
+#define SCAN_SERPENTINE 0           // Sweep from whichever end is nearer
+#define SCAN_FORWARD    1           // Always sweep in ascending angle order
+
+typedef struct {
+  int count;                        // Beams in the pattern
+  int angle[SCAN_MAX];              // Degrees, bot frame, ascending
+  int order;                        // SCAN_SERPENTINE or SCAN_FORWARD
+  int sweeps;                       // Full sweeps completed
+  unsigned int sweepTicks;          // CNT ticks taken by the last sweep
+} scanPattern;
+
+void scanPatternRange(scanPattern *p, int from, int to, int step);
+void scanPatternSet(scanPattern *p, const int *angles, int n);
+float scanPatternRate(scanPattern *p);
 
 // --- PING))) scanner
-extern int pingerAngle;
-extern int pingFront;
-extern int pingLeft;
-extern int pingRight;
-extern int scanAngle[];
+extern volatile int pingerAngle;
+extern volatile int pingFront;
+extern volatile int pingLeft;
+extern volatile int pingRight;
+extern int *scanAngle;
 extern int scan_cm[];
 extern int numAngles;
+extern volatile int scanBeams;
 
 int pingHere();
 int pingAngle(int angle);
 void pingScan();
+void pingScanPattern(scanPattern *p);
+void pingScanStart();
+int pingScanPoll();
+int pingScanComplete();
 
 // --- IR Sensors
-extern int detectLeft;
-extern int detectRight;
+extern volatile int detectLeft;
+extern volatile int detectRight;
 
 int irLeft();
 int irRight();
@@ -27,6 +51,26 @@ extern int ticksR;
 void updateTicks();
 
 // --- General scanning functions
+typedef struct {
+  unsigned int time;      // CNT when the readings were published
+  int detectLeft;
+  int detectRight;
+  int pingFront;          // cm
+  int pingLeft;           // cm
+  int pingRight;          // cm
+  int ticksL;             // Encoder counts
+  int ticksR;
+} sensorData;
+
+struct pt;
+extern volatile unsigned int sensorEvent;
+
 int *startSensor();
 void stopSensor();
+void sensorSetRate(int hz);
+void sensorLoop(void *par);
 void updateSensor();
+int sensorThread(struct pt *p);
+unsigned int sensorRead(sensorData *s);
+
+#endif
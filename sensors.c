@@ -17,6 +17,7 @@
   2015-07-18   2.0  Include everything from IR sensors and PING)))
   2015-07-31   2.1  Add cog launcher code
   2015-08-18   2.2  Add updatePose() 
+  2026-10-17   2.3  updatePose() uses fixed-point odometry
 
 */
 #include <math.h>                             // Needed for sin(), cos (), atan2()
@@ -28,6 +29,7 @@
 
 #include "botports.h"                         // Ports in use for the ActivityBot
 #include "sensors.h"                          // Function declarations
+#include "odometry.h"                         // Fixed-point dead reckoning
 
 static int *cog = 0;
 
@@ -178,39 +180,18 @@ void updatePose()
 */
 void updatePose()
 {
+  // Dead reckoning in fixed point (see odometry.c)
   int newL = 0;
   int newR = 0;
-  int deltaL, deltaR;
-
-  float R, omega_dt;
-  float ICC[2];
-  float L = 105.8;
-  float step = 3.25;
-  float X, Y;
 
   drive_getTicks(&newL, &newR);
   print ("newL = %d newR = %d%c\n", newL, newR, CLREOL);
-  deltaL = newL - ticksL;
-  deltaR = newR - ticksR;
-  print ("deltaL = %d deltaR = %d%c\n", deltaL, deltaR, CLREOL);
-
-  if (deltaL == deltaR) {
-    X = botP[0] + deltaL * step * cos(botTheta);
-    Y = botP[1] + deltaL * step * sin(botTheta);
-    omega_dt = 0.0;
-
-  } else {
-    R = (L/2.0) * (deltaR + deltaL) / (deltaR - deltaL);
-    omega_dt = (deltaR - deltaL) * step / L;
-    ICC[0] = botP[0] - R * sin(botTheta);
-    ICC[1] = botP[1] + R * cos(botTheta);
-    X = ICC[0] + (botP[0]-ICC[0])*cos(omega_dt) - (botP[1]-ICC[1])*sin(omega_dt);
-    Y = ICC[1] + (botP[0]-ICC[0])*sin(omega_dt) + (botP[1]-ICC[1])*cos(omega_dt);
-  }
+  print ("deltaL = %d deltaR = %d%c\n", newL - ticksL, newR - ticksR, CLREOL);
+  odomUpdate(newL, newR);
 
-  botP[0] = X;
-  botP[1] = Y;
-  botTheta += omega_dt;
+  botP[0] = odomGetX();
+  botP[1] = odomGetY();
+  botTheta = odomGetTheta();
 
   ticksL = newL;
   ticksR = newR;
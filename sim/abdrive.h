@@ -0,0 +1,14 @@
+//   Host stand-in for the Propeller abdrive library (see sim.h)
+#ifndef _SIM_ABDRIVE_H_
+#define _SIM_ABDRIVE_H_
+
+#include "simpletools.h"
+
+void drive_speed(int left, int right);
+void drive_ramp(int left, int right);
+void drive_goto(int distLeft, int distRight);
+void drive_getTicks(int *left, int *right);
+void drive_setMaxSpeed(int speed);
+void drive_setRampStep(int stepsize);
+
+#endif
@@ -0,0 +1,11 @@
+//   Host stand-in for the Propeller ping library (see sim.h)
+#ifndef _SIM_PING_H_
+#define _SIM_PING_H_
+
+#include "simpletools.h"
+
+int ping(int pin);
+int ping_cm(int pin);
+int ping_inches(int pin);
+
+#endif
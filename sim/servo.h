@@ -0,0 +1,13 @@
+//   Host stand-in for the Propeller servo library (see sim.h)
+#ifndef _SIM_SERVO_H_
+#define _SIM_SERVO_H_
+
+#include "simpletools.h"
+
+int  servo_angle(int pin, int degreeTenths);
+int  servo_set(int pin, int time);
+int  servo_setramp(int pin, int stepSize);
+int  servo_get(int pin);
+void servo_stop();
+
+#endif
@@ -0,0 +1,895 @@
+/*
+  sim.c
+
+  Host-side simulation of the ActivityBot: a differential-drive model
+  behind abdrive, a ray-cast PING))) behind ping and servo, IR detectors
+  behind freqout()/input(), and a virtual clock behind pause() and CNT.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+  2026-10-17   1.1  sim_ns(): thread CPU time for the benches
+  2026-10-17   1.2  sim_defaultSlip(): a program's own default for SIM_SLIP
+
+  Cogs are host threads, but only one of them runs at a time. Each cog
+  holds the "baton" until it calls something that takes time (pause(),
+  ping, reading CNT, ...), and the baton then goes to whichever cog is
+  due next on the virtual clock. That keeps runs repeatable. A cog that
+  spins on a plain variable without ever calling into the library is
+  caught by a watchdog, which lets it run free and keeps the clock and
+  the other cogs moving.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "simpletools.h"
+#include "abdrive.h"
+#include "servo.h"
+#include "ping.h"
+#include "sim.h"
+
+#include "../botports.h"                      // Ports in use for the ActivityBot
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// --- Model constants
+#define PHYS_STEP      (SIM_CLKFREQ / 1000)   // Physics step, 1 ms in clock ticks
+#define CNT_COST       400                    // Clock ticks charged per CNT read
+#define WHEEL_MAX      128                    // abdrive hard limit, ticks/s
+#define SERVO_RATE     4                      // Servo slew, 0.1 deg per ms
+#define PING_TIMEOUT   18500                  // Echo time with nothing in range, us
+#define IR_ANGLE       (35.0*M_PI/180.0)      // IR detectors look out at +/-35 deg
+#define IR_CONE        (20.0*M_PI/180.0)      // ... over a +/-20 deg cone
+#define IR_RANGE       250.0                  // ... out to 250 mm
+#define IR_FORWARD     50.0                   // IR LEDs ahead of the axle (mm)
+#define IR_SIDE        35.0                   // ... and out from the centre line
+#define MAX_SEGS       512
+#define MAX_COGS       8
+#define SPIN_POLL_NS   1000000                // Watchdog poll period (1 ms)
+#define SPIN_POLLS     20                     // Polls without a call = spinning
+#define SPIN_ADVANCE   (50*PHYS_STEP)         // Clock advance per poll for spinners
+
+// --- World
+typedef struct { double x0, y0, x1, y1; } sim_seg;
+static sim_seg seg[MAX_SEGS];
+static int numSegs = 0;
+
+// --- Robot state
+typedef struct {
+  double pos;         // Encoder position (ticks)
+  double speed;       // Actual speed (ticks/s)
+  double target;      // Commanded speed (ticks/s)
+  double gotoPos;     // drive_goto() destination (ticks)
+  double gotoMax;     // drive_goto() cruise speed for this wheel (ticks/s)
+  double scale;       // Ground travel per encoder tick (slip model)
+} sim_wheel;
+
+static sim_wheel wheelL, wheelR;
+static int    gotoActive = 0;
+static int    gotoSpeed = WHEEL_MAX;
+static int    rampStep = 4;           // ticks/s per 20 ms, as abdrive
+static double pose[3] = {0.0, 0.0, 0.0};
+static int    collisions = 0;
+static int    inContact = 0;
+
+static int    servoCmd = 900 + PINGBIAS;
+static double servoPos = 900 + PINGBIAS;
+static int    irLit = -1;
+static unsigned long long irLitAt = 0;
+static unsigned int pinState = 0;
+
+// --- Configuration
+static double limitSeconds = 60.0;
+static double slip = 0.0;
+static double pingNoise = 0.0;
+static double pingCone = 15.0*M_PI/180.0;
+static int    quiet = 0;
+static unsigned int seed = 1;
+
+// --- Virtual clock and cogs
+typedef struct {
+  int       used;
+  int       killed;
+  int       spinning;
+  unsigned long long wake;
+  unsigned long calls;
+  pthread_t thread;
+  pthread_cond_t go;
+  void    (*fn)(void *);
+  void     *par;
+  int       info[2];
+} sim_cog;
+
+static pthread_mutex_t simLock = PTHREAD_MUTEX_INITIALIZER;
+static sim_cog cog[MAX_COGS];
+static int current = 0;               // Cog holding the baton, -1 if none
+static unsigned long long now = 0;    // Virtual clock (ticks)
+static unsigned long long physT = 0;  // Physics has been integrated to here
+static __thread int me = 0;           // Cog id of the calling thread
+static int started = 0;
+static struct timespec wallStart;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+static double _gauss()
+{
+  // Box-Muller on the repeatable rand_r() stream
+  double u = (rand_r(&seed) + 1.0) / (RAND_MAX + 2.0);
+  double v = (rand_r(&seed) + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2.0*log(u)) * cos(2.0*M_PI*v);
+}
+
+static double _segDist(const sim_seg *s, double x, double y)
+{
+  // Distance from (x,y) to segment s
+  double dx = s->x1 - s->x0;
+  double dy = s->y1 - s->y0;
+  double l2 = dx*dx + dy*dy;
+  double t = l2 > 0.0 ? ((x-s->x0)*dx + (y-s->y0)*dy) / l2 : 0.0;
+  if (t < 0.0) t = 0.0;
+  if (t > 1.0) t = 1.0;
+  dx = s->x0 + t*dx - x;
+  dy = s->y0 + t*dy - y;
+  return sqrt(dx*dx + dy*dy);
+}
+
+static double _clearance(double x, double y)
+{
+  double d = 1e9;
+  for (int i = 0; i < numSegs; i++) {
+    double di = _segDist(&seg[i], x, y);
+    if (di < d) d = di;
+  }
+  return d;
+}
+
+static double _coneRange(double x, double y, double a, double half, double maxRange)
+{
+  // Nearest return over a cone, sampled with 7 rays
+  double d = sim_castRay(x, y, a, maxRange);
+  if (half <= 0.0) return d;
+  for (int i = 1; i <= 3; i++) {
+    double r1 = sim_castRay(x, y, a + half*i/3.0, maxRange);
+    double r2 = sim_castRay(x, y, a - half*i/3.0, maxRange);
+    if (r1 < d) d = r1;
+    if (r2 < d) d = r2;
+  }
+  return d;
+}
+
+static double _wallSeconds()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (t.tv_sec - wallStart.tv_sec) + (t.tv_nsec - wallStart.tv_nsec) * 1e-9;
+}
+
+static void _summary()
+{
+  double sim = (double)now / SIM_CLKFREQ;
+  double wall = _wallSeconds();
+  fprintf(stderr, "sim: %.3f s simulated in %.3f s wall (%.0fx), "
+          "pose (%.1f, %.1f, %.1f deg), %d collisions\n",
+          sim, wall, wall > 0.0 ? sim/wall : 0.0,
+          pose[0], pose[1], pose[2]*180.0/M_PI, collisions);
+}
+
+static double _rampWheel(double speed, double want, double dt)
+{
+  double a = rampStep * 50.0 * dt;    // ramp step is per 1/50 s
+  if (want > speed + a) return speed + a;
+  if (want < speed - a) return speed - a;
+  return want;
+}
+
+static void _stepWheel(sim_wheel *w, double dt)
+{
+  double want = w->target;
+
+  if (gotoActive) {
+    // Trapezoidal approach to the goto destination
+    double rem = w->gotoPos - w->pos;
+    double a = rampStep * 50.0;
+    double v = sqrt(2.0 * a * fabs(rem));
+    if (v > w->gotoMax) v = w->gotoMax;
+    want = rem >= 0.0 ? v : -v;
+  }
+  if (want > WHEEL_MAX) want = WHEEL_MAX;
+  if (want < -WHEEL_MAX) want = -WHEEL_MAX;
+
+  w->speed = _rampWheel(w->speed, want, dt);
+  if (gotoActive) {
+    double rem = w->gotoPos - w->pos;
+    if (fabs(rem) <= fabs(w->speed) * dt || fabs(rem) < 0.01) {
+      w->pos = w->gotoPos;
+      if (fabs(rem) < 0.01) w->speed = 0.0;
+      return;
+    }
+  }
+  w->pos += w->speed * dt;
+}
+
+static void _stepPhysics()
+{
+  double dt = (double)PHYS_STEP / SIM_CLKFREQ;
+  double oldL = wheelL.pos;
+  double oldR = wheelR.pos;
+
+  _stepWheel(&wheelL, dt);
+  _stepWheel(&wheelR, dt);
+  if (gotoActive && wheelL.pos == wheelL.gotoPos && wheelR.pos == wheelR.gotoPos) {
+    gotoActive = 0;
+    wheelL.speed = wheelR.speed = 0.0;
+    wheelL.target = wheelR.target = 0.0;
+  }
+
+  // Ground travel of each wheel, then the exact arc for the pair
+  double dl = (wheelL.pos - oldL) * SIM_TICK_MM * wheelL.scale;
+  double dr = (wheelR.pos - oldR) * SIM_TICK_MM * wheelR.scale;
+  double dth = (dr - dl) / SIM_WHEEL_BASE;
+  double ds = (dr + dl) / 2.0;
+  double x, y;
+  if (fabs(dth) < 1e-9) {
+    x = pose[0] + ds * cos(pose[2]);
+    y = pose[1] + ds * sin(pose[2]);
+  } else {
+    double r = ds / dth;
+    x = pose[0] + r * (sin(pose[2] + dth) - sin(pose[2]));
+    y = pose[1] - r * (cos(pose[2] + dth) - cos(pose[2]));
+  }
+  pose[2] += dth;
+  while (pose[2] > M_PI) pose[2] -= 2.0*M_PI;
+  while (pose[2] < -M_PI) pose[2] += 2.0*M_PI;
+
+  // The chassis stops at walls but the wheels keep turning (and counting)
+  if (_clearance(x, y) < SIM_BOT_RADIUS && _clearance(x, y) < _clearance(pose[0], pose[1])) {
+    if (!inContact) collisions++;
+    inContact = 1;
+  } else {
+    pose[0] = x;
+    pose[1] = y;
+    inContact = 0;
+  }
+
+  // Servo slews toward its commanded position
+  if (servoPos < servoCmd) {
+    servoPos += SERVO_RATE;
+    if (servoPos > servoCmd) servoPos = servoCmd;
+  } else if (servoPos > servoCmd) {
+    servoPos -= SERVO_RATE;
+    if (servoPos < servoCmd) servoPos = servoCmd;
+  }
+}
+
+static void _advance(unsigned long long t)
+{
+  // Bring the world up to virtual time t (simLock held)
+  if ((double)t / SIM_CLKFREQ > limitSeconds) {
+    now = (unsigned long long)(limitSeconds * SIM_CLKFREQ);
+    exit(0);
+  }
+  while (physT + PHYS_STEP <= t) {
+    physT += PHYS_STEP;
+    _stepPhysics();
+  }
+  if (t > now) now = t;
+}
+
+static int _nextCog(int from)
+{
+  // Runnable cog with the earliest wake time, round robin on ties
+  int best = -1;
+  for (int k = 1; k <= MAX_COGS; k++) {
+    int i = (from + k) % MAX_COGS;
+    if (!cog[i].used || cog[i].spinning) continue;
+    if (best < 0 || cog[i].wake < cog[best].wake) best = i;
+  }
+  return best;
+}
+
+static void _handOff(int next)
+{
+  // Advance the clock to the next cog's wake time and pass it the baton
+  if (next < 0) {
+    current = -1;
+    return;
+  }
+  _advance(cog[next].wake);
+  current = next;
+  pthread_cond_signal(&cog[next].go);
+}
+
+static void _waitBaton()
+{
+  while (current != me) {
+    if (current < 0) current = me;
+    else pthread_cond_wait(&cog[me].go, &simLock);
+  }
+  if (cog[me].killed) {
+    cog[me].used = 0;
+    _handOff(_nextCog(me));
+    pthread_mutex_unlock(&simLock);
+    pthread_exit(0);
+  }
+}
+
+static void _yieldUntil(unsigned long long t)
+{
+  // Block the calling cog until virtual time t (simLock held)
+  cog[me].wake = t > now ? t : now;
+  int next = _nextCog(me);
+  if (next != me) {
+    _handOff(next);
+    _waitBaton();
+  } else {
+    _advance(cog[me].wake);
+  }
+}
+
+static void *_watchdog(void *arg)
+{
+  struct timespec poll = {0, SPIN_POLL_NS};
+  unsigned long lastCalls = 0;
+  int lastCog = -1;
+  int polls = 0;
+
+  while (1) {
+    nanosleep(&poll, 0);
+    pthread_mutex_lock(&simLock);
+    if (current >= 0) {
+      if (current == lastCog && cog[current].calls == lastCalls) {
+        if (++polls >= SPIN_POLLS) {
+          // Cog has not called in for a while: let it run free
+          cog[current].spinning = 1;
+          _handOff(_nextCog(current));
+          polls = 0;
+        }
+      } else {
+        polls = 0;
+      }
+      if (current >= 0) {
+        lastCog = current;
+        lastCalls = cog[current].calls;
+      }
+    } else {
+      // Only free-running cogs left, so the watchdog drives the clock
+      int next = _nextCog(0);
+      if (next >= 0 && cog[next].wake <= now + SPIN_ADVANCE) {
+        _handOff(next);
+      } else {
+        _advance(now + SPIN_ADVANCE);
+      }
+    }
+    pthread_mutex_unlock(&simLock);
+  }
+  return arg;
+}
+
+static void _start()
+{
+  // One-time setup, called with simLock held
+  char *s;
+  pthread_t wd;
+
+  started = 1;
+  clock_gettime(CLOCK_MONOTONIC, &wallStart);
+  cog[0].used = 1;
+  pthread_cond_init(&cog[0].go, 0);
+
+  if ((s = getenv("SIM_SECONDS")) != 0) limitSeconds = atof(s);
+  if ((s = getenv("SIM_SEED")) != 0) seed = (unsigned int)atoi(s);
+  if ((s = getenv("SIM_SLIP")) != 0) slip = atof(s);
+  if ((s = getenv("SIM_PING_NOISE")) != 0) pingNoise = atof(s);
+  if ((s = getenv("SIM_PING_CONE")) != 0) pingCone = atof(s)*M_PI/180.0;
+  if ((s = getenv("SIM_QUIET")) != 0) quiet = 1;
+  if ((s = getenv("SIM_POSE")) != 0) sscanf(s, "%lf,%lf,%lf", &pose[0], &pose[1], &pose[2]);
+
+  wheelL.scale = 1.0 + slip * _gauss();
+  wheelR.scale = 1.0 + slip * _gauss();
+
+  if (numSegs == 0) {
+    if ((s = getenv("SIM_WORLD")) != 0) {
+      if (!sim_loadWorld(s)) {
+        fprintf(stderr, "sim: cannot read world file %s\n", s);
+        exit(1);
+      }
+    } else {
+      // Default world: a 2.4 x 1.8 m room with two boxes in it
+      double room[] = {-400, -600, 2000, -600, 2000, 1200, -400, 1200};
+      double box1[] = {900, -250, 1100, -250, 1100, -50, 900, -50};
+      double box2[] = {1300, 500, 1500, 650, 1350, 850, 1200, 700};
+      sim_addPolygon(room, 4);
+      sim_addPolygon(box1, 4);
+      sim_addPolygon(box2, 4);
+    }
+  }
+
+  atexit(_summary);
+  pthread_create(&wd, 0, _watchdog, 0);
+  pthread_detach(wd);
+}
+
+static void _enter()
+{
+  // Every library call starts here: take the lock and the baton
+  pthread_mutex_lock(&simLock);
+  if (!started) _start();
+  if (cog[me].spinning) {
+    cog[me].spinning = 0;
+    cog[me].wake = now;
+    if (current == me) current = -1;
+  }
+  _waitBaton();
+  cog[me].calls++;
+}
+
+static void _leave()
+{
+  pthread_mutex_unlock(&simLock);
+}
+
+static void *_cogMain(void *arg)
+{
+  me = (int)(intptr_t)arg;
+  pthread_mutex_lock(&simLock);
+  _waitBaton();
+  pthread_mutex_unlock(&simLock);
+
+  cog[me].fn(cog[me].par);
+
+  pthread_mutex_lock(&simLock);
+  cog[me].used = 0;
+  _handOff(_nextCog(me));
+  pthread_mutex_unlock(&simLock);
+  return 0;
+}
+
+// ----------------------------------------------
+// World and ground truth.
+// ----------------------------------------------
+
+void sim_clearWorld()
+{
+  numSegs = 0;
+}
+
+void sim_addPolygon(const double *xy, int n)
+{
+  // Closed polygon, vertices as x0,y0,x1,y1,... in mm
+  for (int i = 0; i < n && numSegs < MAX_SEGS; i++) {
+    int j = (i + 1) % n;
+    seg[numSegs].x0 = xy[2*i];
+    seg[numSegs].y0 = xy[2*i+1];
+    seg[numSegs].x1 = xy[2*j];
+    seg[numSegs].y1 = xy[2*j+1];
+    numSegs++;
+  }
+}
+
+int sim_loadWorld(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[128];
+  double xy[2*64];
+  int n = 0;
+
+  if (!f) return 0;
+  sim_clearWorld();
+  while (fgets(line, sizeof(line), f)) {
+    double x, y;
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%lf %lf", &x, &y) == 2) {
+      if (n < 64) {
+        xy[2*n] = x;
+        xy[2*n+1] = y;
+        n++;
+      }
+    } else if (n > 0) {
+      sim_addPolygon(xy, n);
+      n = 0;
+    }
+  }
+  if (n > 0) sim_addPolygon(xy, n);
+  fclose(f);
+  return numSegs > 0;
+}
+
+double sim_castRay(double x, double y, double a, double maxRange)
+{
+  // Distance along heading a from (x,y) to the nearest wall
+  double dx = cos(a);
+  double dy = sin(a);
+  double best = maxRange;
+
+  for (int i = 0; i < numSegs; i++) {
+    double ex = seg[i].x1 - seg[i].x0;
+    double ey = seg[i].y1 - seg[i].y0;
+    double den = dx*ey - dy*ex;
+    if (fabs(den) < 1e-12) continue;
+    double wx = seg[i].x0 - x;
+    double wy = seg[i].y0 - y;
+    double t = (wx*ey - wy*ex) / den;
+    double u = (wx*dy - wy*dx) / den;
+    if (t >= 0.0 && u >= 0.0 && u <= 1.0 && t < best) best = t;
+  }
+  return best;
+}
+
+double sim_clearance(double x, double y)
+{
+  // Distance from (x,y) to the nearest wall
+  return _clearance(x, y);
+}
+
+void sim_setPose(double x, double y, double theta)
+{
+  pthread_mutex_lock(&simLock);
+  pose[0] = x;
+  pose[1] = y;
+  pose[2] = theta;
+  pthread_mutex_unlock(&simLock);
+}
+
+void sim_getPose(double p[3])
+{
+  pthread_mutex_lock(&simLock);
+  p[0] = pose[0];
+  p[1] = pose[1];
+  p[2] = pose[2];
+  pthread_mutex_unlock(&simLock);
+}
+
+void sim_defaultSlip(double sigma)
+{
+  // Only before the first library call: the wheels are drawn then, and
+  // SIM_SLIP still wins if it is set
+  pthread_mutex_lock(&simLock);
+  if (!started) slip = sigma;
+  pthread_mutex_unlock(&simLock);
+}
+
+int sim_collisions()
+{
+  return collisions;
+}
+
+double sim_seconds()
+{
+  return (double)now / SIM_CLKFREQ;
+}
+
+unsigned long long sim_clock()
+{
+  return now;
+}
+
+unsigned int sim_ns()
+{
+  // CPU time of this thread only: the other cogs' threads and the
+  // physics don't count. Kept to 32 bits, which wrap, as CNT does.
+  struct timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return (unsigned int)((unsigned long long)t.tv_sec * 1000000000ULL + (unsigned long long)t.tv_nsec);
+}
+
+// ----------------------------------------------
+// simpletools
+// ----------------------------------------------
+
+unsigned int sim_cnt()
+{
+  unsigned int t;
+  _enter();
+  _yieldUntil(now + CNT_COST);
+  t = (unsigned int)now;
+  _leave();
+  return t;
+}
+
+void waitcnt(unsigned int target)
+{
+  _enter();
+  _yieldUntil(now + (unsigned int)(target - (unsigned int)now));
+  _leave();
+}
+
+void pause(int time)
+{
+  _enter();
+  _yieldUntil(now + (unsigned long long)(time > 0 ? time : 0) * (SIM_CLKFREQ/1000));
+  _leave();
+}
+
+void freqout(int pin, int msTime, int frequency)
+{
+  _enter();
+  if ((pin == LEFT_IR_LED || pin == RIGHT_IR_LED) && frequency > 30000) {
+    irLit = pin;
+    irLitAt = now + (unsigned long long)msTime * (SIM_CLKFREQ/1000);
+  }
+  _yieldUntil(now + (unsigned long long)msTime * (SIM_CLKFREQ/1000));
+  _leave();
+}
+
+void high(int pin)
+{
+  _enter();
+  pinState |= 1u << (pin & 31);
+  _leave();
+}
+
+void low(int pin)
+{
+  _enter();
+  pinState &= ~(1u << (pin & 31));
+  _leave();
+}
+
+void toggle(int pin)
+{
+  _enter();
+  pinState ^= 1u << (pin & 31);
+  _leave();
+}
+
+int input(int pin)
+{
+  int led = pin == LEFT_IR_DET ? LEFT_IR_LED : pin == RIGHT_IR_DET ? RIGHT_IR_LED : -1;
+  int v;
+
+  _enter();
+  if (led >= 0) {
+    // Detector pulls low while it sees its own 38 kHz LED reflected
+    v = 1;
+    if (irLit == led && now <= irLitAt + SIM_CLKFREQ/1000) {
+      double side = led == LEFT_IR_LED ? 1.0 : -1.0;
+      double c = cos(pose[2]), s = sin(pose[2]);
+      double x = pose[0] + IR_FORWARD*c - side*IR_SIDE*s;
+      double y = pose[1] + IR_FORWARD*s + side*IR_SIDE*c;
+      if (_coneRange(x, y, pose[2] + side*IR_ANGLE, IR_CONE, IR_RANGE) < IR_RANGE) v = 0;
+    }
+  } else {
+    v = (pinState >> (pin & 31)) & 1;
+  }
+  _leave();
+  return v;
+}
+
+int print(const char *format, ...)
+{
+  int n = 0;
+  va_list args;
+  if (quiet) return 0;
+  va_start(args, format);
+  n = vprintf(format, args);
+  va_end(args);
+  return n;
+}
+
+int scan(const char *format, ...)
+{
+  int n;
+  va_list args;
+  fflush(stdout);
+  va_start(args, format);
+  n = vscanf(format, args);
+  va_end(args);
+  if (n == EOF) exit(0);
+  return n;
+}
+
+int cogstart(void (*function)(void *par), void *par, void *stack, size_t stacksize)
+{
+  int id = -1;
+
+  _enter();
+  for (int i = 1; i < MAX_COGS; i++) {
+    if (!cog[i].used) {
+      id = i;
+      break;
+    }
+  }
+  if (id > 0) {
+    cog[id].used = 1;
+    cog[id].killed = 0;
+    cog[id].spinning = 0;
+    cog[id].wake = now;
+    cog[id].fn = function;
+    cog[id].par = par;
+    cog[id].info[0] = id;
+    pthread_cond_init(&cog[id].go, 0);
+    pthread_create(&cog[id].thread, 0, _cogMain, (void *)(intptr_t)id);
+    pthread_detach(cog[id].thread);
+  }
+  _leave();
+  return id;
+}
+
+int *cog_run(void (*function)(void *par), int stacksize)
+{
+  int id = cogstart(function, 0, 0, stacksize);
+  return id > 0 ? cog[id].info : 0;
+}
+
+void cogstop(int id)
+{
+  _enter();
+  if (id > 0 && id < MAX_COGS && cog[id].used) {
+    cog[id].killed = 1;
+    if (cog[id].spinning) cog[id].used = 0;
+  }
+  _leave();
+  if (id == me) pause(0);
+}
+
+void cog_end(int *coginfo)
+{
+  if (coginfo) cogstop(coginfo[0]);
+}
+
+int cog_num(int *coginfo)
+{
+  return coginfo ? coginfo[0] : -1;
+}
+
+int cogid()
+{
+  return me;
+}
+
+// ----------------------------------------------
+// abdrive
+// ----------------------------------------------
+
+void drive_speed(int left, int right)
+{
+  _enter();
+  gotoActive = 0;
+  wheelL.target = left;
+  wheelR.target = right;
+  _leave();
+}
+
+void drive_ramp(int left, int right)
+{
+  // Ramp to speed and return once both wheels get there
+  _enter();
+  gotoActive = 0;
+  wheelL.target = left;
+  wheelR.target = right;
+  while (wheelL.speed != wheelL.target || wheelR.speed != wheelR.target)
+    _yieldUntil(now + PHYS_STEP);
+  _leave();
+}
+
+void drive_goto(int distLeft, int distRight)
+{
+  // Travel the requested ticks on each wheel, then stop. Blocks the caller.
+  int longest = abs(distLeft) > abs(distRight) ? abs(distLeft) : abs(distRight);
+
+  _enter();
+  if (longest > 0) {
+    wheelL.gotoPos = wheelL.pos + distLeft;
+    wheelR.gotoPos = wheelR.pos + distRight;
+    wheelL.gotoMax = (double)gotoSpeed * abs(distLeft) / longest;
+    wheelR.gotoMax = (double)gotoSpeed * abs(distRight) / longest;
+    gotoActive = 1;
+    while (gotoActive)
+      _yieldUntil(now + PHYS_STEP);
+  }
+  _leave();
+}
+
+void drive_getTicks(int *left, int *right)
+{
+  _enter();
+  *left = (int)floor(wheelL.pos);
+  *right = (int)floor(wheelR.pos);
+  _leave();
+}
+
+void drive_setMaxSpeed(int speed)
+{
+  _enter();
+  if (speed < 0) speed = -speed;
+  gotoSpeed = speed > WHEEL_MAX ? WHEEL_MAX : speed;
+  _leave();
+}
+
+void drive_setRampStep(int stepsize)
+{
+  _enter();
+  rampStep = stepsize > 0 ? stepsize : 1;
+  _leave();
+}
+
+// ----------------------------------------------
+// servo
+// ----------------------------------------------
+
+int servo_angle(int pin, int degreeTenths)
+{
+  _enter();
+  if (pin == PINGSERVO) {
+    if (degreeTenths < 0) degreeTenths = 0;
+    if (degreeTenths > 1800) degreeTenths = 1800;
+    servoCmd = degreeTenths;
+  }
+  _leave();
+  return pin;
+}
+
+int servo_set(int pin, int time)
+{
+  // Pulse width in us: 500 us is 0 degrees, 2500 us is 180 degrees
+  return servo_angle(pin, (time - 500) * 1800 / 2000);
+}
+
+int servo_setramp(int pin, int stepSize)
+{
+  return pin;
+}
+
+int servo_get(int pin)
+{
+  int a;
+  _enter();
+  a = pin == PINGSERVO ? (int)servoPos : 0;
+  _leave();
+  return a;
+}
+
+void servo_stop()
+{
+}
+
+// ----------------------------------------------
+// ping
+// ----------------------------------------------
+
+int ping(int pin)
+{
+  // Echo time in us for the nearest surface in the PING))) cone
+  int echo = PING_TIMEOUT;
+
+  _enter();
+  if (pin == PINGER) {
+    double beam = pose[2] + (servoPos - 900 - PINGBIAS) * M_PI / 1800.0;
+    double x = pose[0] + PINGOFFSET * cos(pose[2]);
+    double y = pose[1] + PINGOFFSET * sin(pose[2]);
+    double d = _coneRange(x, y, beam, pingCone, SIM_PING_MAX);
+    if (d < SIM_PING_MAX) {
+      d += pingNoise * 10.0 * _gauss();
+      if (d < 20.0) d = 20.0;
+      echo = (int)(d * 2.0 / 0.3432);
+    }
+  }
+  _yieldUntil(now + (unsigned long long)(750 + echo) * (SIM_CLKFREQ/1000000));
+  _leave();
+  return echo;
+}
+
+int ping_cm(int pin)
+{
+  return ping(pin) / 58;
+}
+
+int ping_inches(int pin)
+{
+  return ping(pin) / 148;
+}
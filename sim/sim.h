@@ -0,0 +1,59 @@
+//   Host-side simulation of the ActivityBot and its world
+//
+//   The headers in this directory (simpletools.h, abdrive.h, servo.h,
+//   ping.h) stand in for the Propeller libraries so the bot programs can
+//   be compiled and run on Linux. Everything runs against a virtual
+//   clock, so pause() costs nothing in wall time.
+//
+//   Build a program with the headers in sim/ ahead of the library ones:
+//     gcc -std=c99 -I sim -o TestMain TestMain.c move.c sense.c slam.c
+//         plan.c fixed.c odometry.c pid.c sched.c sim/sim.c -lm -lpthread
+//   Other programs take the .c files their .side lists; pt.c only if
+//   they run protothreads with ptAdd()/ptRun(), as PtBench does.
+//
+//   Environment variables read at startup:
+//     SIM_WORLD       file of polygons, one "x y" vertex (mm) per line,
+//                     polygons separated by a blank line
+//     SIM_POSE        starting pose "x,y,theta" (mm, mm, radians)
+//     SIM_SECONDS     simulated seconds to run before exiting (default 60)
+//     SIM_SEED        random seed for the noise models
+//     SIM_SLIP        wheel scale error, 1 sigma (e.g. 0.02 for 2%);
+//                     a program may set its own default with
+//                     sim_defaultSlip() before its first library call
+//     SIM_PING_NOISE  PING))) range noise, 1 sigma in cm
+//     SIM_PING_CONE   PING))) cone half angle in degrees (0 = one ray)
+//     SIM_QUIET       if set, print() output is discarded
+#ifndef _SIM_H_
+#define _SIM_H_
+
+// --- Robot geometry (mm)
+#define SIM_WHEEL_BASE    105.8   // Wheel spacing
+#define SIM_TICK_MM       3.25    // Encoder tick length
+#define SIM_BOT_RADIUS    65.0    // Collision radius of the chassis
+#define SIM_PING_MAX      3000.0  // Farthest echo PING))) will report
+
+// --- Clock
+#define SIM_CLKFREQ       80000000
+
+// --- World
+int    sim_loadWorld(const char *path);
+void   sim_clearWorld();
+void   sim_addPolygon(const double *xy, int n);
+double sim_castRay(double x, double y, double a, double maxRange);
+double sim_clearance(double x, double y);
+
+// --- Ground truth
+void   sim_setPose(double x, double y, double theta);
+void   sim_getPose(double pose[3]);
+void   sim_defaultSlip(double sigma);
+int    sim_collisions();
+
+// --- Virtual clock
+double sim_seconds();
+unsigned long long sim_clock();
+
+// --- Host CPU time of the calling thread in ns, modulo 2^32, for timing
+// --- code (see bench.h). Differences are right for spans under 4.29 s.
+unsigned int sim_ns();
+
+#endif
@@ -0,0 +1,46 @@
+//   Host stand-in for the Propeller simpletools library (see sim.h)
+#ifndef _SIM_SIMPLETOOLS_H_
+#define _SIM_SIMPLETOOLS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "sim.h"
+
+// --- Terminal control characters
+#define HOME    1
+#define CLS     16
+#define CLREOL  11
+#define CLRDN   12
+#define CR      13
+
+// --- System counter
+#define CNT      sim_cnt()
+#define CLKFREQ  SIM_CLKFREQ
+
+unsigned int sim_cnt();
+void waitcnt(unsigned int target);
+
+// --- Timing and I/O pins
+void pause(int time);
+void freqout(int pin, int msTime, int frequency);
+void high(int pin);
+void low(int pin);
+int  input(int pin);
+void toggle(int pin);
+
+// --- Terminal
+int print(const char *format, ...);
+int scan(const char *format, ...);
+
+// --- Cogs
+int *cog_run(void (*function)(void *par), int stacksize);
+void cog_end(int *coginfo);
+int  cog_num(int *coginfo);
+int  cogstart(void (*function)(void *par), void *par, void *stack, size_t stacksize);
+void cogstop(int id);
+int  cogid();
+
+#endif
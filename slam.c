@@ -13,19 +13,52 @@
   ==========  ====  ==================================================
   2015-12-01   1.0  Initial version of updatePose() 
   2015-12-02   1.1  Merge in coordinate transform functions
+  2026-10-17   1.2  Move updatePose() to fixed-point odometry, add setPose()
+  2026-10-17   1.3  Add log-odds occupancy grid
+  2026-10-17   1.4  Add sonar cone beam model
+  2026-10-17   1.5  Track the cells that change between wall and not-wall
+  2026-10-17   1.6  poseThread(): updatePose() as a protothread
 
 */
 #include <math.h>                             // Needed for sin(), cos (), atan2()
 
 #include "simpletools.h"                      // Include simpletools header
+#include "abdrive.h"                          // Include abdrive header
 
 #include "botports.h"                         // Ports in use for the ActivityBot
 #include "slam.h"                             // Function declarations
 #include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "odometry.h"                         // Fixed-point dead reckoning
+#include "pt.h"                               // Protothreads
 
 // --- ActivityBot current pose (x,y,theta)
 float botP[3];
 
+// --- Occupancy grid, two cells per byte. A nibble holds log-odds + 8,
+// --- so 8 is unknown, 0 is certainly free and 15 certainly occupied.
+#define MAP_HIT       2             // Log-odds added where a beam ends
+#define MAP_MISS      1             // Log-odds taken off cells it crosses
+#define MAP_ARC       1             // Log-odds added along the arc of a cone
+
+// --- The PING))) cone (about 30 degrees wide) as a fan of rays 15/16 degree
+// --- apart. coneMask[k] says which rays are in use at k cells out.
+#define CONE_RAYS     16            // Rays each side of the beam axis
+#define CONE_GAP      3             // Rings left alone in front of the arc
+#define CONE_STEP     11184811      // 15/16 degree, as a binary angle
+#define CONE_STEP_FX  1072          // ... and in Q16.16 radians
+#define CONE_RINGS    (MAP_RANGE / MAP_CELL + 2)
+
+unsigned char mapCells[MAP_SIZE * MAP_SIZE / 2];
+int mapDirty[4] = {0, 0, MAP_SIZE - 1, MAP_SIZE - 1};
+static unsigned int mapBeams = 0;   // Beams integrated since mapClear()
+static unsigned int mapCycles = 0;  // CNT ticks spent on them
+static int mapReady = 0;
+static int mapModel = MAP_MODEL_CONE;
+static unsigned int coneMask[CONE_RINGS];
+static int coneX[2*CONE_RAYS+1], coneY[2*CONE_RAYS+1];
+static int coneDX[2*CONE_RAYS+1], coneDY[2*CONE_RAYS+1];
+
 // --- Coordinate Transforms
 void aTb(float *aP, float *bP, float *b)
 {
@@ -51,43 +84,239 @@ void aTb_inv(float *aP, float *bP, float *b)
 }
 
 // --- Localization
+void setPose(float x, float y, float theta)
+{
+  // Place the ActivityBot at (x,y,theta) in the world coordinate frame
+  drive_getTicks(&ticksL, &ticksR);
+  odomReset(ticksL, ticksR, x, y, theta);
+  botP[0] = x;
+  botP[1] = y;
+  botP[2] = theta;
+}
+
 void updatePose()
 {
+  // Dead reckoning from the wheel encoders. The pose is integrated in
+  // fixed point (see odometry.c); botP[] is refreshed from it for the
+  // float code that uses it.
   int newL = 0;
   int newR = 0;
-  int deltaL, deltaR;
-
-  float R, omega_dt;
-  float ICC[2];
-  float L = 105.8;
-  float step = 3.25;
-  float X, Y;
 
   drive_getTicks(&newL, &newR);
-  deltaL = newL - ticksL;
-  deltaR = newR - ticksR;
+  odomUpdate(newL, newR);
+
+  botP[0] = odomGetX();
+  botP[1] = odomGetY();
+  botP[2] = odomGetTheta();
+
+  ticksL = newL;
+  ticksR = newR;
+  //print ("updatePose: ticksL = %d ticksR = %d%c\n", ticksL, ticksR, CLREOL);
+  //print ("updatePose: X = %f Y = %f theta = %f%c\n", botP[0], botP[1], botP[2], CLREOL);
+}
+
+int poseThread(pt *p)
+{
+  // updatePose() every POSE_MS as a protothread, for a cog shared with
+  // other threads: ptAdd(&p, poseThread)
+  PT_BEGIN(p);
+  while (1) {
+    updatePose();
+    PT_WAIT_NEXT(p, POSE_MS);
+  }
+  PT_END(p);
+}
+
+// --- Mapping
+void _mapAdd(int cx, int cy, int d)
+{
+  // Add d to the log-odds of cell (cx,cy), saturating at 0 and 15
+  // and noting it in mapDirty[] if it became or stopped being a wall
+  int i, shift, o, v;
+  unsigned char *b;
+
+  if ((unsigned int)cx >= MAP_SIZE || (unsigned int)cy >= MAP_SIZE) return;
+  i = (cy << MAP_SHIFT) | cx;
+  b = &mapCells[i >> 1];
+  shift = (i & 1) << 2;
+  o = (*b >> shift) & 15;
+  v = o + d;
+  if (v < 0) v = 0;
+  if (v > 15) v = 15;
+  *b = (*b & ~(15 << shift)) | (v << shift);
+
+  if ((o >= MAP_WALL) != (v >= MAP_WALL)) {
+    if (cx < mapDirty[0]) mapDirty[0] = cx;
+    if (cy < mapDirty[1]) mapDirty[1] = cy;
+    if (cx > mapDirty[2]) mapDirty[2] = cx;
+    if (cy > mapDirty[3]) mapDirty[3] = cy;
+  }
+}
+
+void _mapRay(int x0, int y0, int x1, int y1, int hit)
+{
+  // Walk from cell (x0,y0) to cell (x1,y1) with Bresenham's algorithm,
+  // marking the cells on the way free and the last one occupied if the
+  // beam got an echo from it.
+  int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+  int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+  int sx = x1 > x0 ? 1 : -1;
+  int sy = y1 > y0 ? 1 : -1;
+  int err = dx + dy;
+  int e2;
+
+  while (x0 != x1 || y0 != y1) {
+    _mapAdd(x0, y0, -MAP_MISS);
+    e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+  _mapAdd(x1, y1, hit ? MAP_HIT : -MAP_MISS);
+}
 
-  if (deltaL == deltaR) {
-    X = botP[0] + deltaL * step * cos(botP[2]);
-    Y = botP[1] + deltaL * step * sin(botP[2]);
-    omega_dt = 0.0;
+void _coneInit()
+{
+  // Ray j joins the fan at the first ring where the rays already in it
+  // are more than a cell apart, so each cell is touched about once. The
+  // centre ray and the two edges are in from the start.
+  for (int k = 0; k < CONE_RINGS; k++) {
+    coneMask[k] = 0;
+    for (int j = 0; j <= CONE_RAYS; j++) {
+      int g = (j == 0 || j == CONE_RAYS) ? 0 : (j & -j);
+      if (g == 0 || k * 2 * g * CONE_STEP_FX > FX_ONE) coneMask[k] |= 1 << j;
+    }
+  }
+}
 
+void _mapCone(int sx, int sy, unsigned int a, int r, int hit)
+{
+  // Inverse sensor model for the whole cone: PING))) reports the nearest
+  // surface anywhere in it, so the cone is free out to r, and one of the
+  // cells on the arc at r is occupied. The last CONE_GAP rings before the
+  // arc are left alone: rays that graze a wall at the edge of the cone
+  // would otherwise clear the wall's own cells. sx,sy are the sensor
+  // position in Q16.16 cells. The rays are stepped a cell at a time by
+  // adding their direction, so there are no multiplies.
+  int rings = (r + MAP_CELL/2) >> MAP_CELL_SHIFT;
+
+  for (int j = 0; j <= 2*CONE_RAYS; j++) {
+    unsigned int aj = a + (unsigned int)(j - CONE_RAYS) * CONE_STEP;
+    coneDX[j] = fx_cos(aj);
+    coneDY[j] = fx_sin(aj);
+    coneX[j] = sx;
+    coneY[j] = sy;
+  }
+  if (rings >= CONE_RINGS) rings = CONE_RINGS - 1;
+  if (rings == 0) {
+    _mapAdd((sx >> 16) + MAP_SIZE/2, (sy >> 16) + MAP_SIZE/2, hit ? MAP_ARC : -MAP_MISS);
+    return;
+  }
+
+  _mapAdd((sx >> 16) + MAP_SIZE/2, (sy >> 16) + MAP_SIZE/2, -MAP_MISS);
+  for (int k = 1; k <= rings; k++) {
+    unsigned int mask = coneMask[k];
+    int d = k < rings - CONE_GAP ? -MAP_MISS : k < rings ? 0 : (hit ? MAP_ARC : -MAP_MISS);
+    for (int j = 0; j <= 2*CONE_RAYS; j++) {
+      int n = j < CONE_RAYS ? CONE_RAYS - j : j - CONE_RAYS;
+      coneX[j] += coneDX[j];
+      coneY[j] += coneDY[j];
+      if (mask & (1 << n))
+        _mapAdd((coneX[j] >> 16) + MAP_SIZE/2, (coneY[j] >> 16) + MAP_SIZE/2, d);
+    }
+  }
+}
+
+void mapSetModel(int model)
+{
+  // MAP_MODEL_CONE (the default) or MAP_MODEL_RAY
+  mapModel = model;
+}
+
+void mapClear()
+{
+  // Forget everything: all cells unknown
+  for (int i = 0; i < MAP_SIZE * MAP_SIZE / 2; i++)
+    mapCells[i] = 0x88;
+  mapDirty[0] = 0;
+  mapDirty[1] = 0;
+  mapDirty[2] = MAP_SIZE - 1;
+  mapDirty[3] = MAP_SIZE - 1;
+  _coneInit();
+  mapReady = 1;
+  mapBeams = 0;
+  mapCycles = 0;
+}
+
+void mapBeam(int i)
+{
+  // Integrate beam i of the latest scan (scan_cm[i] at scanAngle[i]) at the
+  // current pose. Works in fixed point from the odometry pose, which
+  // botP[] mirrors.
+  unsigned int t = CNT;
+  int r = scan_cm[i] * 10;
+  int hit = r < MAP_RANGE;
+  unsigned int a = odomTheta + scanAngle[i] * BAM_PER_DEG;
+  int sx, sy, ex, ey;
+
+  if (r <= 0) return;                 // Beam not read yet
+  if (!mapReady) mapClear();
+  if (!hit) r = MAP_RANGE;
+
+  sx = odomX + PINGOFFSET * fx_cos(odomTheta);
+  sy = odomY + PINGOFFSET * fx_sin(odomTheta);
+
+  if (mapModel == MAP_MODEL_CONE) {
+    _mapCone(sx >> MAP_CELL_SHIFT, sy >> MAP_CELL_SHIFT, a, r, hit);
   } else {
-    R = (L/2.0) * (deltaR + deltaL) / (deltaR - deltaL);
-    omega_dt = (deltaR - deltaL) * step / L;
-    ICC[0] = botP[0] - R * sin(botP[2]);
-    ICC[1] = botP[1] + R * cos(botP[2]);
-    X = ICC[0] + (botP[0]-ICC[0])*cos(omega_dt) - (botP[1]-ICC[1])*sin(omega_dt);
-    Y = ICC[1] + (botP[0]-ICC[0])*sin(omega_dt) + (botP[1]-ICC[1])*cos(omega_dt);
+    // Q16.16 mm to cells, with (0,0) in the middle of the map
+    ex = sx + r * fx_cos(a);
+    ey = sy + r * fx_sin(a);
+    _mapRay((sx >> (16 + MAP_CELL_SHIFT)) + MAP_SIZE/2, (sy >> (16 + MAP_CELL_SHIFT)) + MAP_SIZE/2,
+            (ex >> (16 + MAP_CELL_SHIFT)) + MAP_SIZE/2, (ey >> (16 + MAP_CELL_SHIFT)) + MAP_SIZE/2, hit);
   }
 
-  botP[0] = X;
-  botP[1] = Y;
-  botP[2] += omega_dt;
+  mapCycles += CNT - t;
+  mapBeams++;
+}
 
-  ticksL = newL;
-  ticksR = newR;
-  //print ("updatePose: ticksL = %d ticksR = %d%c\n", ticksL, ticksR, CLREOL);
-  //print ("updatePose: deltaL = %d deltaR = %d%c\n", deltaL, deltaR, CLREOL);
-  //print ("updatePose: X = %f Y = %f theta = %f%c\n", botP[0], botP[1], botTheta, CLREOL);
+void mapScan()
+{
+  // Integrate every beam of the latest scan
+  for (int i = 0; i < numAngles; i++)
+    mapBeam(i);
+}
+
+int mapCell(int cx, int cy)
+{
+  // Log-odds of cell (cx,cy), -8 to +7. Cells off the map are unknown.
+  int i;
+  if (!mapReady || (unsigned int)cx >= MAP_SIZE || (unsigned int)cy >= MAP_SIZE) return 0;
+  i = (cy << MAP_SHIFT) | cx;
+  return ((mapCells[i >> 1] >> ((i & 1) << 2)) & 15) - 8;
+}
+
+int mapState(float x, float y)
+{
+  // MAP_FREE, MAP_UNKNOWN or MAP_OCCUPIED at world (x,y) in mm
+  int l = mapCell(((int)floor(x) >> MAP_CELL_SHIFT) + MAP_SIZE/2,
+                  ((int)floor(y) >> MAP_CELL_SHIFT) + MAP_SIZE/2);
+  if (l >= MAP_HIT) return MAP_OCCUPIED;
+  if (l <= -MAP_HIT) return MAP_FREE;
+  return MAP_UNKNOWN;
+}
+
+void mapBudget()
+{
+  // Report what the map costs in hub RAM and time
+  print("map: %d x %d cells of %d mm (%d m square), %d bytes + %d for the cone%c\n",
+        MAP_SIZE, MAP_SIZE, MAP_CELL, MAP_SIZE * MAP_CELL / 1000, (int)sizeof(mapCells),
+        (int)(sizeof(coneMask) + 4 * sizeof(coneX)), CLREOL);
+  print("map: %d beams, %d cycles per beam%c\n",
+        mapBeams, mapBeams ? mapCycles / mapBeams : 0, CLREOL);
 }
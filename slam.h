@@ -10,6 +10,46 @@ void aTb_inv(float *aP, float *bP, float *b);
 // --- Localization
 extern float botP[3];
 
+#define POSE_MS       20            // poseThread() period
+
+struct pt;
+
+void setPose(float x, float y, float theta);
 void updatePose();
+int  poseThread(struct pt *p);
+
+// --- Mapping
+//     Occupancy grid of MAP_SIZE x MAP_SIZE cells, each MAP_CELL mm square,
+//     with world (0,0) at the centre. Cells hold 4-bit log-odds.
+#define MAP_SHIFT     7             // log2(cells per side)
+#define MAP_SIZE      (1 << MAP_SHIFT)
+#define MAP_CELL_SHIFT 6            // log2(cell size in mm)
+#define MAP_CELL      (1 << MAP_CELL_SHIFT)
+#define MAP_RANGE     3000          // Longest PING))) range trusted (mm)
+
+#define MAP_MODEL_RAY  0            // Each beam is a single ray
+#define MAP_MODEL_CONE 1            // Each beam is a 30 degree cone
+
+#define MAP_FREE      0
+#define MAP_UNKNOWN   1
+#define MAP_OCCUPIED  2
+
+// --- The cells themselves, two to a byte: nibble = log-odds + 8. Cell
+// --- (cx,cy) is nibble (cy << MAP_SHIFT) | cx. Read it with mapCell()
+// --- unless you are in an inner loop.
+extern unsigned char mapCells[];
+#define MAP_WALL      (8 + 2)       // Nibble from which a cell is a wall
+
+// --- Box of cells (x0, y0, x1, y1) that became or stopped being walls
+// --- since whoever consumes it last reset it to empty (x0 > x1)
+extern int mapDirty[4];
+
+void mapClear();
+void mapSetModel(int model);
+void mapBeam(int i);
+void mapScan();
+int  mapCell(int cx, int cy);
+int  mapState(float x, float y);
+void mapBudget();
 
 #endif
@@ -0,0 +1,291 @@
+/*
+  vfh.c
+
+  Vector Field Histogram steering for the ActivityBot, after Ulrich and
+  Borenstein's VFH+. The PING))) scan in scanAngle[]/scan_cm[] is
+  already a polar view of what is around the bot; this turns it into a
+  heading that clears the clutter and comes as near the goal as it can,
+  and a speed to match.
+
+  ------------------------------------------------------------------------------
+  Copyright 2015 Robert B. Hawkins
+  Distributed under the MIT License
+  (see accompanying file LICENSE or copy at http://opensource.org/licenses/MIT)
+  ------------------------------------------------------------------------------
+
+  Date        Ver   Comments
+  ==========  ====  ==================================================
+  2026-10-17   1.0  Initial version
+
+  A sweep takes a second or more, and the bot may turn a long way in
+  that time, so each beam is kept as it lands (vfhAddBeam()) as a point
+  in the world frame. The histogram is rebuilt from the points each
+  tick, as seen from where the bot is now.
+
+  Each tick goes through four stages:
+
+  1. Density. An echo at r mm within VFH_WINDOW adds VFH_WINDOW - r to
+     its sector, and to the sectors either side that the bot's radius
+     (VFH_RADIUS) would sweep at that range, asin(VFH_RADIUS / r). The
+     histogram is then smoothed over five sectors (1 2 2 2 1 / 8).
+  2. Blocking. A sector is blocked once its density passes VFH_HIGH and
+     stays blocked until it drops under VFH_LOW, so the choice doesn't
+     flicker as the sweep refreshes. Sectors the scan doesn't cover are
+     blocked too: nothing is known about them.
+  3. Masking. Moving at speed the bot can't turn on the spot. An echo
+     inside the circle the bot would trace turning hard left (or right)
+     blocks everything beyond it on that side.
+  4. Selection. Each run of open sectors is a valley. A narrow valley
+     offers its middle; a wide one offers a heading VFH_WIDE/2 sectors
+     in from each edge, and the goal's heading if that is open. The
+     offer nearest the goal wins, with some weight on going straight
+     on and on the last choice to keep the steering smooth.
+
+  The enlargement table is built on first use. Apart from that a tick
+  costs a range and a bearing (sqrt() and atan2()) per beam held, and
+  integer work over the sectors.
+
+*/
+#include <math.h>                             // Needed for atan2(), sin(), cos()
+
+#include "simpletools.h"                      // Include simpletools header
+
+#include "botports.h"                         // Ports in use for the ActivityBot
+#include "sense.h"                            // Manage sensors in use on the ActivityBot
+#include "move.h"                             // Move the ActivityBot around
+#include "slam.h"                             // Localization, transforms, and Mapping
+#include "fixed.h"                            // Fixed-point arithmetic
+#include "vfh.h"                              // Function declarations
+
+#define VFH_AHEAD     (VFH_SECTORS / 2)       // Sector dead ahead
+#define VFH_SPREAD    (90 / VFH_STEP)         // Widest enlargement, sectors
+#define VFH_TURN_MAX  2.0                     // rad/s; hardest turn, for masking
+
+// --- Selection weights: off the goal, off dead ahead, off the last choice
+#define VFH_W_GOAL    5
+#define VFH_W_AHEAD   2
+#define VFH_W_LAST    2
+
+// --- A beam as it landed: echo (mm, world frame; r 0 if none) and the
+// --- direction the beam pointed, r -1 if not landed yet
+typedef struct {
+  short x, y, r;
+  unsigned int dir;
+} vfhEcho;
+
+int vfhDensity[VFH_SECTORS];
+unsigned char vfhBlocked[VFH_SECTORS];
+int vfhHeading = 0;
+
+// --- vfhSpreadAt[k]: the range (mm) inside which an echo's enlargement
+// --- reaches k sectors either side
+static int vfhSpreadAt[VFH_SPREAD + 1];
+static int vfhReady = 0;
+static int vfhLast = VFH_AHEAD;
+static vfhEcho vfhBeams[SCAN_MAX];
+static int vfhHeld = 0;
+
+// ----------------------------------------------
+// Local helper functions.
+// ----------------------------------------------
+
+void _vfhInit()
+{
+  vfhSpreadAt[0] = 0x7FFFFFFF;
+  for (int k = 1; k <= VFH_SPREAD; k++)
+    vfhSpreadAt[k] = VFH_RADIUS / sin(k * VFH_STEP * M_PI / 180.0);
+  vfhReady = 1;
+}
+
+int _vfhWrap(int s)
+{
+  return s < 0 ? s + VFH_SECTORS : s >= VFH_SECTORS ? s - VFH_SECTORS : s;
+}
+
+int _vfhSector(int deg)
+{
+  // Sector of a bot-frame angle in degrees
+  while (deg < -180) deg += 360;
+  while (deg >= 180) deg -= 360;
+  return _vfhWrap((deg + 180 + VFH_STEP / 2) / VFH_STEP);
+}
+
+int _vfhApart(int a, int b)
+{
+  // Sectors between a and b, the short way round
+  int d = a > b ? a - b : b - a;
+  return d > VFH_SECTORS / 2 ? VFH_SECTORS - d : d;
+}
+
+void _vfhHistogram(int range)
+{
+  // Stages 1 to 3: density, blocking and masking for the echoes nearer
+  // than range (mm)
+  int raw[VFH_SECTORS];
+  int lo = 0, hi = 0, seen = 0, left = 180, right = -180;
+  int turn = botSpeed * 13 / 4 / VFH_TURN_MAX;        // mm; radius of the hardest turn
+  unsigned int theta = bam_fromRadians(botP[2]);
+
+  for (int k = 0; k < VFH_SECTORS; k++)
+    raw[k] = 0;
+  for (int i = 0; i < vfhHeld; i++) {
+    vfhEcho *e = &vfhBeams[i];
+    int a = (int)(e->dir - theta) / BAM_PER_DEG, r, s, n = 0, x, y;
+    float dx, dy;
+    if (e->r < 0) continue;
+    if (!seen || a < lo) lo = a;
+    if (!seen || a > hi) hi = a;
+    seen = 1;
+    if (e->r == 0) continue;
+
+    // Where the echo is now, from the PING)))
+    dx = e->x - botP[0];
+    dy = e->y - botP[1];
+    r = sqrt(dx*dx + dy*dy) - PINGOFFSET;
+    a = round((atan2(dy, dx) - botP[2]) * 180.0 / M_PI);
+    if (r <= 0 || r >= VFH_WINDOW || r > range) continue;
+    while (n < VFH_SPREAD && r < vfhSpreadAt[n + 1]) n++;
+    s = _vfhSector(a);
+    for (int k = -n; k <= n; k++)
+      raw[_vfhWrap(s + k)] += VFH_WINDOW - r;
+
+    // Inside the hardest turn to the left or right?
+    x = PINGOFFSET + fx_mul(r, fx_cos(a * BAM_PER_DEG));
+    y = fx_mul(r, fx_sin(a * BAM_PER_DEG));
+    if (a > 0 && a < left && x*x + (y - turn)*(y - turn) < (turn + VFH_RADIUS)*(turn + VFH_RADIUS))
+      left = a;
+    if (a < 0 && a > right && x*x + (y + turn)*(y + turn) < (turn + VFH_RADIUS)*(turn + VFH_RADIUS))
+      right = a;
+  }
+
+  // Beams are VFH_STEP or more apart, so the scan covers half a beam
+  // spacing beyond each end; call that the next sector out.
+  lo -= VFH_STEP;
+  hi += VFH_STEP;
+  if (!seen) lo = hi = 999;
+  for (int k = 0; k < VFH_SECTORS; k++) {
+    int d = (raw[_vfhWrap(k - 2)] + 2 * raw[_vfhWrap(k - 1)] + 2 * raw[k]
+             + 2 * raw[_vfhWrap(k + 1)] + raw[_vfhWrap(k + 2)]) >> 3;
+    int a = (k - VFH_AHEAD) * VFH_STEP;
+    vfhDensity[k] = d;
+    if (d > VFH_HIGH) vfhBlocked[k] = 1;
+    else if (d < VFH_LOW) vfhBlocked[k] = 0;
+    if (a < lo || a > hi || a >= left || a <= right) vfhBlocked[k] = 1;
+  }
+}
+
+int _vfhCost(int s, int goal)
+{
+  return VFH_W_GOAL * _vfhApart(s, goal) + VFH_W_AHEAD * _vfhApart(s, VFH_AHEAD)
+         + VFH_W_LAST * _vfhApart(s, vfhLast);
+}
+
+// ----------------------------------------------
+// Functions intended to be called from outside.
+// ----------------------------------------------
+
+void vfhClear()
+{
+  // Forget the beams held, as after a long stop or a jump in the pose
+  vfhHeld = 0;
+}
+
+void vfhAddBeam(int i)
+{
+  // Keep beam i of scanAngle[]/scan_cm[], just landed (pingScanPoll()'s
+  // return; anything below 0 is ignored)
+  vfhEcho *e;
+  float a, r;
+  if (i < 0 || i >= SCAN_MAX) return;
+  while (vfhHeld <= i)
+    vfhBeams[vfhHeld++].r = -1;
+  e = &vfhBeams[i];
+  a = botP[2] + scanAngle[i] * M_PI / 180.0;
+  r = scan_cm[i] * 10;
+  e->dir = bam_fromRadians(a);
+  e->r = 0;
+  if (r <= 0 || r >= VFH_WINDOW) return;
+  r += PINGOFFSET;
+  e->x = botP[0] + r * cos(a);
+  e->y = botP[1] + r * sin(a);
+  e->r = r;
+}
+
+int vfhChoose(float goal[2])
+{
+  // Heading (degrees, bot frame) to steer for goal (x,y), or VFH_NONE if
+  // every direction the beams held cover is blocked
+  float dx = goal[0] - botP[0], dy = goal[1] - botP[1];
+  int bearing = round((atan2(dy, dx) - botP[2]) * 180.0 / M_PI);
+  int target = _vfhSector(bearing), start = -1, best = -1, cost = 0;
+
+  if (!vfhReady) _vfhInit();
+  _vfhHistogram(sqrt(dx*dx + dy*dy));
+
+  // Walk round from a blocked sector so no valley wraps past the start
+  for (int k = 0; k < VFH_SECTORS && start < 0; k++)
+    if (vfhBlocked[k]) start = k;
+  if (start < 0) {
+    best = target;
+  } else {
+    for (int i = 1, open = -1; i <= VFH_SECTORS; i++) {
+      int k = start + i, offer[3], n = 0;
+      if (!vfhBlocked[k % VFH_SECTORS] && i < VFH_SECTORS) {
+        if (open < 0) open = k;
+        continue;
+      }
+      if (open < 0) continue;
+
+      // Valley from open to k - 1
+      if (k - open >= VFH_WIDE) {
+        int t = target;
+        while (t < open) t += VFH_SECTORS;
+        offer[n++] = open + VFH_WIDE / 2;
+        offer[n++] = k - 1 - VFH_WIDE / 2;
+        if (t >= offer[0] && t <= offer[1]) offer[n++] = t;
+      } else {
+        offer[n++] = (open + k - 1) / 2;
+      }
+      for (int j = 0; j < n; j++) {
+        int s = offer[j] % VFH_SECTORS, c = _vfhCost(s, target);
+        if (best < 0 || c < cost) {
+          best = s;
+          cost = c;
+        }
+      }
+      open = -1;
+    }
+  }
+
+  if (best < 0) return VFH_NONE;
+  vfhLast = best;
+  vfhHeading = (best - VFH_AHEAD) * VFH_STEP;
+  return vfhHeading;
+}
+
+void vfhSteer(float goal[2])
+{
+  // Choose a heading for goal (x,y) and drive for it: fast where it's
+  // open and straight ahead, slowing with the density in that direction
+  // (to half speed at most, since an open sector is under VFH_HIGH) and
+  // with how far the bot has to turn. With nowhere open, turn on the
+  // spot toward the goal.
+  float dx = goal[0] - botP[0], dy = goal[1] - botP[1];
+  float d = sqrt(dx*dx + dy*dy), v, omega;
+  int h = vfhChoose(goal), a;
+
+  if (h == VFH_NONE) {
+    float e = atan2(dy, dx) - botP[2];
+    while (e > M_PI) e -= M_2PI;
+    while (e < -M_PI) e += M_2PI;
+    botSetVW(0.0, e < 0 ? -VFH_TURN_MAX : VFH_TURN_MAX);
+    return;
+  }
+  a = h < 0 ? -h : h;
+  omega = VFH_K_TURN * h * M_PI / 180.0;
+  v = vfhDensity[_vfhSector(h)];
+  v = v < 2 * VFH_HIGH ? VFH_SPEED * (2 * VFH_HIGH - v) / (2 * VFH_HIGH) : 0.0;
+  v = a < 90 ? v * (90 - a) / 90 : 0.0;
+  if (v > d) v = d;
+  botSetVW(v, omega);
+}
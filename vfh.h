@@ -0,0 +1,32 @@
+//   Vector Field Histogram (VFH+) steering for the ActivityBot
+//
+//   Turns the latest PING))) scan into a polar histogram of obstacle
+//   density around the bot, and picks the open direction nearest the
+//   goal. The bot steers around clutter on the move instead of stopping
+//   to turn. Pass each beam to vfhAddBeam() as pingScanPoll() lands it.
+#ifndef _VFH_H_
+#define _VFH_H_
+
+#define VFH_STEP      5             // Degrees per sector
+#define VFH_SECTORS   (360 / VFH_STEP)
+#define VFH_WINDOW    1000          // mm; echoes farther off don't count
+#define VFH_RADIUS    120           // mm; bot radius plus clearance
+#define VFH_HIGH      600           // Density above which a sector is blocked...
+#define VFH_LOW       400           // ... and below which it is open again
+#define VFH_WIDE      8             // Sectors in a valley wide enough to skirt one side
+#define VFH_SPEED     150.0         // mm/s in the clear
+#define VFH_K_TURN    2.0           // 1/s, turn rate per radian off the chosen heading
+#define VFH_NONE      -999          // No open direction
+
+// --- The last histogram (bot frame, sector 0 is dead astern and
+// --- VFH_SECTORS/2 dead ahead) and the chosen heading (degrees)
+extern int vfhDensity[VFH_SECTORS];
+extern unsigned char vfhBlocked[VFH_SECTORS];
+extern int vfhHeading;
+
+void vfhClear();
+void vfhAddBeam(int i);
+int  vfhChoose(float goal[2]);
+void vfhSteer(float goal[2]);
+
+#endif